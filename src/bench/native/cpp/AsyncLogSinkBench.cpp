@@ -0,0 +1,71 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include "bench.h"
+#include "llvm/raw_ostream.h"
+#include "support/AsyncLogSink.h"
+#include "support/BinaryLog.h"
+#include "support/Logger.h"
+
+namespace {
+
+constexpr int kBursts = 100;
+constexpr int kBurst = 1000;
+
+// Time spent in the logging thread per WPI_INFO call, logging in bursts
+// that fit in the ring.  flush() runs between bursts and is not timed.
+template <typename Log, typename Flush>
+void Run(const char* name, Log log, Flush flush) {
+  std::chrono::steady_clock::duration elapsed{0};
+  for (int b = 0; b < kBursts; ++b) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBurst; ++i) log(i);
+    elapsed += std::chrono::steady_clock::now() - start;
+    flush();
+  }
+  wpi::bench::Report(name, kBursts * kBurst, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(AsyncLogSink) {
+  // synchronous: format and write to a file on the calling thread
+  FILE* file = tmpfile();
+  if (!file) return;
+  llvm::raw_fd_ostream os(fileno(file), false, true);
+  wpi::Logger syncLogger(
+      [&](unsigned int, const char* file, unsigned int line, const char* msg) {
+        os << file << ':' << line << ": " << msg << '\n';
+        os.flush();
+      });
+  Run("synchronous LogFunc",
+      [&](int i) {
+        WPI_INFO(syncLogger, "sensor " << i << " value " << i * 0.5);
+      },
+      [] {});
+
+  wpi::AsyncLogSink::Options options;
+  options.ringCapacity = kBurst;
+  wpi::AsyncLogSink sink(wpi::AsyncLogSink::StreamWriter(os), options);
+  wpi::Logger asyncLogger(sink.GetLogFunc());
+  Run("AsyncLogSink WPI_INFO",
+      [&](int i) {
+        WPI_INFO(asyncLogger, "sensor " << i << " value " << i * 0.5);
+      },
+      [&] { sink.Flush(); });
+  Run("AsyncLogSink WPI_BLOG",
+      [&](int i) {
+        WPI_BLOG(sink, wpi::WPI_LOG_INFO, "sensor {} value {}", i, i * 0.5);
+      },
+      [&] { sink.Flush(); });
+  sink.Stop();
+  fclose(file);
+}
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/ConcurrentSlotMap.h"
+#include "support/SlotMap.h"
+#include "support/mutex.h"
+
+namespace {
+
+constexpr int kHandles = 1024;
+constexpr int kLookups = 1000000;
+
+// Each thread performs kLookups / threads lookups over a table of kHandles
+// elements.
+template <typename Lookup>
+void Run(const char* label, int threads, Lookup lookup) {
+  int per = kLookups / threads;
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      int64_t sum = 0;
+      for (int j = 0; j < per; ++j) sum += lookup((j + t) % kHandles);
+      if (sum == -1) std::abort();
+    });
+  }
+  for (auto& thr : workers) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(threads);
+  name += 'T';
+  wpi::bench::Report(name, per * threads, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(ConcurrentSlotMap) {
+  wpi::ConcurrentSlotMap<int> concurrent;
+  std::vector<uint64_t> concurrentHandles;
+  wpi::SlotMap<int> locked;
+  wpi::mutex mutex;
+  std::vector<uint64_t> lockedHandles;
+  for (int i = 0; i < kHandles; ++i) {
+    concurrentHandles.push_back(concurrent.emplace(i));
+    lockedHandles.push_back(locked.emplace(i));
+  }
+
+  for (int threads : {1, 2, 4, 8}) {
+    Run("ConcurrentSlotMap", threads, [&](int i) {
+      int v = 0;
+      concurrent.Read(concurrentHandles[i], [&](int x) { v = x; });
+      return v;
+    });
+    Run("SlotMap + wpi::mutex", threads, [&](int i) {
+      std::lock_guard<wpi::mutex> lock(mutex);
+      return *locked.get(lockedHandles[i]);
+    });
+  }
+}
@@ -0,0 +1,63 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/Metrics.h"
+
+namespace {
+
+constexpr int kRecords = 1000000;
+
+template <typename F>
+void Run(const char* label, int threads, F record) {
+  int per = kRecords / threads;
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&] {
+      for (int i = 0; i < per; ++i) record(i);
+    });
+  }
+  for (auto& thr : workers) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(threads);
+  name += 'T';
+  wpi::bench::Report(name, per * threads, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(Metrics) {
+  for (int threads : {1, 4}) {
+    wpi::MetricCounter counter;
+    Run("MetricCounter::Add", threads, [&](int) { counter.Add(); });
+
+    wpi::LatencyHistogram hist;
+    Run("LatencyHistogram::Record", threads,
+        [&](int i) { hist.Record(static_cast<uint64_t>(i) * 37); });
+
+    Run("ScopedLatency (disabled)", threads,
+        [&](int) { wpi::ScopedLatency timer(hist); });
+    wpi::MetricsRegistry::EnableInstrumentation(true);
+    Run("ScopedLatency (enabled)", threads,
+        [&](int) { wpi::ScopedLatency timer(hist); });
+    wpi::MetricsRegistry::EnableInstrumentation(false);
+  }
+
+  wpi::LatencyHistogram hist;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 1000; ++i) hist.Snapshot();
+  wpi::bench::Report("LatencyHistogram::Snapshot", 1000,
+                     std::chrono::steady_clock::now() - start);
+}
@@ -0,0 +1,83 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/priority_mutex.h"
+
+#ifdef WPI_HAVE_PRIORITY_MUTEX
+
+#include <pthread.h>
+
+namespace {
+
+constexpr int kIterations = 1000000;
+
+// The previous priority_mutex implementation: a glibc PTHREAD_PRIO_INHERIT
+// mutex, always locked through pthread_mutex_lock.
+class PthreadPIMutex {
+ public:
+  PthreadPIMutex() {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&m_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+  }
+  ~PthreadPIMutex() { pthread_mutex_destroy(&m_mutex); }
+
+  void lock() { pthread_mutex_lock(&m_mutex); }
+  void unlock() { pthread_mutex_unlock(&m_mutex); }
+
+ private:
+  pthread_mutex_t m_mutex;
+};
+
+// Each thread takes the lock kIterations / threads times and increments a
+// shared counter.
+template <typename Mutex>
+void Run(const char* label, int threads) {
+  Mutex mutex;
+  uint64_t counter = 0;
+  int per = kIterations / threads;
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&] {
+      for (int j = 0; j < per; ++j) {
+        std::lock_guard<Mutex> lock(mutex);
+        ++counter;
+      }
+    });
+  }
+  for (auto& thr : workers) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(threads);
+  name += 'T';
+  wpi::bench::Report(name, per * threads, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(Mutex) {
+  for (int threads : {1, 2, 4, 8}) {
+    Run<wpi::priority_mutex>("priority_mutex (futex)", threads);
+    Run<PthreadPIMutex>("pthread PI mutex", threads);
+    Run<std::mutex>("std::mutex", threads);
+  }
+}
+
+#endif  // WPI_HAVE_PRIORITY_MUTEX
@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/ConcurrentQueue.h"
+#include "support/MPMCQueue.h"
+
+namespace {
+
+constexpr int kItemsPerProducer = 200000;
+
+// Runs producers and consumers against the same queue; every producer pushes
+// kItemsPerProducer items and the consumers split the total evenly.
+template <typename Queue>
+void RunContention(const char* label, Queue& queue, int producers,
+                   int consumers) {
+  int total = producers * kItemsPerProducer;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < producers; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kItemsPerProducer; ++j) queue.push(j);
+    });
+  }
+  for (int i = 0; i < consumers; ++i) {
+    int count = total / consumers + (i < total % consumers ? 1 : 0);
+    threads.emplace_back([&queue, count] {
+      for (int j = 0; j < count; ++j) queue.pop();
+    });
+  }
+  for (auto& thr : threads) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(producers);
+  name += 'P';
+  name += std::to_string(consumers);
+  name += 'C';
+  wpi::bench::Report(name, total, elapsed);
+}
+
+void RunBoth(int producers, int consumers) {
+  {
+    wpi::ConcurrentQueue<int> queue;
+    RunContention("ConcurrentQueue", queue, producers, consumers);
+  }
+  {
+    wpi::MPMCQueue<int> queue(1024);
+    RunContention("MPMCQueue", queue, producers, consumers);
+  }
+}
+
+}  // namespace
+
+WPI_BENCHMARK(QueueContention) {
+  RunBoth(1, 1);
+  RunBoth(2, 2);
+  RunBoth(4, 1);
+  RunBoth(4, 4);
+  RunBoth(8, 8);
+}
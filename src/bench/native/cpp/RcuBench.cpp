@@ -0,0 +1,92 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/Rcu.h"
+#include "support/SeqLock.h"
+#include "support/mutex.h"
+
+namespace {
+
+constexpr int kReads = 1000000;
+
+struct State {
+  double x, y, heading;
+  int64_t timestamp;
+};
+
+// Each reader does kReads / threads reads while one writer publishes
+// continuously.
+template <typename Read, typename Write>
+void Run(const char* label, int threads, Read read, Write write) {
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    int64_t i = 0;
+    while (!done) {
+      write(++i);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  int per = kReads / threads;
+  std::atomic<int64_t> sink{0};
+  std::vector<std::thread> readers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    readers.emplace_back([&] {
+      int64_t sum = 0;
+      for (int j = 0; j < per; ++j) sum += read();
+      sink += sum;
+    });
+  }
+  for (auto& thr : readers) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  done = true;
+  writer.join();
+
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(threads);
+  name += 'T';
+  wpi::bench::Report(name, per * threads, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(Rcu) {
+  for (int threads : {1, 2, 4, 8}) {
+    wpi::SeqLock<State> seq;
+    Run("SeqLock", threads, [&] { return seq.Load().timestamp; },
+        [&](int64_t i) { seq.Store(State{0, 0, 0, i}); });
+
+    wpi::RcuPtr<State> rcu(std::unique_ptr<State>(new State()));
+    Run("RcuPtr", threads,
+        [&] { return rcu.Read([](const State* s) { return s->timestamp; }); },
+        [&](int64_t i) {
+          rcu.Store(std::unique_ptr<State>(new State{0, 0, 0, i}));
+        });
+
+    wpi::mutex mutex;
+    State state{};
+    Run("wpi::mutex", threads,
+        [&] {
+          std::lock_guard<wpi::mutex> lock(mutex);
+          return state.timestamp;
+        },
+        [&](int64_t i) {
+          std::lock_guard<wpi::mutex> lock(mutex);
+          state.timestamp = i;
+        });
+  }
+}
@@ -0,0 +1,66 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "support/mutex.h"
+#include "support/shared_mutex.h"
+
+namespace {
+
+constexpr int kReadsPerThread = 1000000;
+
+// Adapts an exclusive mutex to the shared interface, for comparison.
+struct ExclusiveAsShared {
+  wpi::mutex mutex;
+  void lock_shared() { mutex.lock(); }
+  void unlock_shared() { mutex.unlock(); }
+};
+
+// Read-only workload: each thread takes the shared lock kReadsPerThread
+// times to read a small table.
+template <typename Mutex>
+void RunReaders(const char* label, int threads) {
+  Mutex mutex;
+  int table[16] = {0};
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      int sum = 0;
+      for (int j = 0; j < kReadsPerThread; ++j) {
+        wpi::shared_lock<Mutex> lock(mutex);
+        sum += table[(i + j) & 15];
+      }
+      if (sum == -1) table[0] = sum;  // keep the reads live
+    });
+  }
+  for (auto& thr : workers) thr.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::string name{label};
+  name += ' ';
+  name += std::to_string(threads);
+  name += 'R';
+  wpi::bench::Report(name, static_cast<uint64_t>(threads) * kReadsPerThread,
+                     elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(SharedMutex) {
+  for (int threads : {1, 2, 4, 8}) {
+    RunReaders<wpi::shared_mutex>("shared_mutex", threads);
+    RunReaders<ExclusiveAsShared>("wpi::mutex", threads);
+  }
+}
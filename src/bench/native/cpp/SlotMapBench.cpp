@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "bench.h"
+#include "support/SlotMap.h"
+#include "support/UidVector.h"
+
+namespace {
+
+constexpr int kLive = 100000;
+constexpr int kChurn = 1000000;
+
+// Fills the container, frees half of it, then erases and re-adds one
+// element per operation with a large freelist.
+template <typename Emplace, typename Erase, typename Handle>
+void Churn(const char* name, Emplace emplace, Erase erase, Handle) {
+  std::vector<Handle> handles;
+  for (int i = 0; i < kLive; ++i) handles.push_back(emplace(i));
+  for (int i = 0; i < kLive; i += 2) erase(handles[i]);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kChurn; ++i) {
+    size_t pos = (i * 2 + 1) % kLive;
+    erase(handles[pos]);
+    handles[pos] = emplace(i);
+  }
+  wpi::bench::Report(name, kChurn, std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(SlotMap) {
+  wpi::UidVector<std::shared_ptr<int>, 16> vec;
+  Churn("UidVector erase+emplace",
+        [&](int i) { return vec.emplace_back(std::make_shared<int>(i)); },
+        [&](size_t uid) { vec.erase(uid); }, size_t());
+
+  wpi::SlotMap<std::shared_ptr<int>, 16> map;
+  Churn("SlotMap erase+emplace",
+        [&](int i) { return map.emplace(std::make_shared<int>(i)); },
+        [&](uint64_t h) { map.erase(h); }, uint64_t());
+}
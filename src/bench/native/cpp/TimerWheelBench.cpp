@@ -0,0 +1,47 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "support/TimerWheel.h"
+
+namespace {
+
+constexpr int kTimers = 500000;
+
+}  // namespace
+
+// Schedules, cancels half of, and expires the rest of a large set of timers
+// spread over ten minutes at 1 ms resolution.
+WPI_BENCHMARK(TimerWheel) {
+  wpi::TimerWheel wheel(0);
+  std::vector<wpi::TimerWheel::TimerId> ids(kTimers);
+  std::vector<uint64_t> deadlines(kTimers);
+  std::srand(42);
+  for (auto& deadline : deadlines)
+    deadline = (static_cast<uint64_t>(std::rand()) * 1000) % 600000000;
+  uint64_t fired = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kTimers; ++i)
+    ids[i] = wheel.Schedule(deadlines[i], 0, [&fired] { ++fired; });
+  auto scheduled = std::chrono::steady_clock::now();
+  for (int i = 0; i < kTimers; i += 2) wheel.Cancel(ids[i]);
+  auto cancelled = std::chrono::steady_clock::now();
+  for (uint64_t now = 0; !wheel.empty(); now += 1000)
+    wheel.Advance(now, [](wpi::TimerWheel::Callback& cb, bool) { cb(); });
+  auto expired = std::chrono::steady_clock::now();
+
+  wpi::bench::Report("TimerWheel schedule", kTimers, scheduled - start);
+  wpi::bench::Report("TimerWheel cancel", kTimers / 2, cancelled - scheduled);
+  wpi::bench::Report("TimerWheel expire (1ms ticks)", fired,
+                     expired - cancelled);
+}
@@ -0,0 +1,46 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <chrono>
+
+#include "bench.h"
+#include "support/timestamp.h"
+
+namespace {
+
+constexpr int kCalls = 10000000;
+
+// keeps the calls from being optimized away
+volatile uint64_t sink;
+
+template <typename F>
+void Run(const char* name, F now) {
+  uint64_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kCalls; ++i) sum += now();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  wpi::bench::Report(name, kCalls, elapsed);
+  sink = sum;
+}
+
+}  // namespace
+
+WPI_BENCHMARK(Timestamp) {
+  Run("steady_clock::now", [] {
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+  });
+  Run("NowDefault", [] { return wpi::NowDefault(); });
+  Run("Now (default)", [] { return wpi::Now(); });
+  Run("NowNs", [] { return wpi::NowNs(); });
+  Run("NowTsc", [] { return wpi::NowTsc(); });
+  wpi::SetNowImpl(wpi::NowTsc);
+  Run("Now (NowTsc)", [] { return wpi::Now(); });
+  wpi::SetNowImpl(nullptr);
+}
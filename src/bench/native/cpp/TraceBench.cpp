@@ -0,0 +1,42 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#define WPI_ENABLE_TRACING
+
+#include <chrono>
+
+#include "bench.h"
+#include "llvm/raw_ostream.h"
+#include "support/Trace.h"
+
+namespace {
+
+constexpr int kSpans = 1000000;
+
+void Run(const char* name) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kSpans; ++i) WPI_TRACE_SCOPE("bench");
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  wpi::bench::Report(name, kSpans, elapsed);
+}
+
+}  // namespace
+
+WPI_BENCHMARK(Trace) {
+  Run("WPI_TRACE_SCOPE not recording");
+
+  llvm::raw_null_ostream os;
+  wpi::TraceRecorder::Options options;
+  options.ringCapacity = 65536;
+  options.exportInterval = std::chrono::milliseconds(1);
+  wpi::TraceRecorder recorder(os, options);
+  recorder.Start();
+  Run("WPI_TRACE_SCOPE recording");
+  recorder.Stop();
+  if (uint64_t dropped = recorder.GetDropped())
+    llvm::outs() << "  (" << dropped << " spans dropped)\n";
+}
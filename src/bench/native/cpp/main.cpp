@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "llvm/Format.h"
+
+using namespace wpi::bench;
+
+static std::vector<std::pair<const char*, BenchFunc>>& GetBenchmarks() {
+  static std::vector<std::pair<const char*, BenchFunc>> benchmarks;
+  return benchmarks;
+}
+
+void wpi::bench::Register(const char* name, BenchFunc func) {
+  GetBenchmarks().emplace_back(name, func);
+}
+
+void wpi::bench::Report(llvm::StringRef name, uint64_t ops,
+                        std::chrono::steady_clock::duration elapsed) {
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  double perOp = ops > 0 ? ns / ops : 0.0;
+  double opsPerSec = ns > 0 ? ops * 1e9 / ns : 0.0;
+  llvm::outs() << llvm::format("%-48s %10.1f ns/op %14.0f ops/s\n",
+                               name.str().c_str(), perOp, opsPerSec);
+  llvm::outs().flush();
+}
+
+// Usage: wpiutilBench [filter...]
+// Runs every benchmark whose name contains one of the filter strings, or all
+// benchmarks if no filter is given.
+int main(int argc, char** argv) {
+  for (auto&& bench : GetBenchmarks()) {
+    llvm::StringRef name{bench.first};
+    bool run = argc < 2;
+    for (int i = 1; i < argc; ++i) {
+      if (name.find(argv[i]) != llvm::StringRef::npos) run = true;
+    }
+    if (!run) continue;
+    llvm::outs() << "== " << name << '\n';
+    bench.second();
+  }
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_BENCH_H_
+#define WPIUTIL_BENCH_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "llvm/StringRef.h"
+#include "llvm/raw_ostream.h"
+
+namespace wpi {
+namespace bench {
+
+typedef void (*BenchFunc)();
+
+// Registers a benchmark to be run by the benchmark executable.
+void Register(const char* name, BenchFunc func);
+
+// Reports a single result line: name, per-operation time, and throughput.
+void Report(llvm::StringRef name, uint64_t ops,
+            std::chrono::steady_clock::duration elapsed);
+
+struct Registrar {
+  Registrar(const char* name, BenchFunc func) { Register(name, func); }
+};
+
+}  // namespace bench
+}  // namespace wpi
+
+// Defines a benchmark.  The body runs once and is responsible for timing and
+// calling wpi::bench::Report().
+#define WPI_BENCHMARK(name)                                              \
+  static void WPI_bench_##name();                                        \
+  static ::wpi::bench::Registrar WPI_bench_reg_##name{#name,             \
+                                                       WPI_bench_##name}; \
+  static void WPI_bench_##name()
+
+#endif  // WPIUTIL_BENCH_H_
@@ -0,0 +1,44 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+// wpilogdecode: prints a binary log written by AsyncLogSink::BinaryWriter as
+// text.
+//
+// Usage: wpilogdecode <file>
+
+#include <stdio.h>
+
+#include <string>
+
+#include "llvm/raw_ostream.h"
+#include "support/BinaryLog.h"
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    llvm::errs() << "usage: " << argv[0] << " <file>\n";
+    return 2;
+  }
+
+  FILE* file = fopen(argv[1], "rb");
+  if (!file) {
+    llvm::errs() << argv[1] << ": could not open\n";
+    return 1;
+  }
+  std::string data;
+  char buf[4096];
+  size_t count;
+  while ((count = fread(buf, 1, sizeof(buf), file)) > 0)
+    data.append(buf, count);
+  fclose(file);
+
+  if (!wpi::DecodeBinaryLog(data, llvm::outs())) {
+    llvm::outs().flush();
+    llvm::errs() << argv[1] << ": not a binary log or truncated\n";
+    return 1;
+  }
+  return 0;
+}
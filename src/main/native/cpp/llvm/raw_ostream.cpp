@@ -267,6 +267,12 @@ void raw_ostream::flush_nonempty() {
   write_impl(OutBufStart, Length);
 }
 
+void raw_ostream::writev_impl(const char *Buffered, size_t BufferedSize,
+                              const char *Ptr, size_t Size) {
+  write_impl(Buffered, BufferedSize);
+  write_impl(Ptr, Size);
+}
+
 raw_ostream &raw_ostream::write(unsigned char C) {
   // Group exceptional cases into a single branch.
   if (LLVM_UNLIKELY(OutBufCur >= OutBufEnd)) {
@@ -318,6 +324,15 @@ raw_ostream &raw_ostream::write(const char *Ptr, size_t Size) {
       return *this;
     }
 
+    // If the string would not fit in an empty buffer either, write the
+    // buffered data and the string together.
+    if (Size >= size_t(OutBufEnd - OutBufStart)) {
+      size_t Length = OutBufCur - OutBufStart;
+      OutBufCur = OutBufStart;
+      writev_impl(OutBufStart, Length, Ptr, Size);
+      return *this;
+    }
+
     // We don't have enough space in the buffer to fit the string in. Insert as
     // much as possible, flush and start over with the remainder.
     copy_to_buffer(Ptr, NumBytes);
@@ -0,0 +1,408 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/AsyncLogSink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "llvm/Format.h"
+#include "support/SPSCQueue.h"
+#include "support/condition_variable.h"
+#include "support/mutex.h"
+#include "support/timestamp.h"
+
+using namespace wpi;
+
+constexpr size_t AsyncLogSink::kMaxMessage;
+
+namespace {
+
+// A ring slot.  Slots are preallocated, so logging a pre-formatted message
+// doesn't allocate.
+struct Entry {
+  uint64_t time = 0;
+  unsigned int level = 0;
+  const char* file = nullptr;
+  unsigned int line = 0;
+  size_t length = 0;
+  char text[AsyncLogSink::kMaxMessage];
+  AsyncLogSink::Formatter format;  // if set, text is unused
+  const BinaryLogSite* site = nullptr;  // if set, text holds encoded args
+};
+
+std::atomic<uint64_t> nextSinkId{1};
+
+}  // namespace
+
+struct AsyncLogSink::Ring {
+  Ring(std::thread::id owner_, size_t capacity)
+      : owner(owner_), queue(capacity) {}
+
+  std::thread::id owner;
+  SPSCQueue<Entry> queue;
+  std::atomic<uint64_t> dropped{0};  // written only by the owning thread
+  uint64_t reported = 0;             // drops already reported; drain only
+  std::atomic<bool> busy{false};     // owner is between reserve and commit
+};
+
+// State shared by the sink, its drain thread, and logging threads.
+struct AsyncLogSink::Shared {
+  Shared(Writer writer_, const Options& options_)
+      : id(nextSinkId.fetch_add(1, std::memory_order_relaxed)),
+        options(options_),
+        writer(std::move(writer_)) {}
+
+  const uint64_t id;
+  const Options options;
+  Writer writer;  // only called by the drain thread
+
+  std::atomic<bool> stopped{false};
+  std::atomic<uint64_t> lateDropped{0};  // logged after Stop()
+
+  wpi::mutex ringsMutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+
+  wpi::mutex flushMutex;
+  wpi::condition_variable flushCond;
+  uint64_t flushRequested = 0;
+  uint64_t flushDone = 0;
+  bool threadExited = false;
+};
+
+class AsyncLogSink::Thread : public SafeThread {
+ public:
+  explicit Thread(std::shared_ptr<Shared> shared)
+      : m_shared(std::move(shared)) {}
+
+  void Main() override;
+
+ private:
+  void Drain();
+
+  std::shared_ptr<Shared> m_shared;
+  std::vector<LogRecord> m_batch;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+};
+
+void AsyncLogSink::Thread::Main() {
+  Shared& shared = *m_shared;
+  std::unique_lock<wpi::mutex> lock(m_mutex);
+  while (m_active) {
+    lock.unlock();
+    uint64_t flushReq;
+    {
+      std::lock_guard<wpi::mutex> flushLock(shared.flushMutex);
+      flushReq = shared.flushRequested;
+    }
+    Drain();
+    {
+      std::lock_guard<wpi::mutex> flushLock(shared.flushMutex);
+      shared.flushDone = flushReq;
+    }
+    shared.flushCond.notify_all();
+
+    lock.lock();
+    if (!m_active) break;
+    {
+      // a Flush() that arrived during the drain is served immediately
+      std::lock_guard<wpi::mutex> flushLock(shared.flushMutex);
+      if (shared.flushRequested != flushReq) continue;
+    }
+    m_cond.wait_for(lock, shared.options.pollInterval);
+  }
+  lock.unlock();
+
+  // pick up anything logged between the final Flush() and Stop()
+  Drain();
+  {
+    std::lock_guard<wpi::mutex> flushLock(shared.flushMutex);
+    shared.threadExited = true;
+  }
+  shared.flushCond.notify_all();
+}
+
+void AsyncLogSink::Thread::Drain() {
+  {
+    std::lock_guard<wpi::mutex> lock(m_shared->ringsMutex);
+    m_rings = m_shared->rings;
+  }
+
+  for (auto& ring : m_rings) {
+    for (;;) {
+      auto entries = ring->queue.peek();
+      if (entries.empty()) break;
+      for (auto& entry : entries) {
+        m_batch.emplace_back();
+        LogRecord& record = m_batch.back();
+        record.time = entry.time;
+        record.level = entry.level;
+        record.file = entry.file;
+        record.line = entry.line;
+        if (entry.site) {
+          record.level = entry.site->level();
+          record.file = entry.site->file();
+          record.line = entry.site->line();
+          llvm::StringRef args(entry.text, entry.length);
+          if (m_shared->options.renderBinary) {
+            llvm::raw_string_ostream os(record.message);
+            RenderBinaryLog(entry.site->format(), args, os);
+            os.flush();
+          } else {
+            record.message = args;
+            record.site = entry.site;
+          }
+        } else if (entry.format) {
+          llvm::raw_string_ostream os(record.message);
+          entry.format(os);
+          os.flush();
+          // release captures here rather than on the logging thread
+          entry.format = nullptr;
+        } else {
+          record.message.assign(entry.text, entry.length);
+        }
+      }
+      ring->queue.consume(entries.size());
+    }
+
+    uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+    if (dropped != ring->reported) {
+      m_batch.emplace_back();
+      LogRecord& record = m_batch.back();
+      record.time = WPI_Now();
+      record.level = WPI_LOG_WARNING;
+      record.file = __FILE__;
+      record.line = __LINE__;
+      record.message = "dropped " + std::to_string(dropped - ring->reported) +
+                       " log messages (ring full)";
+      ring->reported = dropped;
+    }
+  }
+  m_rings.clear();
+
+  if (m_batch.empty()) return;
+  std::stable_sort(m_batch.begin(), m_batch.end(),
+                   [](const LogRecord& a, const LogRecord& b) {
+                     return a.time < b.time;
+                   });
+  if (m_shared->writer) {
+    size_t batchSize = std::max<size_t>(m_shared->options.batchSize, 1);
+    llvm::ArrayRef<LogRecord> records(m_batch);
+    while (!records.empty()) {
+      size_t n = std::min(batchSize, records.size());
+      m_shared->writer(records.slice(0, n));
+      records = records.drop_front(n);
+    }
+  }
+  m_batch.clear();
+}
+
+AsyncLogSink::AsyncLogSink(Writer writer)
+    : AsyncLogSink(std::move(writer), Options()) {}
+
+AsyncLogSink::AsyncLogSink(Writer writer, const Options& options)
+    : m_shared(std::make_shared<Shared>(std::move(writer), options)) {
+  m_owner.Start(new Thread(m_shared));
+}
+
+AsyncLogSink::~AsyncLogSink() { Stop(); }
+
+Logger::LogFunc AsyncLogSink::GetLogFunc() {
+  return [this](unsigned int level, const char* file, unsigned int line,
+                const char* msg) { Log(level, file, line, msg); };
+}
+
+AsyncLogSink::Ring* AsyncLogSink::GetRing() {
+  // Threads usually log to a single sink, so remember the last one used.
+  struct Cache {
+    uint64_t sinkId = 0;
+    Ring* ring = nullptr;
+  };
+  static thread_local Cache cache;
+  if (cache.sinkId == m_shared->id) return cache.ring;
+
+  auto self = std::this_thread::get_id();
+  std::lock_guard<wpi::mutex> lock(m_shared->ringsMutex);
+  Ring* ring = nullptr;
+  for (auto& r : m_shared->rings) {
+    if (r->owner == self) {
+      ring = r.get();
+      break;
+    }
+  }
+  if (!ring) {
+    m_shared->rings.emplace_back(
+        std::make_shared<Ring>(self, m_shared->options.ringCapacity));
+    ring = m_shared->rings.back().get();
+  }
+  cache.sinkId = m_shared->id;
+  cache.ring = ring;
+  return ring;
+}
+
+template <typename Fill>
+void AsyncLogSink::Enqueue(Fill fill) {
+  if (m_shared->stopped.load(std::memory_order_acquire)) {
+    m_shared->lateDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Ring* ring = GetRing();
+  // Stop() waits for busy to clear before the final drain, so a message
+  // either makes that drain or is counted as dropped.  Both this store and
+  // the load of stopped must be seq_cst to pair with Stop().
+  ring->busy.store(true);
+  if (m_shared->stopped.load()) {
+    ring->busy.store(false, std::memory_order_release);
+    m_shared->lateDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto slot = ring->queue.reserve(1);
+  while (slot.empty()) {
+    if (m_shared->options.overflow != kBlock ||
+        m_shared->stopped.load(std::memory_order_acquire)) {
+      ring->dropped.fetch_add(1, std::memory_order_relaxed);
+      ring->busy.store(false, std::memory_order_release);
+      return;
+    }
+    if (auto thr = m_owner.GetThread()) thr->m_cond.notify_one();
+    std::this_thread::yield();
+    slot = ring->queue.reserve(1);
+  }
+  Entry& entry = slot[0];
+  entry.time = WPI_Now();
+  fill(entry);
+  ring->queue.commit(1);
+  ring->busy.store(false, std::memory_order_release);
+}
+
+void AsyncLogSink::Log(unsigned int level, const char* file,
+                       unsigned int line, llvm::StringRef msg) {
+  Enqueue([&](Entry& entry) {
+    entry.level = level;
+    entry.file = file;
+    entry.line = line;
+    entry.length = std::min(msg.size(), kMaxMessage);
+    std::memcpy(entry.text, msg.data(), entry.length);
+    entry.format = nullptr;
+    entry.site = nullptr;
+  });
+}
+
+void AsyncLogSink::LogEncoded(const BinaryLogSite& site, const uint8_t* args,
+                              size_t len) {
+  Enqueue([&](Entry& entry) {
+    entry.length = std::min(len, kMaxMessage);
+    std::memcpy(entry.text, args, entry.length);
+    entry.format = nullptr;
+    entry.site = &site;
+  });
+}
+
+void AsyncLogSink::LogDeferred(unsigned int level, const char* file,
+                               unsigned int line, Formatter format) {
+  Enqueue([&](Entry& entry) {
+    entry.level = level;
+    entry.file = file;
+    entry.line = line;
+    entry.length = 0;
+    entry.format = std::move(format);
+    entry.site = nullptr;
+  });
+}
+
+void AsyncLogSink::Flush() {
+  Shared& shared = *m_shared;
+  uint64_t req;
+  {
+    std::lock_guard<wpi::mutex> lock(shared.flushMutex);
+    if (shared.threadExited) return;
+    req = ++shared.flushRequested;
+  }
+  if (auto thr = m_owner.GetThread()) thr->m_cond.notify_one();
+  std::unique_lock<wpi::mutex> lock(shared.flushMutex);
+  while (shared.flushDone < req && !shared.threadExited)
+    shared.flushCond.wait(lock);
+}
+
+void AsyncLogSink::Stop() {
+  if (m_shared->stopped.load(std::memory_order_acquire)) return;
+  Flush();
+  m_shared->stopped.store(true);
+  // let producers that got past the stopped check commit before the final
+  // drain; the drain thread keeps running, so blocked producers progress
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<wpi::mutex> lock(m_shared->ringsMutex);
+    rings = m_shared->rings;
+  }
+  for (auto& ring : rings) {
+    // seq_cst, pairing with Enqueue(): an acquire load could be ordered
+    // before the stopped store and miss a producer that passed its check
+    while (ring->busy.load()) std::this_thread::yield();
+  }
+  m_owner.Stop();
+  // wait for the final drain so the writer is not used after we return
+  std::unique_lock<wpi::mutex> lock(m_shared->flushMutex);
+  while (!m_shared->threadExited) m_shared->flushCond.wait(lock);
+}
+
+uint64_t AsyncLogSink::GetDropped() const {
+  uint64_t dropped = m_shared->lateDropped.load(std::memory_order_relaxed);
+  std::lock_guard<wpi::mutex> lock(m_shared->ringsMutex);
+  for (auto& ring : m_shared->rings)
+    dropped += ring->dropped.load(std::memory_order_relaxed);
+  return dropped;
+}
+
+static const char* LevelName(unsigned int level) {
+  switch (level) {
+    case WPI_LOG_CRITICAL:
+      return "CRITICAL";
+    case WPI_LOG_ERROR:
+      return "ERROR";
+    case WPI_LOG_WARNING:
+      return "WARNING";
+    case WPI_LOG_INFO:
+      return "INFO";
+    default:
+      return "DEBUG";
+  }
+}
+
+void AsyncLogSink::PrintRecord(llvm::raw_ostream& os,
+                               const LogRecord& record) {
+  os << llvm::format("%llu.%06llu ",
+                     static_cast<unsigned long long>(record.time / 1000000),
+                     static_cast<unsigned long long>(record.time % 1000000))
+     << LevelName(record.level) << ' ' << record.file << ':' << record.line
+     << ": ";
+  if (record.site)
+    RenderBinaryLog(record.site->format(), record.message, os);
+  else
+    os << record.message;
+  os << '\n';
+}
+
+AsyncLogSink::Writer AsyncLogSink::StreamWriter(llvm::raw_ostream& os) {
+  return [&os](llvm::ArrayRef<LogRecord> records) {
+    for (auto& record : records) PrintRecord(os, record);
+    os.flush();
+  };
+}
+
+AsyncLogSink::Writer AsyncLogSink::BinaryWriter(llvm::raw_ostream& os) {
+  auto writer = std::make_shared<BinaryLogFileWriter>(os);
+  return [=, &os](llvm::ArrayRef<LogRecord> records) {
+    for (auto& record : records) writer->Write(record);
+    os.flush();
+  };
+}
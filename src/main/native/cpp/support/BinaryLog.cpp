@@ -0,0 +1,272 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/BinaryLog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "support/AsyncLogSink.h"
+#include "support/mutex.h"
+
+using namespace wpi;
+
+namespace {
+
+constexpr char kMagic[8] = {'W', 'P', 'I', 'B', 'L', 'O', 'G', 1};
+
+enum RecordType : uint8_t {
+  kSiteRecord = 'S',
+  kBinaryRecord = 'B',
+  kTextRecord = 'T'
+};
+
+struct SiteRegistry {
+  wpi::mutex mutex;
+  std::vector<const BinaryLogSite*> sites;  // index is id - 1
+};
+
+SiteRegistry& GetRegistry() {
+  // Never destroyed: sites in other translation units may still be
+  // registering during static destruction.
+  static SiteRegistry* registry = new SiteRegistry;
+  return *registry;
+}
+
+template <typename T>
+void Put(llvm::raw_ostream& os, T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename Len>
+void PutString(llvm::raw_ostream& os, llvm::StringRef str) {
+  Len len = static_cast<Len>(
+      std::min<size_t>(str.size(), static_cast<Len>(-1)));
+  Put(os, len);
+  os.write(str.data(), len);
+}
+
+// Sequential reader over untrusted data; once a read fails, all later reads
+// fail.
+class Reader {
+ public:
+  explicit Reader(llvm::StringRef data) : m_data(data) {}
+
+  bool empty() const { return m_data.empty(); }
+  bool ok() const { return m_ok; }
+
+  template <typename T>
+  T Get() {
+    T value = T();
+    if (!m_ok || m_data.size() < sizeof(T)) {
+      m_ok = false;
+      return value;
+    }
+    std::memcpy(&value, m_data.data(), sizeof(T));
+    m_data = m_data.drop_front(sizeof(T));
+    return value;
+  }
+
+  llvm::StringRef GetBytes(size_t len) {
+    if (!m_ok || m_data.size() < len) {
+      m_ok = false;
+      return llvm::StringRef();
+    }
+    llvm::StringRef bytes = m_data.substr(0, len);
+    m_data = m_data.drop_front(len);
+    return bytes;
+  }
+
+  template <typename Len>
+  llvm::StringRef GetString() {
+    return GetBytes(Get<Len>());
+  }
+
+ private:
+  llvm::StringRef m_data;
+  bool m_ok = true;
+};
+
+// Prints one argument; returns false if the data is malformed.
+bool RenderArg(Reader& args, llvm::raw_ostream& os) {
+  switch (args.Get<uint8_t>()) {
+    case detail::kBinaryArgInt: {
+      auto v = args.Get<int64_t>();
+      if (args.ok()) os << v;
+      break;
+    }
+    case detail::kBinaryArgUInt: {
+      auto v = args.Get<uint64_t>();
+      if (args.ok()) os << v;
+      break;
+    }
+    case detail::kBinaryArgDouble: {
+      auto v = args.Get<double>();
+      if (args.ok()) os << v;
+      break;
+    }
+    case detail::kBinaryArgBool: {
+      auto v = args.Get<uint8_t>();
+      if (args.ok()) os << (v ? "true" : "false");
+      break;
+    }
+    case detail::kBinaryArgChar: {
+      auto v = args.Get<char>();
+      if (args.ok()) os << v;
+      break;
+    }
+    case detail::kBinaryArgString: {
+      auto v = args.GetString<uint16_t>();
+      if (args.ok()) os << v;
+      break;
+    }
+    default:
+      return false;
+  }
+  return args.ok();
+}
+
+}  // namespace
+
+BinaryLogSite::BinaryLogSite(unsigned int level, const char* file,
+                             unsigned int line, const char* format)
+    : m_level(level), m_file(file), m_line(line), m_format(format) {
+  auto& registry = GetRegistry();
+  std::lock_guard<wpi::mutex> lock(registry.mutex);
+  registry.sites.push_back(this);
+  m_id = static_cast<uint32_t>(registry.sites.size());
+}
+
+const BinaryLogSite* BinaryLogSite::Get(uint32_t id) {
+  auto& registry = GetRegistry();
+  std::lock_guard<wpi::mutex> lock(registry.mutex);
+  if (id == 0 || id > registry.sites.size()) return nullptr;
+  return registry.sites[id - 1];
+}
+
+void wpi::RenderBinaryLog(llvm::StringRef format, llvm::StringRef args,
+                          llvm::raw_ostream& os) {
+  Reader reader(args);
+  bool good = true;
+  while (!format.empty()) {
+    size_t brace = format.find('{');
+    os << format.substr(0, brace);
+    if (brace == llvm::StringRef::npos) break;
+    format = format.drop_front(brace);
+    if (format.startswith("{{")) {
+      os << '{';
+      format = format.drop_front(2);
+    } else if (format.startswith("{}")) {
+      if (!good)
+        os << "<?>";
+      else if (reader.empty())
+        os << "{}";  // no argument for this placeholder
+      else if (!(good = RenderArg(reader, os)))
+        os << "<?>";
+      format = format.drop_front(2);
+    } else {
+      os << '{';
+      format = format.drop_front(1);
+    }
+  }
+}
+
+BinaryLogFileWriter::BinaryLogFileWriter(llvm::raw_ostream& os) : m_os(os) {
+  m_os.write(kMagic, sizeof(kMagic));
+}
+
+void BinaryLogFileWriter::Write(const LogRecord& record) {
+  if (!record.site) {
+    Put<uint8_t>(m_os, kTextRecord);
+    Put<uint64_t>(m_os, record.time);
+    Put<uint32_t>(m_os, record.level);
+    Put<uint32_t>(m_os, record.line);
+    PutString<uint16_t>(m_os, record.file);
+    PutString<uint32_t>(m_os, record.message);
+    return;
+  }
+
+  const BinaryLogSite& site = *record.site;
+  if (site.id() >= m_sitesWritten.size())
+    m_sitesWritten.resize(site.id() + 1);
+  if (!m_sitesWritten[site.id()]) {
+    Put<uint8_t>(m_os, kSiteRecord);
+    Put<uint32_t>(m_os, site.id());
+    Put<uint32_t>(m_os, site.level());
+    Put<uint32_t>(m_os, site.line());
+    PutString<uint16_t>(m_os, site.file());
+    PutString<uint16_t>(m_os, site.format());
+    m_sitesWritten[site.id()] = true;
+  }
+  Put<uint8_t>(m_os, kBinaryRecord);
+  Put<uint32_t>(m_os, site.id());
+  Put<uint64_t>(m_os, record.time);
+  PutString<uint16_t>(m_os, record.message);
+}
+
+bool wpi::DecodeBinaryLog(llvm::StringRef data, llvm::raw_ostream& os) {
+  if (!data.startswith(llvm::StringRef(kMagic, sizeof(kMagic)))) return false;
+  Reader reader(data.drop_front(sizeof(kMagic)));
+
+  struct Site {
+    unsigned int level;
+    unsigned int line;
+    std::string file;
+    std::string format;
+  };
+  std::unordered_map<uint32_t, Site> sites;
+
+  LogRecord record;
+  while (!reader.empty()) {
+    switch (reader.Get<uint8_t>()) {
+      case kSiteRecord: {
+        uint32_t id = reader.Get<uint32_t>();
+        Site& site = sites[id];
+        site.level = reader.Get<uint32_t>();
+        site.line = reader.Get<uint32_t>();
+        site.file = reader.GetString<uint16_t>();
+        site.format = reader.GetString<uint16_t>();
+        break;
+      }
+      case kBinaryRecord: {
+        uint32_t id = reader.Get<uint32_t>();
+        record.time = reader.Get<uint64_t>();
+        llvm::StringRef args = reader.GetString<uint16_t>();
+        if (!reader.ok()) return false;
+        auto it = sites.find(id);
+        if (it == sites.end()) return false;
+        record.level = it->second.level;
+        record.file = it->second.file.c_str();
+        record.line = it->second.line;
+        record.message.clear();
+        llvm::raw_string_ostream msg(record.message);
+        RenderBinaryLog(it->second.format, args, msg);
+        msg.flush();
+        AsyncLogSink::PrintRecord(os, record);
+        break;
+      }
+      case kTextRecord: {
+        record.time = reader.Get<uint64_t>();
+        record.level = reader.Get<uint32_t>();
+        record.line = reader.Get<uint32_t>();
+        std::string file = reader.GetString<uint16_t>();
+        record.message = reader.GetString<uint32_t>();
+        if (!reader.ok()) return false;
+        record.file = file.c_str();
+        AsyncLogSink::PrintRecord(os, record);
+        break;
+      }
+      default:
+        return false;
+    }
+    if (!reader.ok()) return false;
+  }
+  return true;
+}
@@ -0,0 +1,139 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Metrics.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "support/json.h"
+
+using namespace wpi;
+
+constexpr unsigned int LatencyHistogram::kSubBucketBits;
+constexpr unsigned int LatencyHistogram::kSubBuckets;
+constexpr unsigned int LatencyHistogram::kMaxBits;
+constexpr size_t LatencyHistogram::kBuckets;
+constexpr size_t LatencyHistogram::kShards;
+
+std::atomic<bool> detail::gMetricsInstrumentation{false};
+
+static std::atomic<size_t> nextShard{0};
+
+uint64_t HistogramSnapshot::Percentile(double q) const {
+  if (count == 0) return 0;
+  q = std::min(std::max(q, 0.0), 1.0);
+  uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min(LatencyHistogram::BucketUpperBound(i), max);
+  }
+  return max;
+}
+
+LatencyHistogram::LatencyHistogram() : m_shards(new Shard[kShards]) {
+  for (size_t s = 0; s < kShards; ++s) {
+    for (auto& count : m_shards[s].counts)
+      count.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t LatencyHistogram::ShardIndex() {
+  static thread_local size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return shard;
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(size_t index) {
+  if (index < 2 * kSubBuckets) return index;
+  unsigned int shift = static_cast<unsigned int>(index / kSubBuckets) - 1;
+  return static_cast<uint64_t>(index % kSubBuckets + kSubBuckets) << shift;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  if (index == kBuckets - 1) return UINT64_MAX;
+  return BucketLowerBound(index + 1) - 1;
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.buckets.resize(kBuckets);
+  for (size_t s = 0; s < kShards; ++s) {
+    const Shard& shard = m_shards[s];
+    snapshot.count += shard.count.load(std::memory_order_relaxed);
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    snapshot.max =
+        std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < kBuckets; ++i)
+      snapshot.buckets[i] += shard.counts[i].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+MetricsRegistry& MetricsRegistry::GetInstance() {
+  // Never destroyed: instrumented code may run during static destruction.
+  static MetricsRegistry* instance = new MetricsRegistry;
+  return *instance;
+}
+
+void MetricsRegistry::EnableInstrumentation(bool enable) {
+  detail::gMetricsInstrumentation.store(enable, std::memory_order_relaxed);
+}
+
+template <typename T>
+static T& GetMetric(std::map<std::string, std::unique_ptr<T>>& metrics,
+                    llvm::StringRef name) {
+  auto& metric = metrics[name];
+  if (!metric) metric.reset(new T);
+  return *metric;
+}
+
+MetricCounter& MetricsRegistry::GetCounter(llvm::StringRef name) {
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  return GetMetric(m_counters, name);
+}
+
+MetricGauge& MetricsRegistry::GetGauge(llvm::StringRef name) {
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  return GetMetric(m_gauges, name);
+}
+
+LatencyHistogram& MetricsRegistry::GetHistogram(llvm::StringRef name) {
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  return GetMetric(m_histograms, name);
+}
+
+json MetricsRegistry::Snapshot() const {
+  json counters = json::object();
+  json gauges = json::object();
+  json histograms = json::object();
+
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  for (auto& counter : m_counters)
+    counters[counter.first] = counter.second->Get();
+  for (auto& gauge : m_gauges) gauges[gauge.first] = gauge.second->Get();
+  for (auto& hist : m_histograms) {
+    HistogramSnapshot snapshot = hist.second->Snapshot();
+    histograms[hist.first] = {{"count", snapshot.count},
+                              {"sum", snapshot.sum},
+                              {"mean", snapshot.Mean()},
+                              {"max", snapshot.max},
+                              {"p50", snapshot.Percentile(0.5)},
+                              {"p90", snapshot.Percentile(0.9)},
+                              {"p99", snapshot.Percentile(0.99)},
+                              {"p999", snapshot.Percentile(0.999)}};
+  }
+  return {{"counters", std::move(counters)},
+          {"gauges", std::move(gauges)},
+          {"histograms", std::move(histograms)}};
+}
+
+std::string MetricsRegistry::SnapshotCbor() const {
+  return json::to_cbor(Snapshot());
+}
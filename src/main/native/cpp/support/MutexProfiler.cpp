@@ -0,0 +1,327 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/MutexProfiler.h"
+
+#include <algorithm>
+
+#include "llvm/Format.h"
+
+#if defined(WPI_HAVE_PRIORITY_MUTEX) && defined(WPI_MUTEX_PROFILING)
+#define WPI_MUTEX_PROFILER_ACTIVE
+#endif
+
+#ifdef WPI_MUTEX_PROFILER_ACTIVE
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "llvm/MathExtras.h"
+#endif
+
+using namespace wpi;
+
+static uint64_t Percentile(const std::vector<uint64_t>& histogram,
+                           uint64_t max, double q) {
+  uint64_t count = 0;
+  for (auto n : histogram) count += n;
+  if (count == 0) return 0;
+  q = std::min(std::max(q, 0.0), 1.0);
+  uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    seen += histogram[i];
+    if (seen >= rank) {
+      uint64_t upper = i >= 63 ? UINT64_MAX : (uint64_t(2) << i) - 1;
+      return std::min(upper, max);
+    }
+  }
+  return max;
+}
+
+uint64_t MutexProfileSnapshot::WaitPercentile(double q) const {
+  return Percentile(waitHistogram, maxWaitNs, q);
+}
+
+uint64_t MutexProfileSnapshot::HoldPercentile(double q) const {
+  return Percentile(holdHistogram, maxHoldNs, q);
+}
+
+#ifdef WPI_MUTEX_PROFILER_ACTIVE
+
+// Everything here is reached from inside priority_mutex, so it must not use
+// wpi::mutex itself, even indirectly: NowNs() can take one while
+// calibrating, so timing uses steady_clock directly.
+
+namespace {
+
+constexpr size_t kBuckets = 48;
+constexpr size_t kMaxSites = 8;
+
+struct Histogram {
+  Histogram() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+  }
+
+  void Record(uint64_t ns) {
+    size_t i =
+        ns == 0 ? 0 : std::min<size_t>(llvm::Log2_64(ns), kBuckets - 1);
+    buckets[i].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = max.load(std::memory_order_relaxed);
+    while (ns > prev &&
+           !max.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  void Copy(std::vector<uint64_t>* out, uint64_t* outTotal,
+            uint64_t* outMax) const {
+    out->resize(kBuckets);
+    for (size_t i = 0; i < kBuckets; ++i)
+      (*out)[i] = buckets[i].load(std::memory_order_relaxed);
+    *outTotal = total.load(std::memory_order_relaxed);
+    *outMax = max.load(std::memory_order_relaxed);
+  }
+
+  void Reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> buckets[kBuckets];
+  std::atomic<uint64_t> total{0};
+  std::atomic<uint64_t> max{0};
+};
+
+struct CallSite {
+  std::atomic<const void*> pc{nullptr};
+  std::atomic<uint64_t> count{0};
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<detail::MutexProfile*> profiles;
+};
+
+Registry& GetRegistry() {
+  // Never destroyed: mutexes with static storage duration may be destroyed
+  // after it.
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+std::atomic<bool> gCaptureCallSites{false};
+
+uint64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+struct detail::MutexProfile {
+  explicit MutexProfile(const void* mutex_) : mutex(mutex_) {}
+
+  const void* mutex;  // guarded by the registry mutex
+  const char* name = nullptr;
+  std::atomic<uint64_t> acquisitions{0};
+  std::atomic<uint64_t> contended{0};
+  Histogram wait;
+  Histogram hold;
+  CallSite sites[kMaxSites];
+
+  void RecordSite(const void* pc) {
+    for (auto& site : sites) {
+      const void* cur = site.pc.load(std::memory_order_relaxed);
+      if (!cur &&
+          site.pc.compare_exchange_strong(cur, pc, std::memory_order_relaxed))
+        cur = pc;
+      if (cur == pc) {
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+    // table full; the site goes uncounted
+  }
+};
+
+static detail::MutexProfile* GetProfile(
+    std::atomic<detail::MutexProfile*>& profile, const void* mutex) {
+  detail::MutexProfile* p = profile.load(std::memory_order_acquire);
+  if (p) return p;
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  p = profile.load(std::memory_order_acquire);
+  if (p) return p;
+  p = new detail::MutexProfile(mutex);
+  registry.profiles.push_back(p);
+  profile.store(p, std::memory_order_release);
+  return p;
+}
+
+uint64_t detail::ProfileWaitStart() noexcept { return Now(); }
+
+uint64_t detail::ProfileAcquired(std::atomic<MutexProfile*>& profile,
+                                 const void* mutex, uint64_t waitStart,
+                                 const void* caller) noexcept {
+  MutexProfile* p = GetProfile(profile, mutex);
+  uint64_t now = Now();
+  p->acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (waitStart != 0) {
+    p->contended.fetch_add(1, std::memory_order_relaxed);
+    p->wait.Record(now - waitStart);
+    if (gCaptureCallSites.load(std::memory_order_relaxed))
+      p->RecordSite(caller);
+  }
+  return now;
+}
+
+void detail::ProfileReleased(std::atomic<MutexProfile*>& profile,
+                             uint64_t acquired) noexcept {
+  MutexProfile* p = profile.load(std::memory_order_relaxed);
+  if (p) p->hold.Record(Now() - acquired);
+}
+
+void detail::ProfileSetName(std::atomic<MutexProfile*>& profile,
+                            const void* mutex, const char* name) noexcept {
+  MutexProfile* p = GetProfile(profile, mutex);
+  std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+  p->name = name;
+}
+
+void detail::ProfileDestroyed(std::atomic<MutexProfile*>& profile) noexcept {
+  MutexProfile* p = profile.load(std::memory_order_acquire);
+  if (!p) return;
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (p->contended.load(std::memory_order_relaxed) != 0) {
+    p->mutex = nullptr;  // keep for reporting
+    return;
+  }
+  auto& profiles = registry.profiles;
+  profiles.erase(std::find(profiles.begin(), profiles.end(), p));
+  delete p;
+}
+
+bool MutexProfiler::IsEnabled() { return true; }
+
+void MutexProfiler::SetCaptureCallSites(bool capture) {
+  gCaptureCallSites.store(capture, std::memory_order_relaxed);
+}
+
+std::vector<MutexProfileSnapshot> MutexProfiler::Snapshot() {
+  std::vector<MutexProfileSnapshot> snapshots;
+  {
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    snapshots.reserve(registry.profiles.size());
+    for (auto p : registry.profiles) {
+      snapshots.emplace_back();
+      auto& s = snapshots.back();
+      if (p->name) s.name = p->name;
+      s.mutex = p->mutex;
+      s.acquisitions = p->acquisitions.load(std::memory_order_relaxed);
+      s.contended = p->contended.load(std::memory_order_relaxed);
+      p->wait.Copy(&s.waitHistogram, &s.waitNs, &s.maxWaitNs);
+      p->hold.Copy(&s.holdHistogram, &s.holdNs, &s.maxHoldNs);
+      for (auto& site : p->sites) {
+        const void* pc = site.pc.load(std::memory_order_relaxed);
+        if (!pc) break;
+        s.callSites.emplace_back(pc,
+                                 site.count.load(std::memory_order_relaxed));
+      }
+      std::sort(s.callSites.begin(), s.callSites.end(),
+                [](const std::pair<const void*, uint64_t>& a,
+                   const std::pair<const void*, uint64_t>& b) {
+                  return a.second > b.second;
+                });
+    }
+  }
+  std::stable_sort(snapshots.begin(), snapshots.end(),
+                   [](const MutexProfileSnapshot& a,
+                      const MutexProfileSnapshot& b) {
+                     return a.waitNs > b.waitNs;
+                   });
+  return snapshots;
+}
+
+void MutexProfiler::Reset() {
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto& profiles = registry.profiles;
+  for (auto it = profiles.begin(); it != profiles.end();) {
+    detail::MutexProfile* p = *it;
+    if (!p->mutex) {
+      delete p;
+      it = profiles.erase(it);
+      continue;
+    }
+    p->acquisitions.store(0, std::memory_order_relaxed);
+    p->contended.store(0, std::memory_order_relaxed);
+    p->wait.Reset();
+    p->hold.Reset();
+    for (auto& site : p->sites) {
+      site.pc.store(nullptr, std::memory_order_relaxed);
+      site.count.store(0, std::memory_order_relaxed);
+    }
+    ++it;
+  }
+}
+
+#else  // WPI_MUTEX_PROFILER_ACTIVE
+
+bool MutexProfiler::IsEnabled() { return false; }
+
+void MutexProfiler::SetCaptureCallSites(bool) {}
+
+std::vector<MutexProfileSnapshot> MutexProfiler::Snapshot() { return {}; }
+
+void MutexProfiler::Reset() {}
+
+#endif  // WPI_MUTEX_PROFILER_ACTIVE
+
+void MutexProfiler::Dump(llvm::raw_ostream& os) {
+  if (!IsEnabled()) {
+    os << "mutex profiling not enabled (build with WPI_MUTEX_PROFILING)\n";
+    return;
+  }
+  os << llvm::left_justify("mutex", 24) << ' '
+     << llvm::right_justify("acquired", 12) << ' '
+     << llvm::right_justify("contended", 10) << ' '
+     << llvm::right_justify("wait ms", 12) << ' '
+     << llvm::right_justify("wait p99 ns", 12) << ' '
+     << llvm::right_justify("hold ms", 12) << ' '
+     << llvm::right_justify("hold p99 ns", 12) << '\n';
+  for (auto& s : Snapshot()) {
+    if (s.contended == 0) continue;
+    std::string label = s.name;
+    if (label.empty()) {
+      llvm::raw_string_ostream labelOs(label);
+      if (s.mutex)
+        labelOs << llvm::format_hex(reinterpret_cast<uintptr_t>(s.mutex), 0);
+      else
+        labelOs << "(destroyed)";
+      labelOs.flush();
+    } else if (!s.mutex) {
+      label += " (destroyed)";
+    }
+    os << llvm::left_justify(label, 24) << ' '
+       << llvm::format_decimal(s.acquisitions, 12) << ' '
+       << llvm::format_decimal(s.contended, 10) << ' '
+       << llvm::format("%12.3f", s.waitNs / 1e6) << ' '
+       << llvm::format_decimal(s.WaitPercentile(0.99), 12) << ' '
+       << llvm::format("%12.3f", s.holdNs / 1e6) << ' '
+       << llvm::format_decimal(s.HoldPercentile(0.99), 12) << '\n';
+    for (auto& site : s.callSites) {
+      os << "    at "
+         << llvm::format_hex(reinterpret_cast<uintptr_t>(site.first), 0)
+         << ": " << site.second << '\n';
+    }
+  }
+}
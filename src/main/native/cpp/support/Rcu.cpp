@@ -0,0 +1,212 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Rcu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "support/SafeThread.h"
+#include "support/condition_variable.h"
+
+using namespace wpi;
+
+// Starts at 1 so a pinned epoch is never 0 (which means "not reading").
+std::atomic<uint64_t> detail::rcuGlobalEpoch{1};
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+
+// Reclaim as soon as this many objects are waiting.
+constexpr size_t kRetireBatch = 64;
+// Otherwise reclaim this often while anything is waiting.
+constexpr auto kReclaimPeriod = std::chrono::milliseconds(10);
+
+// Per-thread record, padded so reader writes never share a cache line.
+struct PaddedRecord {
+  char pad0[kCacheLine];
+  detail::RcuRecord record;
+  std::atomic<bool> inUse{true};
+  char pad1[kCacheLine];
+};
+
+struct Retired {
+  uint64_t epoch;
+  void* ptr;
+  void (*deleter)(void*);
+};
+
+class Reclaimer : public SafeThread {
+ public:
+  void Main() override;
+};
+
+class RcuDomain {
+ public:
+  static RcuDomain& GetInstance() {
+    // Never destroyed: detached threads may still read or retire during
+    // static destruction.
+    static RcuDomain* instance = new RcuDomain;
+    return *instance;
+  }
+
+  detail::RcuRecord* Register();
+  void Retire(void* ptr, void (*deleter)(void*));
+  void Synchronize();
+  void Barrier();
+  // Frees what can be freed; returns the number of objects still waiting.
+  size_t Reclaim();
+  size_t GetPending();
+
+  SafeThreadOwner<Reclaimer> m_reclaimer;
+
+ private:
+  uint64_t MinActiveEpoch();
+
+  wpi::mutex m_recordsMutex;
+  std::vector<PaddedRecord*> m_records;  // never shrinks; records are reused
+
+  wpi::mutex m_retiredMutex;
+  std::vector<Retired> m_retired;
+
+  // Serializes Reclaim() so Barrier() can tell when a concurrent pass is done.
+  wpi::mutex m_reclaimMutex;
+};
+
+// Releases the thread's record at thread exit.
+struct RecordHolder {
+  PaddedRecord* record = nullptr;
+  ~RecordHolder() {
+    if (!record) return;
+    record->record.epoch.store(0, std::memory_order_release);
+    record->inUse.store(false, std::memory_order_release);
+  }
+};
+
+}  // namespace
+
+void Reclaimer::Main() {
+  RcuDomain& domain = RcuDomain::GetInstance();
+  std::unique_lock<wpi::mutex> lock(m_mutex);
+  while (m_active) {
+    // Retire() notifies under m_mutex after queueing, so checking here
+    // cannot miss a wakeup.
+    if (domain.GetPending() == 0)
+      m_cond.wait(lock);
+    else
+      m_cond.wait_for(lock, kReclaimPeriod);
+    if (!m_active) break;
+    lock.unlock();
+    domain.Reclaim();
+    lock.lock();
+  }
+}
+
+detail::RcuRecord* RcuDomain::Register() {
+  static thread_local RecordHolder holder;
+  std::lock_guard<wpi::mutex> lock(m_recordsMutex);
+  for (auto record : m_records) {
+    bool free = false;
+    if (record->inUse.compare_exchange_strong(free, true)) {
+      holder.record = record;
+      return &record->record;
+    }
+  }
+  m_records.push_back(new PaddedRecord);
+  holder.record = m_records.back();
+  return &holder.record->record;
+}
+
+uint64_t RcuDomain::MinActiveEpoch() {
+  // Pairs with the fence in RcuReadLock.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint64_t min = UINT64_MAX;
+  std::lock_guard<wpi::mutex> lock(m_recordsMutex);
+  for (auto record : m_records) {
+    uint64_t epoch = record->record.epoch.load(std::memory_order_acquire);
+    if (epoch != 0) min = std::min(min, epoch);
+  }
+  return min;
+}
+
+void RcuDomain::Retire(void* ptr, void (*deleter)(void*)) {
+  // Readers that pin a later epoch cannot see ptr: it was unpublished
+  // before this increment.
+  uint64_t epoch =
+      detail::rcuGlobalEpoch.fetch_add(1, std::memory_order_seq_cst);
+  size_t waiting;
+  {
+    std::lock_guard<wpi::mutex> lock(m_retiredMutex);
+    m_retired.push_back(Retired{epoch, ptr, deleter});
+    waiting = m_retired.size();
+    if (!m_reclaimer) m_reclaimer.Start(new Reclaimer);
+  }
+  if (waiting == 1 || waiting >= kRetireBatch) {
+    if (auto thr = m_reclaimer.GetThread()) thr->m_cond.notify_one();
+  }
+}
+
+size_t RcuDomain::Reclaim() {
+  std::lock_guard<wpi::mutex> reclaimLock(m_reclaimMutex);
+  std::vector<Retired> retired;
+  {
+    std::lock_guard<wpi::mutex> lock(m_retiredMutex);
+    retired.swap(m_retired);
+  }
+  if (retired.empty()) return 0;
+
+  uint64_t min = MinActiveEpoch();
+  auto keep = std::partition(retired.begin(), retired.end(),
+                             [=](const Retired& r) { return r.epoch >= min; });
+  for (auto it = keep; it != retired.end(); ++it) it->deleter(it->ptr);
+  retired.erase(keep, retired.end());
+
+  std::lock_guard<wpi::mutex> lock(m_retiredMutex);
+  m_retired.insert(m_retired.end(), retired.begin(), retired.end());
+  return m_retired.size();
+}
+
+size_t RcuDomain::GetPending() {
+  std::lock_guard<wpi::mutex> lock(m_retiredMutex);
+  return m_retired.size();
+}
+
+void RcuDomain::Synchronize() {
+  uint64_t epoch =
+      detail::rcuGlobalEpoch.fetch_add(1, std::memory_order_seq_cst);
+  while (MinActiveEpoch() <= epoch)
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+void RcuDomain::Barrier() {
+  uint64_t epoch = detail::rcuGlobalEpoch.load(std::memory_order_seq_cst);
+  for (;;) {
+    Reclaim();
+    {
+      std::lock_guard<wpi::mutex> lock(m_retiredMutex);
+      if (std::none_of(m_retired.begin(), m_retired.end(),
+                       [=](const Retired& r) { return r.epoch < epoch; }))
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+detail::RcuRecord* detail::RcuRegisterThread() {
+  return RcuDomain::GetInstance().Register();
+}
+
+void wpi::RcuRetire(void* ptr, void (*deleter)(void*)) {
+  RcuDomain::GetInstance().Retire(ptr, deleter);
+}
+
+void wpi::RcuSynchronize() { RcuDomain::GetInstance().Synchronize(); }
+
+void wpi::RcuBarrier() { RcuDomain::GetInstance().Barrier(); }
@@ -0,0 +1,365 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/ThreadPool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "support/condition_variable.h"
+#include "support/mutex.h"
+
+using namespace wpi;
+
+// MSVC < 1900 doesn't have support for thread_local
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+// clang check for availability of thread_local
+#if defined(__clang__)
+#if __has_feature(cxx_thread_local)
+#define HAVE_THREAD_LOCAL
+#endif
+#else
+#define HAVE_THREAD_LOCAL
+#endif
+#endif
+
+namespace {
+
+// A worker's local deque.  The owning worker pushes and pops at the back;
+// thieves take from the front.
+struct WorkerQueue {
+  wpi::mutex mutex;
+  std::deque<ThreadPool::Task> tasks;
+};
+
+}  // namespace
+
+// State shared between the pool object and its workers.  Kept alive by the
+// workers after the pool is destroyed so draining can finish.
+class ThreadPool::Impl {
+ public:
+  Impl(const Options& options, unsigned int numThreads)
+      : m_capacity(options.queueCapacity == 0 ? 1 : options.queueCapacity),
+        m_queues(numThreads) {
+    for (auto& queue : m_queues) queue.reset(new WorkerQueue);
+  }
+
+  bool PushGlobal(Task& task, bool wait);
+  void PushLocal(size_t index, Task&& task);
+  bool Pop(size_t index, Task& task);
+  void Finished();
+  void Wake();
+
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_workCond;   // idle workers wait here
+  wpi::condition_variable m_spaceCond;  // Execute() waits here when full
+  wpi::condition_variable m_idleCond;   // WaitIdle() waits here
+  std::deque<Task> m_global;
+  size_t m_capacity;
+  int m_spaceWaiters = 0;
+  int m_idleWaiters = 0;
+  bool m_stopping = false;
+  bool m_drain = true;
+
+  // Written once at construction, then only the deques are modified.
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+  // Tasks sitting in any queue; idle workers sleep while this is zero.
+  std::atomic<size_t> m_queued{0};
+  // Tasks queued or running; WaitIdle() waits for this to reach zero.
+  std::atomic<size_t> m_outstanding{0};
+  std::atomic<int> m_sleeping{0};
+};
+
+#ifdef HAVE_THREAD_LOCAL
+// The pool and index of the worker running on this thread, if any.
+static thread_local const void* tl_pool = nullptr;
+static thread_local size_t tl_index = 0;
+#endif
+
+class ThreadPool::Worker : public SafeThread {
+ public:
+  Worker(std::shared_ptr<Impl> impl, size_t index, std::string name, int cpu)
+      : m_impl(std::move(impl)),
+        m_index(index),
+        m_name(std::move(name)),
+        m_cpu(cpu) {}
+
+  void Main() override;
+
+ private:
+  void Configure();
+
+  std::shared_ptr<Impl> m_impl;
+  size_t m_index;
+  std::string m_name;
+  int m_cpu;
+};
+
+bool ThreadPool::Impl::PushGlobal(Task& task, bool wait) {
+  {
+    std::unique_lock<wpi::mutex> lock(m_mutex);
+    if (wait) {
+      ++m_spaceWaiters;
+      while (!m_stopping && m_global.size() >= m_capacity)
+        m_spaceCond.wait(lock);
+      --m_spaceWaiters;
+    }
+    if (m_stopping || m_global.size() >= m_capacity) return false;
+    m_global.emplace_back(std::move(task));
+    ++m_outstanding;
+    ++m_queued;
+  }
+  Wake();
+  return true;
+}
+
+void ThreadPool::Impl::PushLocal(size_t index, Task&& task) {
+  {
+    std::lock_guard<wpi::mutex> lock(m_queues[index]->mutex);
+    m_queues[index]->tasks.emplace_back(std::move(task));
+  }
+  ++m_outstanding;
+  ++m_queued;
+  Wake();
+}
+
+void ThreadPool::Impl::Wake() {
+  // Pairs with the increment of m_sleeping in Worker::Main(): either the
+  // sleeper sees the new task count or we see the sleeper.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed) == 0) return;
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  m_workCond.notify_one();
+}
+
+bool ThreadPool::Impl::Pop(size_t index, Task& task) {
+  if (m_queued.load(std::memory_order_relaxed) == 0) return false;
+
+  // own deque, newest first
+  {
+    WorkerQueue& queue = *m_queues[index];
+    std::lock_guard<wpi::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+
+  // global queue, oldest first
+  {
+    std::unique_lock<wpi::mutex> lock(m_mutex);
+    if (!m_global.empty()) {
+      task = std::move(m_global.front());
+      m_global.pop_front();
+      --m_queued;
+      if (m_spaceWaiters > 0) {
+        lock.unlock();
+        m_spaceCond.notify_one();
+      }
+      return true;
+    }
+  }
+
+  // steal from other workers, oldest first
+  size_t n = m_queues.size();
+  for (size_t i = 1; i < n; ++i) {
+    WorkerQueue& queue = *m_queues[(index + i) % n];
+    std::unique_lock<wpi::mutex> lock(queue.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || queue.tasks.empty()) continue;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    --m_queued;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Impl::Finished() {
+  if (--m_outstanding != 0) return;
+  std::lock_guard<wpi::mutex> lock(m_mutex);
+  if (m_idleWaiters > 0) m_idleCond.notify_all();
+}
+
+void ThreadPool::Worker::Configure() {
+#ifdef __linux__
+  if (!m_name.empty()) {
+    // Linux limits names to 16 bytes including the terminator.
+    pthread_setname_np(pthread_self(), m_name.substr(0, 15).c_str());
+  }
+  if (m_cpu >= 0 && m_cpu < CPU_SETSIZE) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(m_cpu, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+  }
+#elif defined(__APPLE__)
+  if (!m_name.empty()) pthread_setname_np(m_name.c_str());
+#endif
+}
+
+void ThreadPool::Worker::Main() {
+  Configure();
+#ifdef HAVE_THREAD_LOCAL
+  tl_pool = m_impl.get();
+  tl_index = m_index;
+#endif
+
+  Impl& impl = *m_impl;
+  Task task;
+  for (;;) {
+    // m_drain is written before m_active is cleared, so it's safe to read
+    // once m_active is false
+    if (!m_active && !impl.m_drain) break;
+    if (impl.Pop(m_index, task)) {
+      task();
+      task = nullptr;
+      impl.Finished();
+      continue;
+    }
+
+    std::unique_lock<wpi::mutex> lock(impl.m_mutex);
+    if (!m_active && (!impl.m_drain || impl.m_queued == 0)) break;
+    ++impl.m_sleeping;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (impl.m_queued == 0 && m_active) impl.m_workCond.wait(lock);
+    --impl.m_sleeping;
+    if (!m_active && !impl.m_drain) break;
+  }
+
+#ifdef HAVE_THREAD_LOCAL
+  tl_pool = nullptr;
+#endif
+}
+
+ThreadPool::ThreadPool() : ThreadPool(Options()) {}
+
+ThreadPool::ThreadPool(const Options& options)
+    : m_numThreads(options.numThreads) {
+  if (m_numThreads == 0) m_numThreads = std::thread::hardware_concurrency();
+  if (m_numThreads == 0) m_numThreads = 1;
+  m_impl = std::make_shared<Impl>(options, m_numThreads);
+  m_workers = std::vector<SafeThreadOwner<Worker>>(m_numThreads);
+  for (unsigned int i = 0; i < m_numThreads; ++i) {
+    std::string name;
+    if (!options.name.empty()) name = options.name + '-' + std::to_string(i);
+    int cpu = options.cpus.empty() ? -1 : options.cpus[i % options.cpus.size()];
+    m_workers[i].Start(new Worker(m_impl, i, std::move(name), cpu));
+  }
+}
+
+ThreadPool::~ThreadPool() { Stop(); }
+
+bool ThreadPool::Execute(Task task) {
+#ifdef HAVE_THREAD_LOCAL
+  // Workers queue locally; bounding them could deadlock the pool.
+  if (tl_pool == m_impl.get()) return ExecuteLocal(std::move(task));
+#endif
+  return m_impl->PushGlobal(task, true);
+}
+
+bool ThreadPool::TryExecute(Task task) {
+#ifdef HAVE_THREAD_LOCAL
+  if (tl_pool == m_impl.get()) return ExecuteLocal(std::move(task));
+#endif
+  return m_impl->PushGlobal(task, false);
+}
+
+bool ThreadPool::ExecuteLocal(Task task) {
+  // Unlike continuations (see EnqueueLocal()), new tasks are refused once
+  // the pool is stopping, so a task that resubmits itself can't keep the
+  // workers alive.
+  {
+    std::lock_guard<wpi::mutex> lock(m_impl->m_mutex);
+    if (m_impl->m_stopping) return false;
+  }
+  EnqueueLocal(*m_impl, std::move(task));
+  return true;
+}
+
+void ThreadPool::EnqueueLocal(Impl& impl, Task task) {
+#ifdef HAVE_THREAD_LOCAL
+  if (tl_pool == &impl) {
+    impl.PushLocal(tl_index, std::move(task));
+    return;
+  }
+#endif
+  // Not on a worker (or no thread_local support); continuations must not be
+  // dropped, so ignore the bound.
+  {
+    std::lock_guard<wpi::mutex> lock(impl.m_mutex);
+    impl.m_global.emplace_back(std::move(task));
+    ++impl.m_outstanding;
+    ++impl.m_queued;
+  }
+  impl.Wake();
+}
+
+void ThreadPool::WaitIdle() {
+  std::unique_lock<wpi::mutex> lock(m_impl->m_mutex);
+  ++m_impl->m_idleWaiters;
+  // discarded tasks never finish, so don't wait for them
+  while (m_impl->m_outstanding != 0 &&
+         !(m_impl->m_stopping && !m_impl->m_drain))
+    m_impl->m_idleCond.wait(lock);
+  --m_impl->m_idleWaiters;
+}
+
+void ThreadPool::Stop(bool drain) {
+  {
+    std::lock_guard<wpi::mutex> lock(m_impl->m_mutex);
+    if (m_impl->m_stopping) return;
+    m_impl->m_stopping = true;
+    m_impl->m_drain = drain;
+  }
+  for (auto& worker : m_workers) worker.Stop();
+
+  // Destroy discarded tasks now (outside the locks) so any futures waiting
+  // on them see a broken promise.
+  if (!drain) {
+    std::deque<Task> discard;
+    {
+      std::lock_guard<wpi::mutex> lock(m_impl->m_mutex);
+      discard.swap(m_impl->m_global);
+    }
+    for (auto& queue : m_impl->m_queues) {
+      std::deque<Task> tasks;
+      {
+        std::lock_guard<wpi::mutex> lock(queue->mutex);
+        tasks.swap(queue->tasks);
+      }
+      for (auto& task : tasks) discard.emplace_back(std::move(task));
+    }
+    m_impl->m_queued -= discard.size();
+    m_impl->m_outstanding -= discard.size();
+  }
+
+  // Workers sleep on the shared condition rather than their own m_cond.
+  std::lock_guard<wpi::mutex> lock(m_impl->m_mutex);
+  m_impl->m_workCond.notify_all();
+  m_impl->m_spaceCond.notify_all();
+  m_impl->m_idleCond.notify_all();
+}
+
+bool ThreadPool::IsWorkerThread() const {
+#ifdef HAVE_THREAD_LOCAL
+  return tl_pool == m_impl.get();
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,115 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/TimerService.h"
+
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "support/timestamp.h"
+
+using namespace wpi;
+
+constexpr TimerService::TimerId TimerService::kInvalidTimer;
+
+class TimerService::Thread : public SafeThread {
+ public:
+  Thread(Executor executor, uint64_t resolution)
+      : m_executor(std::move(executor)), m_wheel(Now(), resolution) {}
+
+  void Main() override;
+
+  Executor m_executor;  // read-only once started
+  TimerWheel m_wheel;
+  uint64_t m_wakeTime = TimerWheel::kNoTimer;
+};
+
+void TimerService::Thread::Main() {
+  std::vector<Callback> ready;
+  std::unique_lock<wpi::mutex> lock(m_mutex);
+  while (m_active) {
+    m_wheel.Advance(Now(), [&](Callback& callback, bool repeating) {
+      if (repeating)
+        ready.push_back(callback);
+      else
+        ready.emplace_back(std::move(callback));
+    });
+
+    if (!ready.empty()) {
+      // dispatch without the lock so callbacks can reschedule
+      lock.unlock();
+      for (auto& callback : ready) {
+        if (m_executor)
+          m_executor(std::move(callback));
+        else
+          callback();
+      }
+      ready.clear();
+      lock.lock();
+      continue;
+    }
+
+    m_wakeTime = m_wheel.GetNextExpiry();
+    if (m_wakeTime == TimerWheel::kNoTimer) {
+      m_cond.wait(lock);
+    } else {
+      uint64_t now = Now();
+      if (m_wakeTime > now)
+        m_cond.wait_for(lock, std::chrono::microseconds(m_wakeTime - now));
+    }
+    m_wakeTime = 0;  // awake; Add() need not notify
+  }
+}
+
+TimerService::TimerService() : TimerService(Executor()) {}
+
+TimerService::TimerService(Executor executor, uint64_t resolution) {
+  m_owner.Start(new Thread(std::move(executor), resolution));
+}
+
+TimerService::~TimerService() { Stop(); }
+
+TimerService::TimerId TimerService::Add(uint64_t time, uint64_t period,
+                                        Callback callback) {
+  auto thr = m_owner.GetThread();
+  if (!thr) return kInvalidTimer;
+  TimerId id = thr->m_wheel.Schedule(time, period, std::move(callback));
+  // wake the thread only if it is sleeping past the new deadline
+  if (time < thr->m_wakeTime) thr->m_cond.notify_one();
+  return id;
+}
+
+TimerService::TimerId TimerService::Schedule(uint64_t delay,
+                                             Callback callback) {
+  return Add(Now() + delay, 0, std::move(callback));
+}
+
+TimerService::TimerId TimerService::ScheduleAt(uint64_t time,
+                                               Callback callback) {
+  return Add(time, 0, std::move(callback));
+}
+
+TimerService::TimerId TimerService::SchedulePeriodic(uint64_t period,
+                                                     Callback callback) {
+  return Add(Now() + period, period, std::move(callback));
+}
+
+bool TimerService::Cancel(TimerId id) {
+  auto thr = m_owner.GetThread();
+  if (!thr) return false;
+  return thr->m_wheel.Cancel(id);
+}
+
+size_t TimerService::GetPending() const {
+  auto thr = m_owner.GetThread();
+  if (!thr) return 0;
+  return thr->m_wheel.size();
+}
+
+void TimerService::Stop() { m_owner.Stop(); }
@@ -0,0 +1,197 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/TimerWheel.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace wpi;
+
+constexpr TimerWheel::TimerId TimerWheel::kInvalidTimer;
+constexpr uint64_t TimerWheel::kNoTimer;
+constexpr int TimerWheel::kLevels;
+constexpr int TimerWheel::kSlotBits;
+constexpr uint32_t TimerWheel::kSlots;
+constexpr uint32_t TimerWheel::kNil;
+
+// Index of the lowest set bit; word must be nonzero.
+static unsigned int LowestBit(uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return index;
+#else
+  unsigned int index = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+// Returns the distance (1 to 256) from slot `from` to the next set bit in a
+// 256-bit occupancy map, wrapping around and ending at `from` itself, or 0 if
+// the map is empty.
+static unsigned int NextOccupied(const uint64_t* bits, unsigned int from) {
+  unsigned int start = (from + 1) & 255;
+  // finish the word containing start, then whole words, then the remainder
+  for (unsigned int scanned = 0; scanned < 256 + 64;) {
+    unsigned int pos = (start + scanned) & 255;
+    uint64_t word = bits[pos >> 6] >> (pos & 63);
+    if (word != 0) {
+      unsigned int dist = scanned + LowestBit(word) + 1;
+      return dist <= 256 ? dist : 0;
+    }
+    scanned += 64 - (pos & 63);
+  }
+  return 0;
+}
+
+TimerWheel::TimerWheel(uint64_t now, uint64_t resolution)
+    : m_resolution(resolution == 0 ? 1 : resolution),
+      m_tick(now / m_resolution) {
+  std::fill(std::begin(m_heads), std::end(m_heads), kNil);
+  std::memset(m_occupied, 0, sizeof(m_occupied));
+}
+
+TimerWheel::Node* TimerWheel::Lookup(TimerId id) {
+  uint32_t index = static_cast<uint32_t>(id);
+  if (index >= m_nodes.size()) return nullptr;
+  Node& node = m_nodes[index];
+  if (node.generation != static_cast<uint32_t>(id >> 32)) return nullptr;
+  return &node;
+}
+
+const TimerWheel::Node* TimerWheel::Lookup(TimerId id) const {
+  return const_cast<TimerWheel*>(this)->Lookup(id);
+}
+
+uint32_t TimerWheel::Allocate() {
+  if (m_freeHead != kNil) {
+    uint32_t index = m_freeHead;
+    m_freeHead = m_nodes[index].next;
+    return index;
+  }
+  m_nodes.emplace_back();
+  return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void TimerWheel::Free(uint32_t index) {
+  Node& node = m_nodes[index];
+  node.callback = nullptr;
+  if (node.generation == 0) node.generation = 1;  // keep ids nonzero
+  node.next = m_freeHead;
+  m_freeHead = index;
+}
+
+void TimerWheel::Insert(uint32_t index) {
+  Node& node = m_nodes[index];
+  // Cascaded timers may be due this very tick; they go into the current
+  // level 0 slot, which Expire() is about to process.
+  uint64_t expires = std::max(node.expires, m_tick);
+  uint64_t delta = expires - m_tick;
+  int level = 0;
+  while (level < kLevels - 1 &&
+         delta >= (static_cast<uint64_t>(1) << (kSlotBits * (level + 1))))
+    ++level;
+  if (level == kLevels - 1) {
+    // park timers beyond the wheel's range in the furthest top-level slot
+    uint64_t range = static_cast<uint64_t>(1) << (kSlotBits * kLevels);
+    if (delta >= range) expires = m_tick + range - 1;
+  }
+  uint32_t slot =
+      static_cast<uint32_t>(expires >> (kSlotBits * level)) & (kSlots - 1);
+  uint32_t list = level * kSlots + slot;
+
+  node.list = list;
+  node.prev = kNil;
+  node.next = m_heads[list];
+  if (node.next != kNil) m_nodes[node.next].prev = index;
+  m_heads[list] = index;
+  m_occupied[level][slot >> 6] |= static_cast<uint64_t>(1) << (slot & 63);
+}
+
+void TimerWheel::Unlink(uint32_t index) {
+  Node& node = m_nodes[index];
+  uint32_t list = node.list;
+  if (node.prev != kNil)
+    m_nodes[node.prev].next = node.next;
+  else
+    m_heads[list] = node.next;
+  if (node.next != kNil) m_nodes[node.next].prev = node.prev;
+  if (m_heads[list] == kNil) {
+    uint32_t slot = list & (kSlots - 1);
+    m_occupied[list / kSlots][slot >> 6] &=
+        ~(static_cast<uint64_t>(1) << (slot & 63));
+  }
+  node.list = kNil;
+  node.prev = node.next = kNil;
+}
+
+void TimerWheel::Cascade(int level) {
+  uint32_t slot =
+      static_cast<uint32_t>(m_tick >> (kSlotBits * level)) & (kSlots - 1);
+  uint32_t list = level * kSlots + slot;
+  uint32_t index;
+  while ((index = m_heads[list]) != kNil) {
+    Unlink(index);
+    Insert(index);
+  }
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t time, uint64_t period,
+                                         Callback callback) {
+  uint32_t index = Allocate();
+  Node& node = m_nodes[index];
+  node.expires = std::max(ToTick(time), m_tick + 1);
+  node.period = period == 0 ? 0 : std::max(ToTick(period), uint64_t{1});
+  node.callback = std::move(callback);
+  Insert(index);
+  ++m_count;
+  return MakeId(index, node.generation);
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+  Node* node = Lookup(id);
+  if (!node) return false;
+  uint32_t index = static_cast<uint32_t>(id);
+  ++node->generation;
+  --m_count;
+  // a firing node is unlinked and freed by Expire() once the visitor returns
+  if (node->firing) return true;
+  Unlink(index);
+  Free(index);
+  return true;
+}
+
+bool TimerWheel::IsPending(TimerId id) const { return Lookup(id) != nullptr; }
+
+uint64_t TimerWheel::GetNextExpiry() const {
+  if (m_count == 0) return kNoTimer;
+  uint64_t best = kNoTimer;
+  for (int level = 0; level < kLevels; ++level) {
+    unsigned int shift = kSlotBits * level;
+    unsigned int current =
+        static_cast<unsigned int>(m_tick >> shift) & (kSlots - 1);
+    unsigned int dist = NextOccupied(m_occupied[level], current);
+    if (dist == 0) continue;
+    // level 0 slots hold exactly one tick; higher slots are cascaded when
+    // the wheel reaches the start of their span
+    uint64_t tick = ((m_tick >> shift) + dist) << shift;
+    best = std::min(best, tick);
+  }
+  return best == kNoTimer ? best : best * m_resolution;
+}
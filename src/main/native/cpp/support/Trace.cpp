@@ -0,0 +1,234 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Trace.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "support/SPSCQueue.h"
+#include "support/condition_variable.h"
+#include "support/json.h"
+#include "support/mutex.h"
+
+using namespace wpi;
+
+std::atomic<bool> detail::gTraceRecording{false};
+
+namespace {
+
+struct Span {
+  const char* name;
+  uint64_t begin;
+  uint64_t end;
+};
+
+struct Ring {
+  Ring(size_t capacity, uint32_t thread_) : queue(capacity), thread(thread_) {}
+
+  SPSCQueue<Span> queue;
+  const uint32_t thread;             // Chrome "tid"
+  std::atomic<uint64_t> dropped{0};  // written only by the owning thread
+  std::atomic<bool> exited{false};   // owning thread has exited
+};
+
+struct Registry {
+  wpi::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+  uint32_t nextThread = 1;
+  uint64_t exitedDropped = 0;  // drops from rings already removed
+  size_t ringCapacity = 4096;
+  bool owned = false;  // a recorder is recording
+};
+
+Registry& GetRegistry() {
+  // Never destroyed: threads may still record while statics are destroyed.
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+// Marks the thread's ring for removal once it is drained.
+struct RingHolder {
+  ~RingHolder() {
+    if (ring) ring->exited.store(true, std::memory_order_release);
+  }
+  std::shared_ptr<Ring> ring;
+};
+
+uint64_t TotalDropped(Registry& registry) {
+  uint64_t dropped = registry.exitedDropped;
+  for (auto& ring : registry.rings)
+    dropped += ring->dropped.load(std::memory_order_relaxed);
+  return dropped;
+}
+
+}  // namespace
+
+void detail::TraceRecord(const char* name, uint64_t begin, uint64_t end) {
+  // a span that began just before recording stopped
+  if (!IsTraceRecording()) return;
+  static thread_local RingHolder holder;
+  if (!holder.ring) {
+    auto& registry = GetRegistry();
+    std::lock_guard<wpi::mutex> lock(registry.mutex);
+    holder.ring =
+        std::make_shared<Ring>(registry.ringCapacity, registry.nextThread++);
+    registry.rings.push_back(holder.ring);
+  }
+  if (!holder.ring->queue.try_push(Span{name, begin, end}))
+    holder.ring->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct TraceRecorder::Shared {
+  Shared(llvm::raw_ostream& os_, const Options& options_)
+      : os(os_), options(options_) {}
+
+  llvm::raw_ostream& os;  // only used by the export thread after Start()
+  const Options options;
+  bool started = false;
+  bool stopped = false;
+  uint64_t droppedBase = 0;
+
+  wpi::mutex exitMutex;
+  wpi::condition_variable exitCond;
+  bool threadExited = false;
+};
+
+class TraceRecorder::Thread : public SafeThread {
+ public:
+  explicit Thread(std::shared_ptr<Shared> shared)
+      : m_shared(std::move(shared)) {}
+
+  void Main() override;
+
+ private:
+  void Export();
+
+  std::shared_ptr<Shared> m_shared;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+  bool m_first = true;
+};
+
+void TraceRecorder::Thread::Main() {
+  std::unique_lock<wpi::mutex> lock(m_mutex);
+  while (m_active) {
+    m_cond.wait_for(lock, m_shared->options.exportInterval);
+    if (!m_active) break;
+    lock.unlock();
+    Export();
+    lock.lock();
+  }
+  lock.unlock();
+
+  Export();
+  m_shared->os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  m_shared->os.flush();
+  {
+    std::lock_guard<wpi::mutex> exitLock(m_shared->exitMutex);
+    m_shared->threadExited = true;
+  }
+  m_shared->exitCond.notify_all();
+}
+
+void TraceRecorder::Thread::Export() {
+  auto& registry = GetRegistry();
+  {
+    std::lock_guard<wpi::mutex> lock(registry.mutex);
+    m_rings = registry.rings;
+  }
+
+  llvm::raw_ostream& os = m_shared->os;
+  bool removeExited = false;
+  for (auto& ring : m_rings) {
+    // read exited first so spans pushed just before exit are not missed
+    bool exited = ring->exited.load(std::memory_order_acquire);
+    for (;;) {
+      auto spans = ring->queue.peek();
+      if (spans.empty()) break;
+      for (const Span& span : spans) {
+        json event = {{"name", span.name},
+                      {"ph", "X"},
+                      {"ts", span.begin},
+                      {"dur", span.end - span.begin},
+                      {"pid", 1},
+                      {"tid", ring->thread}};
+        if (!m_first) os << ",\n";
+        m_first = false;
+        os << event;
+      }
+      ring->queue.consume(spans.size());
+    }
+    if (exited) removeExited = true;
+  }
+  os.flush();
+
+  if (removeExited) {
+    std::lock_guard<wpi::mutex> lock(registry.mutex);
+    auto& rings = registry.rings;
+    for (auto it = rings.begin(); it != rings.end();) {
+      if ((*it)->exited.load(std::memory_order_acquire) &&
+          (*it)->queue.empty()) {
+        registry.exitedDropped += (*it)->dropped.load();
+        it = rings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  m_rings.clear();
+}
+
+TraceRecorder::TraceRecorder(llvm::raw_ostream& os)
+    : TraceRecorder(os, Options()) {}
+
+TraceRecorder::TraceRecorder(llvm::raw_ostream& os, const Options& options)
+    : m_shared(std::make_shared<Shared>(os, options)) {}
+
+TraceRecorder::~TraceRecorder() { Stop(); }
+
+bool TraceRecorder::Start() {
+  auto& registry = GetRegistry();
+  {
+    std::lock_guard<wpi::mutex> lock(registry.mutex);
+    if (registry.owned || m_shared->started) return false;
+    registry.owned = true;
+    registry.ringCapacity = m_shared->options.ringCapacity;
+    // discard spans that ended after the previous recording stopped
+    for (auto& ring : registry.rings) {
+      while (!ring->queue.empty())
+        ring->queue.consume(ring->queue.peek().size());
+    }
+    m_shared->droppedBase = TotalDropped(registry);
+  }
+  m_shared->started = true;
+  m_shared->os << "{\"traceEvents\":[\n";
+  m_owner.Start(new Thread(m_shared));
+  detail::gTraceRecording.store(true, std::memory_order_release);
+  return true;
+}
+
+void TraceRecorder::Stop() {
+  if (!m_shared->started || m_shared->stopped) return;
+  m_shared->stopped = true;
+  detail::gTraceRecording.store(false, std::memory_order_release);
+  m_owner.Stop();
+  {
+    // wait for the final export so the stream is not used after we return
+    std::unique_lock<wpi::mutex> lock(m_shared->exitMutex);
+    while (!m_shared->threadExited) m_shared->exitCond.wait(lock);
+  }
+  auto& registry = GetRegistry();
+  std::lock_guard<wpi::mutex> lock(registry.mutex);
+  registry.owned = false;
+}
+
+uint64_t TraceRecorder::GetDropped() const {
+  auto& registry = GetRegistry();
+  std::lock_guard<wpi::mutex> lock(registry.mutex);
+  return TotalDropped(registry) - m_shared->droppedBase;
+}
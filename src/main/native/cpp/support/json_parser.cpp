@@ -41,6 +41,7 @@ SOFTWARE.
 #include "llvm/Format.h"
 #include "llvm/raw_ostream.h"
 #include "llvm/SmallString.h"
+#include "support/Metrics.h"
 #include "support/raw_istream.h"
 
 using namespace wpi;
@@ -2073,14 +2074,23 @@ void json::parser::unexpect(lexer::token_type t) const
     }
 }
 
+static wpi::LatencyHistogram& ParseLatency()
+{
+    static wpi::LatencyHistogram& hist =
+        wpi::MetricsRegistry::GetInstance().GetHistogram("json.parse_ns");
+    return hist;
+}
+
 json json::parse(llvm::StringRef s, const parser_callback_t cb)
 {
+    wpi::ScopedLatency timer(ParseLatency());
     wpi::raw_mem_istream is(s.data(), s.size());
     return parser(is, cb).parse(true);
 }
 
 json json::parse(wpi::raw_istream& i, const parser_callback_t cb)
 {
+    wpi::ScopedLatency timer(ParseLatency());
     return parser(i, cb).parse(true);
 }
 
@@ -0,0 +1,38 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/priority_condition_variable.h"
+
+#ifdef WPI_HAVE_PRIORITY_CONDITION_VARIABLE
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace wpi;
+
+bool detail::FutexWait(std::atomic<uint32_t>& word, uint32_t value,
+                       const struct timespec* deadline) noexcept {
+  // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline (plain
+  // FUTEX_WAIT takes a relative one).
+  long rv = syscall(SYS_futex,  // NOLINT(runtime/int)
+                    reinterpret_cast<uint32_t*>(&word),
+                    FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, value, deadline,
+                    nullptr, FUTEX_BITSET_MATCH_ANY);
+  if (rv == 0) return true;
+  // EAGAIN: already notified; EINTR: spurious wakeup; EINVAL: deadline
+  // before the clock's epoch, i.e. already passed
+  return errno != ETIMEDOUT && errno != EINVAL;
+}
+
+void detail::FutexWake(std::atomic<uint32_t>& word, int count) noexcept {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+          FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, 0);
+}
+
+#endif  // WPI_HAVE_PRIORITY_CONDITION_VARIABLE
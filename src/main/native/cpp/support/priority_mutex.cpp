@@ -0,0 +1,139 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/priority_mutex.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+using namespace wpi;
+
+namespace {
+
+// Upper bound on spin iterations before sleeping in the kernel.
+constexpr int kMaxSpins = 100;
+
+std::atomic<bool> gStatsEnabled{false};
+std::atomic<uint64_t> gContended{0};
+std::atomic<uint64_t> gSpinAcquired{0};
+std::atomic<uint64_t> gSleeps{0};
+std::atomic<uint64_t> gWakes{0};
+
+inline void Count(std::atomic<uint64_t>& counter) {
+  if (gStatsEnabled.load(std::memory_order_relaxed))
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void CpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+  __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+bool IsMultiprocessor() {
+  static const bool multi = std::thread::hardware_concurrency() > 1;
+  return multi;
+}
+
+long Futex(std::atomic<uint32_t>& word, int op) {  // NOLINT(runtime/int)
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+                 op | FUTEX_PRIVATE_FLAG, 0, nullptr, nullptr, 0);
+}
+
+}  // namespace
+
+// The child of fork() runs in the forking thread under a new tid, so the
+// cached one would make unlock() of a lock taken in the child fail.
+static void RefreshTidAfterFork() {
+  detail::CachedTid() = detail::GetCurrentTid();
+}
+
+uint32_t detail::GetCurrentTid() noexcept {
+  static int registered = pthread_atfork(nullptr, nullptr, RefreshTidAfterFork);
+  static_cast<void>(registered);
+  return static_cast<uint32_t>(syscall(SYS_gettid));
+}
+
+void detail::FutexLockPI(std::atomic<uint32_t>& word,
+                         std::atomic<int16_t>& spins, uint32_t tid) {
+  Count(gContended);
+
+  // Spin while the lock looks like it will be released soon.  The budget
+  // tracks how long recent acquisitions of this mutex took (as glibc's
+  // adaptive mutexes do).  Once a waiter is queued in the kernel, unlock
+  // hands the lock straight to it, so spinning is pointless.
+  if (IsMultiprocessor()) {
+    int estimate = spins.load(std::memory_order_relaxed);
+    int budget = std::min(kMaxSpins, estimate * 2 + 10);
+    for (int count = 0; count < budget; ++count) {
+      uint32_t value = word.load(std::memory_order_relaxed);
+      if (value == 0) {
+        if (word.compare_exchange_weak(value, tid, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+          spins.store(static_cast<int16_t>(estimate + (count - estimate) / 8),
+                      std::memory_order_relaxed);
+          Count(gSpinAcquired);
+          return;
+        }
+      } else if ((value & FUTEX_WAITERS) != 0) {
+        break;
+      }
+      CpuRelax();
+    }
+    spins.store(static_cast<int16_t>(estimate + (budget - estimate) / 8),
+                std::memory_order_relaxed);
+  }
+
+  // The kernel sets the waiters bit, boosts the owner, and returns once the
+  // lock has been handed to us.
+  Count(gSleeps);
+  for (;;) {
+    if (Futex(word, FUTEX_LOCK_PI) == 0) return;
+    // EAGAIN: the owner is exiting; EINTR: retry
+    if (errno != EAGAIN && errno != EINTR) std::terminate();
+  }
+}
+
+void detail::FutexUnlockPI(std::atomic<uint32_t>& word) {
+  // The waiters bit is set; the kernel picks the highest priority waiter
+  // and makes it the owner.
+  Count(gWakes);
+  if (Futex(word, FUTEX_UNLOCK_PI) != 0) std::terminate();
+}
+
+void wpi::SetPriorityMutexStatsEnabled(bool enabled) {
+  gStatsEnabled = enabled;
+}
+
+priority_mutex_stats wpi::GetPriorityMutexStats() {
+  priority_mutex_stats stats;
+  stats.contended = gContended.load(std::memory_order_relaxed);
+  stats.spin_acquired = gSpinAcquired.load(std::memory_order_relaxed);
+  stats.sleeps = gSleeps.load(std::memory_order_relaxed);
+  stats.wakes = gWakes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void wpi::ResetPriorityMutexStats() {
+  gContended = 0;
+  gSpinAcquired = 0;
+  gSleeps = 0;
+  gWakes = 0;
+}
+
+#endif  // __linux__
@@ -7,25 +7,76 @@
 
 #include "support/raw_socket_istream.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "tcpsockets/NetworkStream.h"
 
 using namespace wpi;
 
+raw_socket_istream::raw_socket_istream(NetworkStream& stream, int timeout,
+                                       size_t bufSize)
+    : m_stream(stream),
+      m_timeout(timeout),
+      m_buf(new char[bufSize]),
+      m_bufSize(bufSize) {}
+
+bool raw_socket_istream::fill() {
+  NetworkStream::Error err;
+  size_t count = m_stream.receive(m_buf.get(), m_bufSize, &err, m_timeout);
+  if (count == 0) {
+    error_detected();
+    return false;
+  }
+  m_cur = 0;
+  m_end = count;
+  return true;
+}
+
 void raw_socket_istream::read_impl(void* data, size_t len) {
   char* cdata = static_cast<char*>(data);
-  size_t pos = 0;
+
+  // buffered data first
+  size_t avail = m_end - m_cur;
+  if (avail >= len) {
+    std::memcpy(cdata, &m_buf[m_cur], len);
+    m_cur += len;
+    return;
+  }
+  std::memcpy(cdata, &m_buf[m_cur], avail);
+  m_cur = m_end = 0;
+  size_t pos = avail;
 
   while (pos < len) {
-    NetworkStream::Error err;
-    size_t count = m_stream.receive(&cdata[pos], len - pos, &err, m_timeout);
-    if (count == 0) {
-      error_detected();
-      return;
+    // large reads bypass the buffer
+    if (len - pos >= m_bufSize) {
+      NetworkStream::Error err;
+      size_t count =
+          m_stream.receive(&cdata[pos], len - pos, &err, m_timeout);
+      if (count == 0) {
+        error_detected();
+        return;
+      }
+      pos += count;
+      continue;
     }
+    if (!fill()) return;
+    size_t count = std::min(m_end, len - pos);
+    std::memcpy(&cdata[pos], m_buf.get(), count);
+    m_cur = count;
     pos += count;
   }
 }
 
 void raw_socket_istream::close() { m_stream.close(); }
 
-size_t raw_socket_istream::in_avail() const { return 0; }
+size_t raw_socket_istream::in_avail() const { return m_end - m_cur; }
+
+llvm::StringRef raw_socket_istream::peek() {
+  if (m_cur == m_end && !fill()) return llvm::StringRef{};
+  return llvm::StringRef{&m_buf[m_cur], m_end - m_cur};
+}
+
+void raw_socket_istream::consume(size_t len) {
+  m_cur += std::min(len, m_end - m_cur);
+}
@@ -30,6 +30,29 @@ void raw_socket_ostream::write_impl(const char* data, size_t len) {
   }
 }
 
+// Sends the buffered data and a large write together, so a header and
+// payload go out in one syscall (and one segment when possible).
+void raw_socket_ostream::writev_impl(const char* buffered, size_t bufferedLen,
+                                     const char* data, size_t len) {
+  llvm::StringRef bufs[2] = {llvm::StringRef(buffered, bufferedLen),
+                             llvm::StringRef(data, len)};
+  llvm::MutableArrayRef<llvm::StringRef> remaining(bufs);
+  while (!remaining.empty()) {
+    NetworkStream::Error err;
+    size_t count = m_stream.sendv(remaining, &err);
+    if (count == 0) {
+      error_detected();
+      return;
+    }
+    while (!remaining.empty() && count >= remaining.front().size()) {
+      count -= remaining.front().size();
+      remaining = remaining.drop_front();
+    }
+    if (!remaining.empty())
+      remaining.front() = remaining.front().drop_front(count);
+  }
+}
+
 uint64_t raw_socket_ostream::current_pos() const { return 0; }
 
 void raw_socket_ostream::close() {
@@ -8,15 +8,36 @@
 #include "support/timestamp.h"
 
 #include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
 
 #ifdef _WIN32
 #include <windows.h>
 
 #include <cassert>
 #include <exception>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WPI_TSC_X86
+#ifdef _MSC_VER
+#include <intrin.h>
 #else
-#include <chrono>
+#include <cpuid.h>
+#include <x86intrin.h>
 #endif
+#elif defined(__aarch64__)
+#define WPI_TSC_ARM64
+#endif
+
+#include "support/SeqLock.h"
+#include "support/mutex.h"
+#include "timestamp_tsc.h"
+
+using wpi::detail::TscParams;
+using wpi::detail::kTscMaxSlewNs;
+using wpi::detail::kTscResyncNs;
 
 // offset in microseconds
 static uint64_t zerotime() {
@@ -69,12 +90,170 @@ static uint64_t update_frequency() {
 }
 #endif
 
+static uint64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 static const uint64_t zerotime_val = zerotime();
 static const uint64_t offset_val = timestamp();
+static const uint64_t offset_ns_val = steady_ns();
 #ifdef _WIN32
 static const uint64_t frequency_val = update_frequency();
 #endif
 
+// Operating system monotonic time in nanoseconds, in the NowDefault() epoch.
+static uint64_t monotonic_ns() {
+  return zerotime_val * 1000u + steady_ns() - offset_ns_val;
+}
+
+TscParams wpi::detail::TscResync(const TscParams& old, uint64_t tsc,
+                                 uint64_t clock) {
+  TscParams params;
+  params.tsc = tsc;
+  params.ns = old.ns + TscScale(tsc - old.tsc, old.mult);
+  params.resync = old.resync;
+  if (clock > params.ns + kTscMaxSlewNs) {
+    // far behind (e.g. the counter stopped); catch up at once
+    params.ns = clock;
+    params.mult = old.mult;
+  } else if (params.ns > clock + kTscMaxSlewNs) {
+    // far ahead (e.g. a rate error accumulated over an idle gap); run slower
+    // than the clock, at no less than half speed, until it catches up
+    uint64_t ahead = std::min(params.ns - clock, kTscResyncNs / 2);
+    params.mult = ((kTscResyncNs - ahead) << 32) / params.resync;
+    if (params.mult == 0) params.mult = 1;
+  } else {
+    // aim to meet the clock one resync period from now
+    params.mult = ((clock + kTscResyncNs - params.ns) << 32) / params.resync;
+  }
+  return params;
+}
+
+#if defined(WPI_TSC_X86) || defined(WPI_TSC_ARM64)
+#define WPI_HAVE_TSC_IMPL
+
+// The timestamp counter is converted to time as described in
+// timestamp_tsc.h.  The initial rate is measured against the monotonic clock
+// on first use.  After about a second of counter ticks, the next caller
+// re-measures and adjusts the rate with TscResync() so the extrapolation
+// converges on the monotonic clock; the anchor stays on the extrapolated
+// line, so time never jumps backwards.  Readers get the parameters from a
+// SeqLock and never block.
+
+// 0: not yet calibrated, 1: available, -1: unavailable
+static std::atomic<int> tsc_state{0};
+static wpi::mutex tsc_calibrate_mutex;
+static std::atomic_flag tsc_resyncing = ATOMIC_FLAG_INIT;
+static wpi::SeqLock<TscParams> tsc_params;
+
+static inline uint64_t read_tsc() {
+#ifdef WPI_TSC_X86
+  return __rdtsc();
+#else
+  uint64_t value;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+#endif
+}
+
+// Returns the counter frequency if the hardware reports it, otherwise 0.
+static uint64_t tsc_frequency() {
+#ifdef WPI_TSC_ARM64
+  uint64_t value;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(value));
+  return value;
+#else
+  return 0;
+#endif
+}
+
+static bool tsc_supported() {
+#ifdef WPI_TSC_X86
+  // invariant TSC: CPUID 0x80000007 EDX bit 8
+#ifdef _MSC_VER
+  int regs[4];
+  __cpuid(regs, 0x80000000);
+  if (static_cast<unsigned int>(regs[0]) < 0x80000007u) return false;
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+  return (edx & (1u << 8)) != 0;
+#endif
+#else
+  return tsc_frequency() != 0;
+#endif
+}
+
+// Reads the counter and the clock as close together as possible.
+static uint64_t read_tsc_and_clock(uint64_t* ns) {
+  uint64_t best = UINT64_MAX;
+  uint64_t tsc = 0;
+  for (int i = 0; i < 5; ++i) {
+    uint64_t before = read_tsc();
+    uint64_t now = monotonic_ns();
+    uint64_t after = read_tsc();
+    if (after - before < best) {
+      best = after - before;
+      tsc = before + (after - before) / 2;
+      *ns = now;
+    }
+  }
+  return tsc;
+}
+
+static bool tsc_calibrate() {
+  std::lock_guard<wpi::mutex> lock(tsc_calibrate_mutex);
+  int state = tsc_state.load(std::memory_order_acquire);
+  if (state != 0) return state > 0;
+  if (!tsc_supported()) {
+    tsc_state.store(-1, std::memory_order_release);
+    return false;
+  }
+
+  TscParams params;
+  uint64_t ns0;
+  uint64_t tsc0 = read_tsc_and_clock(&ns0);
+  uint64_t hz = tsc_frequency();
+  if (hz != 0) {
+    params.tsc = read_tsc_and_clock(&params.ns);
+    params.mult = (uint64_t(1000000000) << 32) / hz;
+  } else {
+    // measure over 2 ms; resynchronization refines the rate later
+    do {
+      params.tsc = read_tsc_and_clock(&params.ns);
+    } while (params.ns - ns0 < 2000000);
+    params.mult = ((params.ns - ns0) << 32) / (params.tsc - tsc0);
+  }
+  if (params.mult == 0) {
+    tsc_state.store(-1, std::memory_order_release);
+    return false;
+  }
+  params.resync = (kTscResyncNs << 32) / params.mult;
+  tsc_params.Store(params);
+  tsc_state.store(1, std::memory_order_release);
+  return true;
+}
+
+static void tsc_resync(const TscParams& old) {
+  if (tsc_resyncing.test_and_set(std::memory_order_acquire)) return;
+  // old may be stale: another thread may have published new parameters and
+  // cleared the flag since the caller loaded it, and extrapolating from an
+  // old anchor would step time backwards
+  if (tsc_params.Load().tsc != old.tsc) {
+    tsc_resyncing.clear(std::memory_order_release);
+    return;
+  }
+  uint64_t clock;
+  uint64_t tsc = read_tsc_and_clock(&clock);
+  tsc_params.Store(wpi::detail::TscResync(old, tsc, clock));
+  tsc_resyncing.clear(std::memory_order_release);
+}
+#endif  // WPI_TSC_X86 || WPI_TSC_ARM64
+
 uint64_t wpi::NowDefault() {
 #ifdef _WIN32
   assert(offset_val > 0u);
@@ -97,6 +276,33 @@ void wpi::SetNowImpl(uint64_t (*func)(void)) {
 
 uint64_t wpi::Now() { return (now_impl.load())(); }
 
+bool wpi::HaveTsc() {
+#ifdef WPI_HAVE_TSC_IMPL
+  int state = tsc_state.load(std::memory_order_acquire);
+  if (state == 0) return tsc_calibrate();
+  return state > 0;
+#else
+  return false;
+#endif
+}
+
+uint64_t wpi::NowNs() {
+#ifdef WPI_HAVE_TSC_IMPL
+  if (HaveTsc()) {
+    TscParams params = tsc_params.Load();
+    uint64_t ticks = read_tsc() - params.tsc;
+    if (ticks > params.resync) tsc_resync(params);
+    return params.ns + wpi::detail::TscScale(ticks, params.mult);
+  }
+#endif
+  return monotonic_ns();
+}
+
+uint64_t wpi::NowTsc() {
+  if (!HaveTsc()) return NowDefault();
+  return NowNs() / 1000u;
+}
+
 extern "C" {
 
 uint64_t WPI_NowDefault(void) { return wpi::NowDefault(); }
@@ -105,4 +311,10 @@ void WPI_SetNowImpl(uint64_t (*func)(void)) { wpi::SetNowImpl(func); }
 
 uint64_t WPI_Now(void) { return wpi::Now(); }
 
+uint64_t WPI_NowNs(void) { return wpi::NowNs(); }
+
+uint64_t WPI_NowTsc(void) { return wpi::NowTsc(); }
+
+int WPI_HaveTsc(void) { return wpi::HaveTsc() ? 1 : 0; }
+
 }  // extern "C"
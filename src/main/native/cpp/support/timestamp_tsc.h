@@ -0,0 +1,55 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_TIMESTAMP_TSC_H_
+#define WPIUTIL_SUPPORT_TIMESTAMP_TSC_H_
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Internal to timestamp.cpp; exposed for tests.
+namespace wpi {
+namespace detail {
+
+// The timestamp counter is converted to time by linear extrapolation from an
+// anchor point: ns = anchor_ns + (tsc - anchor_tsc) * mult.
+struct TscParams {
+  uint64_t tsc;     // counter value at the anchor
+  uint64_t ns;      // time at the anchor
+  uint64_t mult;    // nanoseconds per tick, 32.32 fixed point
+  uint64_t resync;  // ticks after the anchor at which to resynchronize
+};
+
+constexpr uint64_t kTscResyncNs = 1000000000;
+// Corrections larger than this re-anchor on the clock instead of slewing.
+constexpr uint64_t kTscMaxSlewNs = 1000000;
+
+// ticks * mult >> 32 without overflow.
+inline uint64_t TscScale(uint64_t ticks, uint64_t mult) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  return static_cast<uint64_t>((static_cast<uint128>(ticks) * mult) >> 32);
+#else
+  uint64_t hi;
+  uint64_t lo = _umul128(ticks, mult, &hi);
+  return (hi << 32) | (lo >> 32);
+#endif
+}
+
+// Returns the parameters that follow old, given a counter value and the
+// clock read at the same moment.  The new anchor is on old's line (or ahead
+// of it, if the line fell far behind the clock), so time never goes
+// backwards.
+TscParams TscResync(const TscParams& old, uint64_t tsc, uint64_t clock);
+
+}  // namespace detail
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_TIMESTAMP_TSC_H_
@@ -0,0 +1,363 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef _WIN32
+
+#include "tcpsockets/EventLoop.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include "support/mutex.h"
+#include "support/timestamp.h"
+#include "tcpsockets/NetworkStream.h"
+#include "tcpsockets/TCPAcceptor.h"
+
+using namespace wpi;
+
+constexpr EventLoop::TimerId EventLoop::kInvalidTimer;
+
+namespace {
+
+struct Entry {
+  Entry(int fd_, unsigned int events_, uint32_t generation_,
+        EventLoop::Handler handler_)
+      : fd(fd_),
+        events(events_),
+        generation(generation_),
+        handler(std::move(handler_)) {}
+
+  int fd;
+  unsigned int events;
+  uint32_t generation;  // tells a reused fd number from the old one
+  EventLoop::Handler handler;
+  bool removed = false;
+};
+
+#ifdef __linux__
+constexpr int kMaxEpollEvents = 256;
+
+// The wakeup descriptor uses generation 0.
+uint64_t EpollKey(int fd, uint32_t generation) {
+  return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+uint32_t ToEpoll(unsigned int events) {
+  uint32_t ev = EPOLLET;
+  if (events & EventLoop::kReadable) ev |= EPOLLIN | EPOLLRDHUP;
+  if (events & EventLoop::kWritable) ev |= EPOLLOUT;
+  return ev;
+}
+#endif
+
+short ToPoll(unsigned int events) {  // NOLINT(runtime/int)
+  short ev = 0;                      // NOLINT(runtime/int)
+  if (events & EventLoop::kReadable) ev |= POLLIN;
+  if (events & EventLoop::kWritable) ev |= POLLOUT;
+  return ev;
+}
+
+}  // namespace
+
+struct EventLoop::Impl {
+  explicit Impl(Backend backend);
+  ~Impl();
+
+  void Wake();
+  void DrainWake();
+  void RunPosted();
+  int WaitTimeout(int timeout);
+  void Dispatch(const std::shared_ptr<Entry>& entry, unsigned int events);
+  void PollOnce(int timeout);
+#ifdef __linux__
+  void EpollOnce(int timeout);
+#endif
+
+  int epfd = -1;  // -1 for the poll backend
+  int wakeRead = -1;
+  int wakeWrite = -1;
+
+  std::unordered_map<int, std::shared_ptr<Entry>> entries;
+  uint32_t nextGeneration = 1;
+  TimerWheel timers;
+
+  // poll backend; rebuilt from entries when dirty
+  std::vector<pollfd> pollFds;
+  std::vector<std::shared_ptr<Entry>> pollEntries;
+  bool pollDirty = true;
+
+  wpi::mutex postMutex;
+  std::vector<Callback> posted;
+  std::vector<Callback> running;  // loop thread only
+  std::atomic<bool> wakePending{false};
+  std::atomic<bool> stopRequested{false};
+};
+
+EventLoop::Impl::Impl(Backend backend) : timers(WPI_Now()) {
+#ifdef __linux__
+  if (backend == kDefaultBackend) epfd = epoll_create1(EPOLL_CLOEXEC);
+  wakeRead = wakeWrite = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (epfd >= 0 && wakeRead >= 0) {
+    epoll_event ev;
+    ev.events = EPOLLIN;  // level-triggered; drained on each wakeup
+    ev.data.u64 = EpollKey(wakeRead, 0);
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wakeRead, &ev);
+  }
+#else
+  static_cast<void>(backend);
+  int fds[2];
+  if (pipe(fds) == 0) {
+    for (int fd : fds) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    wakeRead = fds[0];
+    wakeWrite = fds[1];
+  }
+#endif
+}
+
+EventLoop::Impl::~Impl() {
+  if (epfd >= 0) close(epfd);
+  if (wakeRead >= 0) close(wakeRead);
+  if (wakeWrite >= 0 && wakeWrite != wakeRead) close(wakeWrite);
+}
+
+void EventLoop::Impl::Wake() {
+  if (wakeWrite < 0) return;
+  uint64_t one = 1;  // an eventfd requires 8 bytes; a pipe takes any
+  ssize_t rv = write(wakeWrite, &one, sizeof(one));
+  static_cast<void>(rv);  // a full pipe is already awake
+}
+
+void EventLoop::Impl::DrainWake() {
+  uint64_t buf[8];
+  while (read(wakeRead, buf, sizeof(buf)) > 0) {
+  }
+}
+
+void EventLoop::Impl::RunPosted() {
+  // clear the flag before taking the queue, so a Post() that misses this
+  // batch writes a new wakeup
+  wakePending.store(false, std::memory_order_seq_cst);
+  {
+    std::lock_guard<wpi::mutex> lock(postMutex);
+    running.swap(posted);
+  }
+  for (auto& func : running) func();
+  running.clear();
+}
+
+int EventLoop::Impl::WaitTimeout(int timeout) {
+  uint64_t next = timers.GetNextExpiry();
+  if (next == TimerWheel::kNoTimer) return timeout;
+  uint64_t now = WPI_Now();
+  uint64_t ms = next <= now ? 0 : (next - now + 999) / 1000;
+  if (timeout >= 0 && static_cast<uint64_t>(timeout) < ms) return timeout;
+  return static_cast<int>(std::min<uint64_t>(ms, INT32_MAX));
+}
+
+void EventLoop::Impl::Dispatch(const std::shared_ptr<Entry>& entry,
+                               unsigned int events) {
+  if (entry->removed) return;
+  events &= entry->events | kError;
+  if (events == 0) return;
+  // the caller's reference keeps the handler alive if it Remove()s itself
+  entry->handler(events);
+}
+
+void EventLoop::Impl::PollOnce(int timeout) {
+  if (pollDirty) {
+    pollFds.clear();
+    pollEntries.clear();
+    pollFds.push_back(pollfd{wakeRead, POLLIN, 0});
+    pollEntries.emplace_back();
+    for (auto& kv : entries) {
+      pollFds.push_back(pollfd{kv.first, ToPoll(kv.second->events), 0});
+      pollEntries.push_back(kv.second);
+    }
+    pollDirty = false;
+  }
+
+  int n = poll(pollFds.data(), pollFds.size(), timeout);
+  if (n <= 0) return;  // timeout or EINTR
+
+  // handlers may change the registrations, so work from copies
+  std::vector<std::pair<std::shared_ptr<Entry>, short>> ready;  // NOLINT
+  bool wake = false;
+  for (size_t i = 0; i < pollFds.size() && n > 0; ++i) {
+    if (pollFds[i].revents == 0) continue;
+    --n;
+    if (i == 0)
+      wake = true;
+    else
+      ready.emplace_back(pollEntries[i], pollFds[i].revents);
+  }
+  for (auto& r : ready) {
+    unsigned int events = 0;
+    if (r.second & POLLIN) events |= kReadable;
+    if (r.second & POLLOUT) events |= kWritable;
+    if (r.second & (POLLERR | POLLHUP | POLLNVAL)) events |= kError | kReadable;
+    Dispatch(r.first, events);
+  }
+  if (wake) {
+    DrainWake();
+    RunPosted();
+  }
+}
+
+#ifdef __linux__
+void EventLoop::Impl::EpollOnce(int timeout) {
+  epoll_event events[kMaxEpollEvents];
+  int n = epoll_wait(epfd, events, kMaxEpollEvents, timeout);
+  bool wake = false;
+  for (int i = 0; i < n; ++i) {
+    uint64_t key = events[i].data.u64;
+    int fd = static_cast<int>(key & 0xffffffffu);
+    uint32_t generation = static_cast<uint32_t>(key >> 32);
+    if (generation == 0) {
+      wake = true;
+      continue;
+    }
+    // skip events for descriptors removed (and perhaps re-added) by an
+    // earlier handler in this batch
+    auto it = entries.find(fd);
+    if (it == entries.end() || it->second->generation != generation) continue;
+    uint32_t ev = events[i].events;
+    unsigned int ready = 0;
+    if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLPRI)) ready |= kReadable;
+    if (ev & EPOLLOUT) ready |= kWritable;
+    if (ev & (EPOLLERR | EPOLLHUP)) ready |= kError | kReadable;
+    Dispatch(std::shared_ptr<Entry>(it->second), ready);
+  }
+  if (wake) {
+    DrainWake();
+    RunPosted();
+  }
+}
+#endif
+
+EventLoop::EventLoop(Backend backend) : m_impl(new Impl(backend)) {}
+
+EventLoop::~EventLoop() = default;
+
+bool EventLoop::IsEdgeTriggered() const { return m_impl->epfd >= 0; }
+
+bool EventLoop::Add(int fd, unsigned int events, Handler handler) {
+  if (fd < 0 || m_impl->entries.count(fd) != 0) return false;
+  uint32_t generation = m_impl->nextGeneration++;
+  if (generation == 0) generation = m_impl->nextGeneration++;
+#ifdef __linux__
+  if (m_impl->epfd >= 0) {
+    epoll_event ev;
+    ev.events = ToEpoll(events);
+    ev.data.u64 = EpollKey(fd, generation);
+    if (epoll_ctl(m_impl->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+  }
+#endif
+  m_impl->entries.emplace(
+      fd, std::make_shared<Entry>(fd, events, generation, std::move(handler)));
+  m_impl->pollDirty = true;
+  return true;
+}
+
+bool EventLoop::Add(NetworkStream& stream, unsigned int events,
+                    Handler handler) {
+  if (!stream.setBlocking(false)) return false;
+  return Add(stream.getNativeHandle(), events, std::move(handler));
+}
+
+bool EventLoop::Add(TCPAcceptor& acceptor, Handler handler) {
+  if (!acceptor.setBlocking(false)) return false;
+  return Add(acceptor.getNativeHandle(), kReadable, std::move(handler));
+}
+
+bool EventLoop::Modify(int fd, unsigned int events) {
+  auto it = m_impl->entries.find(fd);
+  if (it == m_impl->entries.end()) return false;
+#ifdef __linux__
+  if (m_impl->epfd >= 0) {
+    epoll_event ev;
+    ev.events = ToEpoll(events);
+    ev.data.u64 = EpollKey(fd, it->second->generation);
+    if (epoll_ctl(m_impl->epfd, EPOLL_CTL_MOD, fd, &ev) != 0) return false;
+  }
+#endif
+  it->second->events = events;
+  m_impl->pollDirty = true;
+  return true;
+}
+
+bool EventLoop::Remove(int fd) {
+  auto it = m_impl->entries.find(fd);
+  if (it == m_impl->entries.end()) return false;
+#ifdef __linux__
+  // fails harmlessly if fd was already closed
+  if (m_impl->epfd >= 0) epoll_ctl(m_impl->epfd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+  it->second->removed = true;
+  m_impl->entries.erase(it);
+  m_impl->pollDirty = true;
+  return true;
+}
+
+EventLoop::TimerId EventLoop::AddTimer(uint64_t delay, uint64_t period,
+                                       Callback callback) {
+  return m_impl->timers.Schedule(WPI_Now() + delay, period,
+                                 std::move(callback));
+}
+
+bool EventLoop::CancelTimer(TimerId id) { return m_impl->timers.Cancel(id); }
+
+void EventLoop::Post(Callback func) {
+  {
+    std::lock_guard<wpi::mutex> lock(m_impl->postMutex);
+    m_impl->posted.emplace_back(std::move(func));
+  }
+  if (!m_impl->wakePending.exchange(true)) m_impl->Wake();
+}
+
+void EventLoop::Run() {
+  while (RunOnce(-1)) {
+  }
+}
+
+bool EventLoop::RunOnce(int timeout) {
+  if (m_impl->stopRequested.exchange(false)) return false;
+  timeout = m_impl->WaitTimeout(timeout);
+#ifdef __linux__
+  if (m_impl->epfd >= 0)
+    m_impl->EpollOnce(timeout);
+  else
+#endif
+    m_impl->PollOnce(timeout);
+  m_impl->timers.Advance(WPI_Now(), [](Callback& callback, bool) {
+    callback();
+  });
+  return !m_impl->stopRequested.exchange(false);
+}
+
+void EventLoop::Stop() {
+  m_impl->stopRequested = true;
+  m_impl->Wake();
+}
+
+#endif  // _WIN32
@@ -0,0 +1,30 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/NetworkStream.h"
+
+using namespace wpi;
+
+size_t NetworkStream::sendv(llvm::ArrayRef<llvm::StringRef> bufs,
+                            Error* err) {
+  size_t total = 0;
+  for (auto buf : bufs) {
+    if (buf.empty()) continue;
+    size_t count = send(buf.data(), buf.size(), err);
+    total += count;
+    if (count < buf.size()) break;
+  }
+  return total;
+}
+
+size_t NetworkStream::receivev(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                               Error* err, int timeout) {
+  for (auto buf : bufs) {
+    if (!buf.empty()) return receive(buf.data(), buf.size(), err, timeout);
+  }
+  return 0;
+}
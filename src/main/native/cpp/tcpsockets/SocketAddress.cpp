@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/SocketAddress.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <Ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#include "llvm/SmallString.h"
+
+namespace wpi {
+
+int ParseSocketAddress(llvm::StringRef host, int port, sockaddr_storage* addr) {
+  llvm::SmallString<64> hostCopy(host);
+  hostCopy.push_back('\0');
+  std::memset(addr, 0, sizeof(*addr));
+
+  auto addr4 = reinterpret_cast<sockaddr_in*>(addr);
+#ifdef _WIN32
+  if (InetPton(AF_INET, hostCopy.data(), &addr4->sin_addr) == 1) {
+#else
+  if (inet_pton(AF_INET, hostCopy.data(), &addr4->sin_addr) == 1) {
+#endif
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    return sizeof(sockaddr_in);
+  }
+
+  auto addr6 = reinterpret_cast<sockaddr_in6*>(addr);
+#ifdef _WIN32
+  if (InetPton(AF_INET6, hostCopy.data(), &addr6->sin6_addr) == 1) {
+#else
+  if (inet_pton(AF_INET6, hostCopy.data(), &addr6->sin6_addr) == 1) {
+#endif
+    addr6->sin6_family = AF_INET6;
+    addr6->sin6_port = htons(port);
+    return sizeof(sockaddr_in6);
+  }
+  return 0;
+}
+
+int GetSocketAddressLength(const sockaddr* addr) {
+  switch (addr->sa_family) {
+    case AF_INET:
+      return sizeof(sockaddr_in);
+    case AF_INET6:
+      return sizeof(sockaddr_in6);
+    default:
+      return 0;
+  }
+}
+
+std::string GetSocketAddressHost(const sockaddr* addr) {
+  char buf[INET6_ADDRSTRLEN];
+  const void* src;
+  int family = addr->sa_family;
+  if (family == AF_INET) {
+    src = &reinterpret_cast<const sockaddr_in*>(addr)->sin_addr;
+  } else if (family == AF_INET6) {
+    auto addr6 = reinterpret_cast<const sockaddr_in6*>(addr);
+    src = &addr6->sin6_addr;
+    if (IN6_IS_ADDR_V4MAPPED(&addr6->sin6_addr)) {
+      family = AF_INET;
+      src = &addr6->sin6_addr.s6_addr[12];
+    }
+  } else {
+    return std::string{};
+  }
+#ifdef _WIN32
+  if (!InetNtop(family, const_cast<void*>(src), buf, sizeof(buf)))
+#else
+  if (!inet_ntop(family, src, buf, sizeof(buf)))
+#endif
+    return std::string{};
+  return buf;
+}
+
+int GetSocketAddressPort(const sockaddr* addr) {
+  switch (addr->sa_family) {
+    case AF_INET:
+      return ntohs(reinterpret_cast<const sockaddr_in*>(addr)->sin_port);
+    case AF_INET6:
+      return ntohs(reinterpret_cast<const sockaddr_in6*>(addr)->sin6_port);
+    default:
+      return 0;
+  }
+}
+
+}  // namespace wpi
@@ -23,8 +23,10 @@
 
 #include "tcpsockets/TCPAcceptor.h"
 
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <utility>
 
 #ifdef _WIN32
 #include <WinSock2.h>
@@ -34,15 +36,39 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <unistd.h>
 #endif
 
-#include "llvm/SmallString.h"
 #include "support/Logger.h"
+#include "tcpsockets/SocketAddress.h"
 #include "tcpsockets/SocketError.h"
 
 using namespace wpi;
 
+static void CloseSocket(int sd) {
+#ifdef _WIN32
+  closesocket(sd);
+#else
+  close(sd);
+#endif
+}
+
+// Returns true if a connection is pending on the listening socket.
+static bool IsPending(int sd) {
+#ifdef _WIN32
+  WSAPOLLFD pfd;
+  pfd.fd = sd;
+  pfd.events = POLLRDNORM;
+  return WSAPoll(&pfd, 1, 0) > 0;
+#else
+  pollfd pfd;
+  pfd.fd = sd;
+  pfd.events = POLLIN;
+  return poll(&pfd, 1, 0) > 0;
+#endif
+}
+
 TCPAcceptor::TCPAcceptor(int port, const char* address, Logger& logger)
     : m_lsd(0),
       m_port(port),
@@ -60,11 +86,7 @@ TCPAcceptor::TCPAcceptor(int port, const char* address, Logger& logger)
 TCPAcceptor::~TCPAcceptor() {
   if (m_lsd > 0) {
     shutdown();
-#ifdef _WIN32
-    closesocket(m_lsd);
-#else
-    close(m_lsd);
-#endif
+    CloseSocket(m_lsd);
   }
 #ifdef _WIN32
   WSACleanup();
@@ -74,31 +96,38 @@ TCPAcceptor::~TCPAcceptor() {
 int TCPAcceptor::start() {
   if (m_listening) return 0;
 
-  m_lsd = socket(PF_INET, SOCK_STREAM, 0);
+  struct sockaddr_storage address;
+  int addressLen;
+  if (m_address.empty()) {
+    auto address4 = reinterpret_cast<struct sockaddr_in*>(&address);
+    std::memset(&address, 0, sizeof(address));
+    address4->sin_family = AF_INET;
+    address4->sin_addr.s_addr = INADDR_ANY;
+    address4->sin_port = htons(m_port);
+    addressLen = sizeof(*address4);
+  } else {
+    addressLen = ParseSocketAddress(m_address, m_port, &address);
+    if (addressLen == 0) {
+      WPI_ERROR(m_logger, "could not resolve " << m_address << " address");
+      return -1;
+    }
+  }
+
+#ifdef SOCK_CLOEXEC
+  m_lsd = socket(address.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+  m_lsd = socket(address.ss_family, SOCK_STREAM, 0);
+#endif
   if (m_lsd < 0) {
     WPI_ERROR(m_logger, "could not create socket");
     return -1;
   }
-  struct sockaddr_in address;
 
-  std::memset(&address, 0, sizeof(address));
-  address.sin_family = PF_INET;
-  if (m_address.size() > 0) {
-#ifdef _WIN32
-    llvm::SmallString<128> addr_copy(m_address);
-    addr_copy.push_back('\0');
-    int res = InetPton(PF_INET, addr_copy.data(), &(address.sin_addr));
-#else
-    int res = inet_pton(PF_INET, m_address.c_str(), &(address.sin_addr));
-#endif
-    if (res != 1) {
-      WPI_ERROR(m_logger, "could not resolve " << m_address << " address");
-      return -1;
-    }
-  } else {
-    address.sin_addr.s_addr = INADDR_ANY;
+  if (address.ss_family == AF_INET6) {
+    int v6only = m_v6only ? 1 : 0;
+    setsockopt(m_lsd, IPPROTO_IPV6, IPV6_V6ONLY,
+               reinterpret_cast<char*>(&v6only), sizeof v6only);
   }
-  address.sin_port = htons(m_port);
 
 #ifdef _WIN32
   int optval = 1;
@@ -110,15 +139,27 @@ int TCPAcceptor::start() {
              sizeof optval);
 #endif
 
-  int result = bind(m_lsd, reinterpret_cast<struct sockaddr*>(&address),
-                    sizeof(address));
+#if defined(SO_REUSEPORT_LB)
+  if (m_reusePort) {
+    setsockopt(m_lsd, SOL_SOCKET, SO_REUSEPORT_LB,
+               reinterpret_cast<char*>(&optval), sizeof optval);
+  }
+#elif defined(__linux__) && defined(SO_REUSEPORT)
+  if (m_reusePort) {
+    setsockopt(m_lsd, SOL_SOCKET, SO_REUSEPORT,
+               reinterpret_cast<char*>(&optval), sizeof optval);
+  }
+#endif
+
+  int result =
+      bind(m_lsd, reinterpret_cast<struct sockaddr*>(&address), addressLen);
   if (result != 0) {
     WPI_ERROR(m_logger,
               "bind() to port " << m_port << " failed: " << SocketStrerror());
     return result;
   }
 
-  result = listen(m_lsd, 5);
+  result = listen(m_lsd, m_backlog);
   if (result != 0) {
     WPI_ERROR(m_logger,
               "listen() on port " << m_port << " failed: " << SocketStrerror());
@@ -135,25 +176,18 @@ void TCPAcceptor::shutdown() {
 
   // this is ugly, but the easiest way to do this
   // force wakeup of accept() with a non-blocking connect to ourselves
-  struct sockaddr_in address;
-
-  std::memset(&address, 0, sizeof(address));
-  address.sin_family = PF_INET;
-  llvm::SmallString<128> addr_copy;
-  if (m_address.size() > 0)
-    addr_copy = m_address;
-  else
-    addr_copy = "127.0.0.1";
-  addr_copy.push_back('\0');
-  int size = sizeof(address);
-  if (WSAStringToAddress(addr_copy.data(), PF_INET, nullptr,
-                         (struct sockaddr*)&address, &size) != 0)
-    return;
-  address.sin_port = htons(m_port);
+  llvm::StringRef target = m_address;
+  if (target.empty() || target == "0.0.0.0")
+    target = "127.0.0.1";
+  else if (target == "::")
+    target = "::1";
+  struct sockaddr_storage address;
+  int size = ParseSocketAddress(target, m_port, &address);
+  if (size == 0) return;
 
   fd_set sdset;
   struct timeval tv;
-  int result = -1, valopt, sd = socket(AF_INET, SOCK_STREAM, 0);
+  int result = -1, valopt, sd = socket(address.ss_family, SOCK_STREAM, 0);
   if (sd < 0) return;
 
   // Set socket to non-blocking
@@ -161,7 +195,7 @@ void TCPAcceptor::shutdown() {
   ioctlsocket(sd, FIONBIO, &mode);
 
   // Try to connect
-  ::connect(sd, (struct sockaddr*)&address, sizeof(address));
+  ::connect(sd, (struct sockaddr*)&address, size);
 
   // Close
   ::closesocket(sd);
@@ -179,27 +213,93 @@ void TCPAcceptor::shutdown() {
 std::unique_ptr<NetworkStream> TCPAcceptor::accept() {
   if (!m_listening || m_shutdown) return nullptr;
 
-  struct sockaddr_in address;
+  struct sockaddr_storage address;
 #ifdef _WIN32
   int len = sizeof(address);
 #else
   socklen_t len = sizeof(address);
 #endif
   std::memset(&address, 0, sizeof(address));
+#ifdef __linux__
+  // set the flags atomically rather than with separate fcntl() calls
+  int flags = SOCK_CLOEXEC;
+  if (!m_streamBlocking) flags |= SOCK_NONBLOCK;
+  int sd = ::accept4(m_lsd, (struct sockaddr*)&address, &len, flags);
+#else
   int sd = ::accept(m_lsd, (struct sockaddr*)&address, &len);
+#endif
   if (sd < 0) {
-    if (!m_shutdown)
+    int err = SocketErrno();
+#ifdef _WIN32
+    bool wouldBlock = err == WSAEWOULDBLOCK;
+#else
+    bool wouldBlock = err == EAGAIN || err == EWOULDBLOCK;
+#endif
+    if (!m_shutdown && !wouldBlock)
       WPI_ERROR(m_logger, "accept() on port "
-                              << m_port << " failed: " << SocketStrerror());
+                              << m_port << " failed: " << SocketStrerror(err));
     return nullptr;
   }
   if (m_shutdown) {
+    CloseSocket(sd);
+    return nullptr;
+  }
 #ifdef _WIN32
-    closesocket(sd);
-#else
-    close(sd);
+  if (!m_streamBlocking) {
+    u_long mode = 1;
+    ioctlsocket(sd, FIONBIO, &mode);
+  }
+#elif !defined(__linux__)
+  fcntl(sd, F_SETFD, FD_CLOEXEC);
+  if (!m_streamBlocking) fcntl(sd, F_SETFL, fcntl(sd, F_GETFL) | O_NONBLOCK);
 #endif
-    return nullptr;
+  auto stream =
+      new TCPStream(sd, reinterpret_cast<struct sockaddr*>(&address));
+  stream->m_blocking = m_streamBlocking;
+  return std::unique_ptr<NetworkStream>(stream);
+}
+
+size_t TCPAcceptor::acceptBatch(
+    std::vector<std::unique_ptr<NetworkStream>>* streams, size_t max) {
+  size_t count = 0;
+  while (count < max) {
+    // a blocking listener would wait for a connection that isn't there
+    if (count > 0 && m_blocking && !IsPending(m_lsd)) break;
+    auto stream = accept();
+    if (!stream) break;
+    streams->emplace_back(std::move(stream));
+    ++count;
   }
-  return std::unique_ptr<NetworkStream>(new TCPStream(sd, &address));
+  return count;
+}
+
+bool TCPAcceptor::setReusePort(bool enabled) {
+  // elsewhere (e.g. macOS), SO_REUSEPORT sends every connection to one socket
+#if defined(SO_REUSEPORT_LB) || (defined(__linux__) && defined(SO_REUSEPORT))
+  m_reusePort = enabled;
+  return true;
+#else
+  m_reusePort = false;
+  return !enabled;
+#endif
 }
+
+bool TCPAcceptor::setBlocking(bool enabled) {
+  if (!m_listening) return false;
+#ifdef _WIN32
+  u_long mode = enabled ? 0 : 1;
+  if (ioctlsocket(m_lsd, FIONBIO, &mode) == SOCKET_ERROR) return false;
+#else
+  int flags = fcntl(m_lsd, F_GETFL, nullptr);
+  if (flags < 0) return false;
+  if (enabled)
+    flags &= ~O_NONBLOCK;
+  else
+    flags |= O_NONBLOCK;
+  if (fcntl(m_lsd, F_SETFL, flags) < 0) return false;
+#endif
+  m_blocking = enabled;
+  return true;
+}
+
+int TCPAcceptor::getNativeHandle() const { return m_listening ? m_lsd : -1; }
@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/TCPAcceptorGroup.h"
+
+#include <chrono>
+#include <utility>
+
+#include "support/Logger.h"
+
+using namespace wpi;
+
+// Maximum connections accepted per wakeup before calling the handler.
+static constexpr size_t kAcceptBatch = 16;
+
+TCPAcceptorGroup::TCPAcceptorGroup(int port, const char* address,
+                                   Logger& logger, int numThreads)
+    : m_port(port),
+      m_address(address),
+      m_logger(logger),
+      m_numThreads(numThreads < 1 ? 1 : numThreads) {}
+
+TCPAcceptorGroup::~TCPAcceptorGroup() { shutdown(); }
+
+int TCPAcceptorGroup::start(Handler handler) {
+  if (!m_threads.empty()) return 0;
+  m_handler = std::move(handler);
+  m_shutdown = false;
+
+  int numSockets = m_numThreads;
+  for (int i = 0; i < numSockets; ++i) {
+    std::unique_ptr<TCPAcceptor> acceptor(
+        new TCPAcceptor(m_port, m_address.c_str(), m_logger));
+    acceptor->setBacklog(m_backlog);
+    if (numSockets > 1 && !acceptor->setReusePort(true)) {
+      WPI_DEBUG(m_logger, "SO_REUSEPORT unavailable; using one thread");
+      numSockets = 1;
+    }
+    if (acceptor->start() != 0) {
+      m_acceptors.clear();
+      return -1;
+    }
+    m_acceptors.emplace_back(std::move(acceptor));
+  }
+
+  // one thread per socket: shutdown() wakes exactly one accept() per socket
+  for (auto& acceptor : m_acceptors) {
+    TCPAcceptor* a = acceptor.get();
+    m_threads.emplace_back([this, a] { ThreadMain(*a); });
+  }
+  return 0;
+}
+
+void TCPAcceptorGroup::shutdown() {
+  m_shutdown = true;
+  for (auto& acceptor : m_acceptors) acceptor->shutdown();
+  for (auto& thread : m_threads) thread.join();
+  m_threads.clear();
+  m_acceptors.clear();
+}
+
+void TCPAcceptorGroup::ThreadMain(TCPAcceptor& acceptor) {
+  std::vector<std::unique_ptr<NetworkStream>> streams;
+  while (!m_shutdown) {
+    if (acceptor.acceptBatch(&streams, kAcceptBatch) == 0) {
+      // accept() failed (e.g. out of descriptors); don't spin
+      if (!m_shutdown)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+    for (auto& stream : streams) m_handler(std::move(stream));
+    streams.clear();
+  }
+}
@@ -25,9 +25,11 @@
 
 #include <fcntl.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 #ifdef _WIN32
 #include <WS2tcpip.h>
@@ -40,38 +42,17 @@
 #include <unistd.h>
 #endif
 
-#include "llvm/SmallString.h"
 #include "support/Logger.h"
+#include "tcpsockets/SocketAddress.h"
 #include "tcpsockets/SocketError.h"
 #include "tcpsockets/TCPStream.h"
 
-using namespace wpi;
+#include "TCPConnector_internal.h"
 
-static int ResolveHostName(const char* hostname, struct in_addr* addr) {
-  struct addrinfo hints;
-  struct addrinfo* res;
-
-  hints.ai_flags = 0;
-  hints.ai_family = AF_INET;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_protocol = 0;
-  hints.ai_addrlen = 0;
-  hints.ai_addr = nullptr;
-  hints.ai_canonname = nullptr;
-  hints.ai_next = nullptr;
-  int result = getaddrinfo(hostname, nullptr, &hints, &res);
-  if (result == 0) {
-    std::memcpy(
-        addr, &(reinterpret_cast<struct sockaddr_in*>(res->ai_addr)->sin_addr),
-        sizeof(struct in_addr));
-    freeaddrinfo(res);
-  }
-  return result;
-}
+using namespace wpi;
+using detail::kConnectErrorInterval;
 
-std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
-                                                     int port, Logger& logger,
-                                                     int timeout) {
+void detail::StartupSockets() {
 #ifdef _WIN32
   struct WSAHelper {
     WSAHelper() {
@@ -83,51 +64,88 @@ std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
   };
   static WSAHelper helper;
 #endif
-  struct sockaddr_in address;
+}
 
-  std::memset(&address, 0, sizeof(address));
-  address.sin_family = AF_INET;
-  if (ResolveHostName(server, &(address.sin_addr)) != 0) {
-#ifdef _WIN32
-    llvm::SmallString<128> addr_copy(server);
-    addr_copy.push_back('\0');
-    int res = InetPton(PF_INET, addr_copy.data(), &(address.sin_addr));
-#else
-    int res = inet_pton(PF_INET, server, &(address.sin_addr));
-#endif
-    if (res != 1) {
-      WPI_ERROR(logger, "could not resolve " << server << " address");
-      return nullptr;
+bool detail::ResolveAddresses(const char* server, int port,
+                              std::vector<sockaddr_storage>* addresses,
+                              Logger& logger) {
+  addresses->clear();
+
+  // numeric addresses need no lookup
+  struct sockaddr_storage address;
+  if (ParseSocketAddress(server, port, &address) != 0) {
+    addresses->push_back(address);
+    return true;
+  }
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res;
+  if (getaddrinfo(server, nullptr, &hints, &res) == 0) {
+    for (auto ai = res; ai; ai = ai->ai_next) {
+      if (ai->ai_addrlen > sizeof(address)) continue;
+      std::memset(&address, 0, sizeof(address));
+      std::memcpy(&address, ai->ai_addr, ai->ai_addrlen);
+      if (ai->ai_family == AF_INET)
+        reinterpret_cast<sockaddr_in*>(&address)->sin_port = htons(port);
+      else if (ai->ai_family == AF_INET6)
+        reinterpret_cast<sockaddr_in6*>(&address)->sin6_port = htons(port);
+      else
+        continue;
+      addresses->push_back(address);
     }
+    freeaddrinfo(res);
   }
-  address.sin_port = htons(port);
+  if (addresses->empty()) {
+    WPI_ERROR_RATE_LIMITED(logger, kConnectErrorInterval,
+                           "could not resolve " << server << " address");
+    return false;
+  }
+
+  // try IPv4 first, as before IPv6 support
+  std::stable_partition(addresses->begin(), addresses->end(),
+                        [](const sockaddr_storage& a) {
+                          return a.ss_family == AF_INET;
+                        });
+  return true;
+}
+
+// Returns the connected socket, or -1 on failure.
+static int ConnectAddress(const sockaddr_storage& address, const char* server,
+                          int port, Logger& logger, int timeout) {
+  const sockaddr* addr = reinterpret_cast<const sockaddr*>(&address);
+  int addrLen = GetSocketAddressLength(addr);
 
   if (timeout == 0) {
-    int sd = socket(AF_INET, SOCK_STREAM, 0);
+    int sd = socket(address.ss_family, SOCK_STREAM, 0);
     if (sd < 0) {
       WPI_ERROR(logger, "could not create socket");
-      return nullptr;
+      return -1;
     }
-    if (::connect(sd, (struct sockaddr*)&address, sizeof(address)) != 0) {
-      WPI_ERROR(logger, "connect() to " << server << " port " << port
-                                        << " failed: " << SocketStrerror());
+    if (::connect(sd, addr, addrLen) != 0) {
+      WPI_ERROR_RATE_LIMITED(logger, kConnectErrorInterval,
+                             "connect() to " << server << " port " << port
+                                             << " failed: "
+                                             << SocketStrerror());
 #ifdef _WIN32
       closesocket(sd);
 #else
       ::close(sd);
 #endif
-      return nullptr;
+      return -1;
     }
-    return std::unique_ptr<NetworkStream>(new TCPStream(sd, &address));
+    return sd;
   }
 
   fd_set sdset;
   struct timeval tv;
   socklen_t len;
-  int result = -1, valopt, sd = socket(AF_INET, SOCK_STREAM, 0);
+  int result = -1, valopt, sd = socket(address.ss_family, SOCK_STREAM, 0);
   if (sd < 0) {
     WPI_ERROR(logger, "could not create socket");
-    return nullptr;
+    return -1;
   }
 
 // Set socket to non-blocking
@@ -151,8 +169,7 @@ std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
 #endif
 
   // Connect with time limit
-  if ((result = ::connect(sd, (struct sockaddr*)&address, sizeof(address))) <
-      0) {
+  if ((result = ::connect(sd, addr, addrLen)) < 0) {
     int my_errno = SocketErrno();
 #ifdef _WIN32
     if (my_errno == WSAEWOULDBLOCK || my_errno == WSAEINPROGRESS) {
@@ -168,21 +185,24 @@ std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
         getsockopt(sd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&valopt),
                    &len);
         if (valopt) {
-          WPI_ERROR(logger, "select() to " << server << " port " << port
-                                           << " error " << valopt << " - "
-                                           << SocketStrerror(valopt));
+          WPI_ERROR_RATE_LIMITED(logger, kConnectErrorInterval,
+                                 "select() to " << server << " port " << port
+                                                << " error " << valopt << " - "
+                                                << SocketStrerror(valopt));
         }
         // connection established
         else
           result = 0;
       } else {
-        WPI_INFO(logger,
-                 "connect() to " << server << " port " << port << " timed out");
+        WPI_LOG_RATE_LIMITED(logger, ::wpi::WPI_LOG_INFO, kConnectErrorInterval,
+                             "connect() to " << server << " port " << port
+                                             << " timed out");
       }
     } else {
-      WPI_ERROR(logger, "connect() to " << server << " port " << port
-                                        << " error " << SocketErrno() << " - "
-                                        << SocketStrerror());
+      WPI_ERROR_RATE_LIMITED(logger, kConnectErrorInterval,
+                             "connect() to " << server << " port " << port
+                                             << " error " << SocketErrno()
+                                             << " - " << SocketStrerror());
     }
   }
 
@@ -212,7 +232,24 @@ std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
 #else
     ::close(sd);
 #endif
+    return -1;
+  }
+  return sd;
+}
+
+std::unique_ptr<NetworkStream> TCPConnector::connect(const char* server,
+                                                     int port, Logger& logger,
+                                                     int timeout) {
+  detail::StartupSockets();
+  std::vector<sockaddr_storage> addresses;
+  if (!detail::ResolveAddresses(server, port, &addresses, logger))
     return nullptr;
+  for (const auto& address : addresses) {
+    int sd = ConnectAddress(address, server, port, logger, timeout);
+    if (sd >= 0) {
+      return std::unique_ptr<NetworkStream>(
+          new TCPStream(sd, reinterpret_cast<const sockaddr*>(&address)));
+    }
   }
-  return std::unique_ptr<NetworkStream>(new TCPStream(sd, &address));
+  return nullptr;
 }
@@ -0,0 +1,40 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_TCPSOCKETS_TCPCONNECTOR_INTERNAL_H_
+#define WPIUTIL_TCPSOCKETS_TCPCONNECTOR_INTERNAL_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+struct sockaddr_storage;
+
+namespace wpi {
+
+class Logger;
+
+namespace detail {
+
+// Callers retry connect() in a loop; log each failure at most once per
+// second.
+constexpr uint64_t kConnectErrorInterval = 1000000;
+
+// Initializes the socket library (Winsock) on first use; no-op elsewhere.
+void StartupSockets();
+
+// Resolves a host name or numeric address to its IPv4 and IPv6 addresses,
+// IPv4 first.  Numeric addresses are parsed without a lookup.  Logs and
+// returns false on failure.
+bool ResolveAddresses(const char* server, int port,
+                      std::vector<sockaddr_storage>* addresses,
+                      Logger& logger);
+
+}  // namespace detail
+}  // namespace wpi
+
+#endif  // WPIUTIL_TCPSOCKETS_TCPCONNECTOR_INTERNAL_H_
@@ -7,123 +7,218 @@
 
 #include "tcpsockets/TCPConnector.h"  // NOLINT(build/include_order)
 
-#include <atomic>
+#include <stdint.h>
+
+#include <algorithm>
 #include <chrono>
-#include <thread>
-#include <tuple>
+#include <vector>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <Ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "support/Logger.h"
+#include "tcpsockets/SocketAddress.h"
+#include "tcpsockets/SocketError.h"
+#include "tcpsockets/TCPStream.h"
 
-#include "llvm/SmallSet.h"
-#include "support/condition_variable.h"
-#include "support/mutex.h"
+#include "TCPConnector_internal.h"
 
 using namespace wpi;
+using detail::kConnectErrorInterval;
+
+namespace {
+
+#ifdef _WIN32
+typedef WSAPOLLFD PollFd;
+typedef int SockLen;
+
+int Poll(PollFd* fds, size_t count, int timeout) {
+  return WSAPoll(fds, static_cast<ULONG>(count), timeout);
+}
+
+void CloseSocket(int sd) { closesocket(sd); }
 
-// MSVC < 1900 doesn't have support for thread_local
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-// clang check for availability of thread_local
-#if !defined(__has_feature) || __has_feature(cxx_thread_local)
-#define HAVE_THREAD_LOCAL
+bool InProgress(int err) {
+  return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+}
+#else
+typedef pollfd PollFd;
+typedef socklen_t SockLen;
+
+int Poll(PollFd* fds, size_t count, int timeout) {
+  return poll(fds, count, timeout);
+}
+
+void CloseSocket(int sd) { ::close(sd); }
+
+bool InProgress(int err) { return err == EWOULDBLOCK || err == EINPROGRESS; }
 #endif
+
+bool SetBlocking(int sd, bool enabled) {
+#ifdef _WIN32
+  u_long mode = enabled ? 0 : 1;
+  return ioctlsocket(sd, FIONBIO, &mode) != SOCKET_ERROR;
+#else
+  int flags = fcntl(sd, F_GETFL, nullptr);
+  if (flags < 0) return false;
+  if (enabled)
+    flags &= ~O_NONBLOCK;
+  else
+    flags |= O_NONBLOCK;
+  return fcntl(sd, F_SETFL, flags) == 0;
 #endif
+}
+
+struct Attempt {
+  const char* server;
+  int port;
+  struct sockaddr_storage address;
+  int sd = -1;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Milliseconds until time, for poll(); 0 if already past.
+int MillisecondsUntil(Clock::time_point time, Clock::time_point now) {
+  if (time <= now) return 0;
+  auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(time - now).count();
+  return static_cast<int>(std::min<decltype(ms)>(ms + 1, INT32_MAX));
+}
+
+}  // namespace
 
 std::unique_ptr<NetworkStream> TCPConnector::connect_parallel(
     llvm::ArrayRef<std::pair<const char*, int>> servers, Logger& logger,
-    int timeout) {
+    int timeout, int stagger) {
   if (servers.empty()) return nullptr;
+  detail::StartupSockets();
 
-  // structure to make sure we don't start duplicate workers
-  struct GlobalState {
-    wpi::mutex mtx;
-#ifdef HAVE_THREAD_LOCAL
-    llvm::SmallSet<std::pair<std::string, int>, 16> active;
-#else
-    llvm::SmallSet<std::tuple<std::thread::id, std::string, int>, 16> active;
-#endif
-  };
-#ifdef HAVE_THREAD_LOCAL
-  thread_local auto global = std::make_shared<GlobalState>();
-#else
-  static auto global = std::make_shared<GlobalState>();
-  auto this_id = std::this_thread::get_id();
-#endif
-  auto local = global;  // copy to an automatic variable for lambda capture
-
-  // structure shared between threads and this function
-  struct Result {
-    wpi::mutex mtx;
-    wpi::condition_variable cv;
-    std::unique_ptr<NetworkStream> stream;
-    std::atomic<unsigned int> count{0};
-    std::atomic<bool> done{false};
-  };
-  auto result = std::make_shared<Result>();
-
-  // start worker threads; this is I/O bound so we don't limit to # of procs
-  Logger* plogger = &logger;
-  unsigned int num_workers = 0;
+  // one attempt per address, in server order
+  std::vector<Attempt> attempts;
+  std::vector<sockaddr_storage> addresses;
   for (const auto& server : servers) {
-    std::pair<std::string, int> server_copy{std::string{server.first},
-                                            server.second};
-#ifdef HAVE_THREAD_LOCAL
-    const auto& active_tracker = server_copy;
-#else
-    std::tuple<std::thread::id, std::string, int> active_tracker{
-        this_id, server_copy.first, server_copy.second};
-#endif
+    if (!detail::ResolveAddresses(server.first, server.second, &addresses,
+                                  logger))
+      continue;
+    for (const auto& address : addresses) {
+      Attempt attempt;
+      attempt.server = server.first;
+      attempt.port = server.second;
+      attempt.address = address;
+      attempts.push_back(attempt);
+    }
+  }
 
-    // don't start a new worker if we had a previously still-active connection
-    // attempt to the same server
-    {
-      std::lock_guard<wpi::mutex> lock(local->mtx);
-      if (local->active.count(active_tracker) > 0) continue;  // already in set
+  auto now = Clock::now();
+  auto deadline = now + std::chrono::seconds(timeout);
+  auto nextStart = now;
+  size_t next = 0;             // next attempt to start
+  std::vector<Attempt*> active;  // attempts waiting for connect() to finish
+  std::vector<PollFd> pollFds;
+  Attempt* winner = nullptr;
+
+  for (;;) {
+    // start attempts that are due; with nothing in progress, don't wait
+    while (!winner && next < attempts.size() &&
+           (stagger == 0 || active.empty() || now >= nextStart)) {
+      Attempt& attempt = attempts[next++];
+      nextStart = now + std::chrono::milliseconds(stagger);
+      attempt.sd = socket(attempt.address.ss_family, SOCK_STREAM, 0);
+      if (attempt.sd < 0) {
+        WPI_ERROR(logger, "could not create socket");
+        continue;
+      }
+      if (!SetBlocking(attempt.sd, false))
+        WPI_WARNING(logger, "could not set socket to non-blocking: "
+                                << SocketStrerror());
+      auto addr = reinterpret_cast<const sockaddr*>(&attempt.address);
+      if (::connect(attempt.sd, addr, GetSocketAddressLength(addr)) == 0) {
+        winner = &attempt;
+        break;
+      }
+      int err = SocketErrno();
+      if (InProgress(err)) {
+        active.push_back(&attempt);
+      } else {
+        // not rate limited: failures of different servers aren't duplicates
+        WPI_ERROR(logger, "connect() to " << attempt.server << " port "
+                                          << attempt.port << " error " << err
+                                          << " - " << SocketStrerror(err));
+        CloseSocket(attempt.sd);
+        attempt.sd = -1;
+      }
+    }
+    if (winner || active.empty()) break;
+
+    if (timeout != 0 && now >= deadline) {
+      WPI_LOG_RATE_LIMITED(logger, ::wpi::WPI_LOG_INFO, kConnectErrorInterval,
+                           "connect_parallel() timed out");
+      break;
     }
 
-    ++num_workers;
-
-    // start the worker
-    std::thread([=]() {
-      if (!result->done) {
-        // add to global state
-        {
-          std::lock_guard<wpi::mutex> lock(local->mtx);
-          local->active.insert(active_tracker);
-        }
-
-        // try to connect
-        auto stream = connect(server_copy.first.c_str(), server_copy.second,
-                              *plogger, timeout);
-
-        // remove from global state
-        {
-          std::lock_guard<wpi::mutex> lock(local->mtx);
-          local->active.erase(active_tracker);
-        }
-
-        // successful connection
-        if (stream) {
-          std::lock_guard<wpi::mutex> lock(result->mtx);
-          if (!result->done.exchange(true)) result->stream = std::move(stream);
-        }
+    // wait for an attempt to finish, the next start, or the deadline
+    int wait = -1;
+    if (timeout != 0) wait = MillisecondsUntil(deadline, now);
+    if (stagger != 0 && next < attempts.size()) {
+      int untilStart = MillisecondsUntil(nextStart, now);
+      if (wait < 0 || untilStart < wait) wait = untilStart;
+    }
+    pollFds.clear();
+    for (Attempt* attempt : active) {
+      PollFd pfd;
+      pfd.fd = attempt->sd;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      pollFds.push_back(pfd);
+    }
+    int count = Poll(pollFds.data(), pollFds.size(), wait);
+    now = Clock::now();
+    if (count <= 0) continue;  // timeout or interrupted
+
+    for (size_t i = 0; i < pollFds.size(); ++i) {
+      if (pollFds[i].revents == 0) continue;
+      Attempt* attempt = active[i];
+      int valopt = 0;
+      SockLen len = sizeof(valopt);
+      getsockopt(attempt->sd, SOL_SOCKET, SO_ERROR,
+                 reinterpret_cast<char*>(&valopt), &len);
+      if (valopt == 0) {
+        winner = attempt;
+        break;
       }
-      ++result->count;
-      result->cv.notify_all();
-    })
-        .detach();
+      WPI_ERROR(logger, "connect() to " << attempt->server << " port "
+                                        << attempt->port << " error " << valopt
+                                        << " - " << SocketStrerror(valopt));
+      CloseSocket(attempt->sd);
+      attempt->sd = -1;
+      nextStart = now;  // don't wait to start the next attempt
+    }
+    if (winner) break;
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [](Attempt* a) { return a->sd < 0; }),
+                 active.end());
   }
 
-  // wait for a result, timeout, or all finished
-  std::unique_lock<wpi::mutex> lock(result->mtx);
-  if (timeout == 0) {
-    result->cv.wait(
-        lock, [&] { return result->stream || result->count >= num_workers; });
-  } else {
-    auto timeout_time =
-        std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
-    result->cv.wait_until(lock, timeout_time, [&] {
-      return result->stream || result->count >= num_workers;
-    });
+  // close the losing attempts right away
+  for (Attempt* attempt : active) {
+    if (attempt != winner && attempt->sd >= 0) CloseSocket(attempt->sd);
   }
-
-  // no need to wait for remaining worker threads; shared_ptr will clean up
-  return std::move(result->stream);
+  if (!winner) return nullptr;
+
+  if (!SetBlocking(winner->sd, true))
+    WPI_WARNING(logger,
+                "could not set socket to blocking: " << SocketStrerror());
+  return std::unique_ptr<NetworkStream>(
+      new TCPStream(winner->sd,
+                    reinterpret_cast<const sockaddr*>(&winner->address)));
 }
@@ -25,34 +25,95 @@
 
 #include <fcntl.h>
 
+#include <cstring>
+
 #ifdef _WIN32
 #include <WinSock2.h>
 #include <Ws2tcpip.h>
 #else
 #include <arpa/inet.h>
+#include <limits.h>
 #include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
+#include "llvm/SmallVector.h"
+#include "support/Metrics.h"
+#include "tcpsockets/SocketAddress.h"
+
 using namespace wpi;
 
-TCPStream::TCPStream(int sd, sockaddr_in* address)
-    : m_sd(sd), m_blocking(true) {
-  char ip[50];
-#ifdef _WIN32
-  InetNtop(PF_INET, &(address->sin_addr.s_addr), ip, sizeof(ip) - 1);
+namespace {
+
+struct StreamMetrics {
+  StreamMetrics()
+      : send(MetricsRegistry::GetInstance().GetHistogram("tcpstream.send_ns")),
+        receive(MetricsRegistry::GetInstance().GetHistogram(
+            "tcpstream.receive_ns")),
+        bytesSent(
+            MetricsRegistry::GetInstance().GetCounter("tcpstream.bytes_sent")),
+        bytesReceived(MetricsRegistry::GetInstance().GetCounter(
+            "tcpstream.bytes_received")) {}
+
+  LatencyHistogram& send;
+  LatencyHistogram& receive;
+  MetricCounter& bytesSent;
+  MetricCounter& bytesReceived;
+};
+
+StreamMetrics& GetMetrics() {
+  static StreamMetrics metrics;
+  return metrics;
+}
+
+#ifndef _WIN32
+#ifdef IOV_MAX
+constexpr size_t kMaxIov = IOV_MAX;
+#else
+constexpr size_t kMaxIov = 16;
+#endif
+
+// Buffers beyond kMaxIov are left for the caller to send (or receive into)
+// after the resulting short transfer.
+template <typename Buffers>
+void MakeIov(Buffers bufs, llvm::SmallVectorImpl<struct iovec>* iov) {
+  for (auto buf : bufs) {
+    if (buf.empty()) continue;
+    if (iov->size() == kMaxIov) break;
+    struct iovec v;
+    v.iov_base = const_cast<char*>(buf.data());
+    v.iov_len = buf.size();
+    iov->push_back(v);
+  }
+}
 #else
-  inet_ntop(PF_INET, reinterpret_cast<in_addr*>(&(address->sin_addr.s_addr)),
-            ip, sizeof(ip) - 1);
+template <typename Buffers>
+void MakeWsaBufs(Buffers bufs, llvm::SmallVectorImpl<WSABUF>* wsaBufs) {
+  for (auto buf : bufs) {
+    if (buf.empty()) continue;
+    WSABUF wsaBuf;
+    wsaBuf.buf = const_cast<char*>(buf.data());
+    wsaBuf.len = static_cast<ULONG>(buf.size());
+    wsaBufs->push_back(wsaBuf);
+  }
+}
+#endif
+
+}  // namespace
+
+TCPStream::TCPStream(int sd, const sockaddr* address)
+    : m_sd(sd),
+      m_peerIP(GetSocketAddressHost(address)),
+      m_peerPort(GetSocketAddressPort(address)),
+      m_blocking(true) {
 #ifdef SO_NOSIGPIPE
   // disable SIGPIPE on Mac OS X
   int set = 1;
   setsockopt(m_sd, SOL_SOCKET, SO_NOSIGPIPE, reinterpret_cast<char*>(&set),
              sizeof set);
 #endif
-#endif
-  m_peerIP = ip;
-  m_peerPort = ntohs(address->sin_port);
 }
 
 TCPStream::~TCPStream() { close(); }
@@ -62,6 +123,7 @@ size_t TCPStream::send(const char* buffer, size_t len, Error* err) {
     *err = kConnectionClosed;
     return 0;
   }
+  ScopedLatency timer(GetMetrics().send);
 #ifdef _WIN32
   WSABUF wsaBuf;
   wsaBuf.buf = const_cast<char*>(buffer);
@@ -106,6 +168,7 @@ size_t TCPStream::send(const char* buffer, size_t len, Error* err) {
     return 0;
   }
 #endif
+  if (timer) GetMetrics().bytesSent.Add(rv);
   return static_cast<size_t>(rv);
 }
 
@@ -114,6 +177,7 @@ size_t TCPStream::receive(char* buffer, size_t len, Error* err, int timeout) {
     *err = kConnectionClosed;
     return 0;
   }
+  ScopedLatency timer(GetMetrics().receive);
 #ifdef _WIN32
   int rv;
 #else
@@ -146,6 +210,94 @@ size_t TCPStream::receive(char* buffer, size_t len, Error* err, int timeout) {
       *err = kConnectionReset;
     return 0;
   }
+  if (timer) GetMetrics().bytesReceived.Add(rv);
+  return static_cast<size_t>(rv);
+}
+
+size_t TCPStream::sendv(llvm::ArrayRef<llvm::StringRef> bufs, Error* err) {
+  if (m_sd < 0) {
+    *err = kConnectionClosed;
+    return 0;
+  }
+  ScopedLatency timer(GetMetrics().send);
+#ifdef _WIN32
+  llvm::SmallVector<WSABUF, 16> wsaBufs;
+  MakeWsaBufs(bufs, &wsaBufs);
+  DWORD rv;
+  while (WSASend(m_sd, wsaBufs.data(), static_cast<DWORD>(wsaBufs.size()),
+                 &rv, 0, nullptr, nullptr) == SOCKET_ERROR) {
+    if (WSAGetLastError() != WSAEWOULDBLOCK) {
+      *err = kConnectionReset;
+      return 0;
+    }
+    if (!m_blocking) {
+      *err = kWouldBlock;
+      return 0;
+    }
+    Sleep(1);
+  }
+#else
+  llvm::SmallVector<struct iovec, 16> iov;
+  MakeIov(bufs, &iov);
+  struct msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov.data();
+  msg.msg_iovlen = iov.size();
+#ifdef MSG_NOSIGNAL
+  // disable SIGPIPE on Linux
+  ssize_t rv = ::sendmsg(m_sd, &msg, MSG_NOSIGNAL);
+#else
+  ssize_t rv = ::sendmsg(m_sd, &msg, 0);
+#endif
+  if (rv < 0) {
+    if (!m_blocking && (errno == EAGAIN || errno == EWOULDBLOCK))
+      *err = kWouldBlock;
+    else
+      *err = kConnectionReset;
+    return 0;
+  }
+#endif
+  if (timer) GetMetrics().bytesSent.Add(rv);
+  return static_cast<size_t>(rv);
+}
+
+size_t TCPStream::receivev(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                           Error* err, int timeout) {
+  if (m_sd < 0) {
+    *err = kConnectionClosed;
+    return 0;
+  }
+  ScopedLatency timer(GetMetrics().receive);
+  if (timeout > 0 && !WaitForReadEvent(timeout)) {
+    *err = kConnectionTimedOut;
+    return 0;
+  }
+#ifdef _WIN32
+  llvm::SmallVector<WSABUF, 16> wsaBufs;
+  MakeWsaBufs(bufs, &wsaBufs);
+  DWORD rv;
+  DWORD flags = 0;
+  if (WSARecv(m_sd, wsaBufs.data(), static_cast<DWORD>(wsaBufs.size()), &rv,
+              &flags, nullptr, nullptr) == SOCKET_ERROR) {
+    if (!m_blocking && WSAGetLastError() == WSAEWOULDBLOCK)
+      *err = kWouldBlock;
+    else
+      *err = kConnectionReset;
+    return 0;
+  }
+#else
+  llvm::SmallVector<struct iovec, 16> iov;
+  MakeIov(bufs, &iov);
+  ssize_t rv = ::readv(m_sd, iov.data(), static_cast<int>(iov.size()));
+  if (rv < 0) {
+    if (!m_blocking && (errno == EAGAIN || errno == EWOULDBLOCK))
+      *err = kWouldBlock;
+    else
+      *err = kConnectionReset;
+    return 0;
+  }
+#endif
+  if (timer) GetMetrics().bytesReceived.Add(rv);
   return static_cast<size_t>(rv);
 }
 
@@ -7,6 +7,9 @@
 
 #include "udpsockets/UDPClient.h"
 
+#include <algorithm>
+#include <cstring>
+
 #ifdef _WIN32
 #include <WinSock2.h>
 #include <Ws2tcpip.h>
@@ -15,14 +18,65 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
+#include "llvm/SmallVector.h"
 #include "support/Logger.h"
+#include "tcpsockets/SocketAddress.h"
 #include "tcpsockets/SocketError.h"
 
 using namespace wpi;
 
+// send() errors repeat on every packet; log each at most once per second.
+static constexpr uint64_t kSendErrorInterval = 1000000;
+
+#ifdef _WIN32
+typedef int SockLen;
+#else
+typedef socklen_t SockLen;
+#endif
+
+#ifdef __linux__
+// Kernel limit on the number of messages per sendmmsg() or recvmmsg() call.
+static constexpr size_t kMaxBatch = UIO_MAXIOV;
+#endif
+
+static_assert(sizeof(UDPClient::Destination) >= sizeof(sockaddr_storage) &&
+                  alignof(UDPClient::Destination) >= alignof(sockaddr_storage),
+              "Destination too small for sockaddr_storage");
+
+// Adapts a destination address to a socket of the given family: IPv4
+// addresses are mapped to IPv6 for an IPv6 socket.  Returns the new
+// address length, or 0 if an IPv6 address can't be reached from an IPv4
+// socket.
+static int MapDestination(int family, sockaddr_storage* addr, int len) {
+  if (addr->ss_family == family) return len;
+  if (family != AF_INET6) return 0;
+  struct sockaddr_in addr4 = *reinterpret_cast<sockaddr_in*>(addr);
+  auto addr6 = reinterpret_cast<sockaddr_in6*>(addr);
+  std::memset(addr, 0, sizeof(*addr));
+  addr6->sin6_family = AF_INET6;
+  addr6->sin6_port = addr4.sin_port;
+  addr6->sin6_addr.s6_addr[10] = 0xff;
+  addr6->sin6_addr.s6_addr[11] = 0xff;
+  std::memcpy(&addr6->sin6_addr.s6_addr[12], &addr4.sin_addr, 4);
+  return sizeof(*addr6);
+}
+
+std::string UDPClient::Destination::getHost() const {
+  if (m_len == 0) return std::string{};
+  return GetSocketAddressHost(reinterpret_cast<const sockaddr*>(&m_addr));
+}
+
+int UDPClient::Destination::getPort() const {
+  if (m_len == 0) return 0;
+  return GetSocketAddressPort(reinterpret_cast<const sockaddr*>(&m_addr));
+}
+
 UDPClient::UDPClient(Logger& logger) : UDPClient("", logger) {}
 
 UDPClient::UDPClient(llvm::StringRef address, Logger& logger)
@@ -30,6 +84,7 @@ UDPClient::UDPClient(llvm::StringRef address, Logger& logger)
 
 UDPClient::UDPClient(UDPClient&& other)
     : m_lsd(other.m_lsd),
+      m_family(other.m_family),
       m_address(std::move(other.m_address)),
       m_logger(other.m_logger) {
   other.m_lsd = 0;
@@ -46,12 +101,15 @@ UDPClient& UDPClient::operator=(UDPClient&& other) {
   shutdown();
   m_logger = other.m_logger;
   m_lsd = other.m_lsd;
+  m_family = other.m_family;
   m_address = std::move(other.m_address);
   other.m_lsd = 0;
   return *this;
 }
 
-int UDPClient::start() {
+int UDPClient::start() { return start(0); }
+
+int UDPClient::start(int port) {
   if (m_lsd > 0) return 0;
 
 #ifdef _WIN32
@@ -60,34 +118,39 @@ int UDPClient::start() {
   WSAStartup(wVersionRequested, &wsaData);
 #endif
 
-  m_lsd = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_storage addr;
+  int addrLen;
+  if (m_address.size() > 0) {
+    addrLen = ParseSocketAddress(m_address, port, &addr);
+    if (addrLen == 0) {
+      WPI_ERROR(m_logger, "could not resolve " << m_address << " address");
+      return -1;
+    }
+  } else {
+    auto addr4 = reinterpret_cast<struct sockaddr_in*>(&addr);
+    std::memset(&addr, 0, sizeof(addr));
+    addr4->sin_family = AF_INET;
+    addr4->sin_addr.s_addr = INADDR_ANY;
+    addr4->sin_port = htons(port);
+    addrLen = sizeof(*addr4);
+  }
+
+  m_lsd = socket(addr.ss_family, SOCK_DGRAM, 0);
 
   if (m_lsd < 0) {
     WPI_ERROR(m_logger, "could not create socket");
     return -1;
   }
+  m_family = addr.ss_family;
 
-  struct sockaddr_in addr;
-  std::memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  if (m_address.size() > 0) {
-#ifdef _WIN32
-    llvm::SmallString<128> addr_copy(m_address);
-    addr_copy.push_back('\0');
-    int res = InetPton(PF_INET, addr_copy.data(), &(addr.sin_addr));
-#else
-    int res = inet_pton(PF_INET, m_address.c_str(), &(addr.sin_addr));
-#endif
-    if (res != 1) {
-      WPI_ERROR(m_logger, "could not resolve " << m_address << " address");
-      return -1;
-    }
-  } else {
-    addr.sin_addr.s_addr = INADDR_ANY;
+  if (m_family == AF_INET6) {
+    // allow sending to IPv4 addresses (see MapDestination)
+    int v6only = 0;
+    setsockopt(m_lsd, IPPROTO_IPV6, IPV6_V6ONLY,
+               reinterpret_cast<char*>(&v6only), sizeof v6only);
   }
-  addr.sin_port = htons(0);
 
-  int result = bind(m_lsd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  int result = bind(m_lsd, reinterpret_cast<sockaddr*>(&addr), addrLen);
   if (result != 0) {
     WPI_ERROR(m_logger, "bind() failed: " << SocketStrerror());
     return result;
@@ -111,60 +174,147 @@ void UDPClient::shutdown() {
 
 int UDPClient::send(llvm::ArrayRef<uint8_t> data, llvm::StringRef server,
                     int port) {
-  // server must be a resolvable IP address
-  struct sockaddr_in addr;
-  std::memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  if (server.size() > 0) {
-    llvm::SmallVector<char, 128> addr_store;
-    auto remoteAddr = server.c_str(addr_store);
-#ifdef _WIN32
-    int res = InetPton(AF_INET, remoteAddr, &(addr.sin_addr));
-#else
-    int res = inet_pton(AF_INET, remoteAddr, &(addr.sin_addr));
-#endif
-    if (res != 1) {
-      WPI_ERROR(m_logger, "could not resolve " << server << " address");
-      return -1;
-    }
-  } else {
-    WPI_ERROR(m_logger, "server must be passed");
-    return -1;
+  return send(llvm::StringRef(reinterpret_cast<const char*>(data.data()),
+                              data.size()),
+              server, port);
+}
+
+int UDPClient::send(llvm::StringRef data, llvm::StringRef server, int port) {
+  return send(data, resolve(server, port));
+}
+
+UDPClient::Destination UDPClient::resolve(llvm::StringRef server,
+                                          int port) const {
+  Destination dest;
+  // server must be a numeric IP address
+  if (server.empty()) {
+    WPI_ERROR_RATE_LIMITED(m_logger, kSendErrorInterval,
+                           "server must be passed");
+    return dest;
+  }
+  auto addr = reinterpret_cast<sockaddr_storage*>(&dest.m_addr);
+  int addrLen = ParseSocketAddress(server, port, addr);
+  if (addrLen == 0) {
+    WPI_ERROR_RATE_LIMITED(m_logger, kSendErrorInterval,
+                           "could not resolve " << server << " address");
+    return dest;
+  }
+  dest.m_len = MapDestination(m_family, addr, addrLen);
+  if (dest.m_len == 0) {
+    WPI_ERROR_RATE_LIMITED(m_logger, kSendErrorInterval,
+                           "cannot send to " << server
+                                             << " from an IPv4 socket");
   }
-  addr.sin_port = htons(port);
+  return dest;
+}
 
+int UDPClient::send(llvm::ArrayRef<uint8_t> data, const Destination& dest) {
+  return send(llvm::StringRef(reinterpret_cast<const char*>(data.data()),
+                              data.size()),
+              dest);
+}
+
+int UDPClient::send(llvm::StringRef data, const Destination& dest) {
+  if (!dest) return -1;
   // sendto should not block
-  int result =
-      sendto(m_lsd, reinterpret_cast<const char*>(data.data()), data.size(), 0,
-             reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  int result = sendto(m_lsd, data.data(), data.size(), 0,
+                      reinterpret_cast<const sockaddr*>(&dest.m_addr),
+                      dest.m_len);
   return result;
 }
 
-int UDPClient::send(llvm::StringRef data, llvm::StringRef server, int port) {
-  // server must be a resolvable IP address
-  struct sockaddr_in addr;
-  std::memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  if (server.size() > 0) {
-    llvm::SmallVector<char, 128> addr_store;
-    auto remoteAddr = server.c_str(addr_store);
-#ifdef _WIN32
-    int res = InetPton(AF_INET, remoteAddr, &(addr.sin_addr));
+int UDPClient::sendBatch(llvm::ArrayRef<llvm::StringRef> datagrams,
+                         const Destination& dest) {
+  if (!dest) return -1;
+  size_t sent = 0;
+#ifdef __linux__
+  llvm::SmallVector<mmsghdr, 32> msgs;
+  llvm::SmallVector<iovec, 32> iovs;
+  msgs.resize(datagrams.size());
+  iovs.resize(datagrams.size());
+  for (size_t i = 0; i < datagrams.size(); ++i) {
+    iovs[i].iov_base = const_cast<char*>(datagrams[i].data());
+    iovs[i].iov_len = datagrams[i].size();
+    auto& hdr = msgs[i].msg_hdr;
+    hdr.msg_name = const_cast<void*>(static_cast<const void*>(&dest.m_addr));
+    hdr.msg_namelen = dest.m_len;
+    hdr.msg_iov = &iovs[i];
+    hdr.msg_iovlen = 1;
+  }
+  while (sent < msgs.size()) {
+    int result = sendmmsg(m_lsd, &msgs[sent],
+                          std::min(msgs.size() - sent, kMaxBatch), 0);
+    if (result <= 0) break;
+    sent += result;
+  }
 #else
-    int res = inet_pton(AF_INET, remoteAddr, &(addr.sin_addr));
+  for (auto data : datagrams) {
+    if (send(data, dest) < 0) break;
+    ++sent;
+  }
 #endif
-    if (res != 1) {
-      WPI_ERROR(m_logger, "could not resolve " << server << " address");
-      return -1;
-    }
-  } else {
-    WPI_ERROR(m_logger, "server must be passed");
-    return -1;
+  return sent == 0 && !datagrams.empty() ? -1 : static_cast<int>(sent);
+}
+
+int UDPClient::receive(llvm::MutableArrayRef<char> buf, Destination* source) {
+  sockaddr_storage addr;
+  SockLen addrLen = sizeof(addr);
+  int result = recvfrom(m_lsd, buf.data(), buf.size(), 0,
+                        reinterpret_cast<sockaddr*>(&addr), &addrLen);
+  if (source) {
+    std::memcpy(&source->m_addr, &addr, sizeof(addr));
+    source->m_len = result < 0 ? 0 : addrLen;
   }
-  addr.sin_port = htons(port);
+  return result;
+}
 
-  // sendto should not block
-  int result = sendto(m_lsd, data.data(), data.size(), 0,
-                      reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+int UDPClient::receiveBatch(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                            size_t* lens, Destination* sources) {
+  if (bufs.empty()) return 0;
+#ifdef __linux__
+  size_t count = std::min(bufs.size(), kMaxBatch);
+  llvm::SmallVector<mmsghdr, 32> msgs;
+  llvm::SmallVector<iovec, 32> iovs;
+  msgs.resize(count);
+  iovs.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = bufs[i].data();
+    iovs[i].iov_len = bufs[i].size();
+    auto& hdr = msgs[i].msg_hdr;
+    if (sources) {
+      hdr.msg_name = &sources[i].m_addr;
+      hdr.msg_namelen = sizeof(sockaddr_storage);
+    }
+    hdr.msg_iov = &iovs[i];
+    hdr.msg_iovlen = 1;
+  }
+  // MSG_WAITFORONE: block for the first datagram only
+  int result = recvmmsg(m_lsd, msgs.data(), count, MSG_WAITFORONE, nullptr);
+  for (int i = 0; i < result; ++i) {
+    lens[i] = msgs[i].msg_len;
+    if (sources) sources[i].m_len = msgs[i].msg_hdr.msg_namelen;
+  }
   return result;
+#else
+  size_t received = 0;
+  for (; received < bufs.size(); ++received) {
+    if (received > 0) {
+      // don't wait for more
+#ifdef _WIN32
+      u_long avail = 0;
+      if (ioctlsocket(m_lsd, FIONREAD, &avail) != 0 || avail == 0) break;
+#else
+      pollfd pfd;
+      pfd.fd = m_lsd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 0) <= 0) break;
+#endif
+    }
+    int result =
+        receive(bufs[received], sources ? &sources[received] : nullptr);
+    if (result < 0) break;
+    lens[received] = result;
+  }
+  return received == 0 ? -1 : static_cast<int>(received);
+#endif
 }
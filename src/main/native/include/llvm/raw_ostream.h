@@ -271,6 +271,15 @@ private:
   /// \invariant { Size > 0 }
   virtual void write_impl(const char *Ptr, size_t Size) = 0;
 
+  /// The same as write_impl(Buffered, BufferedSize) followed by
+  /// write_impl(Ptr, Size).  Called when a write does not fit in the buffer
+  /// and is at least as large as the buffer, so that subclasses which can
+  /// gather both into a single operation (e.g. writev()) can do so.
+  ///
+  /// \invariant { BufferedSize > 0 && Size > 0 }
+  virtual void writev_impl(const char *Buffered, size_t BufferedSize,
+                           const char *Ptr, size_t Size);
+
   // An out of line virtual method to provide a home for the class vtable.
   virtual void handle();
 
@@ -0,0 +1,162 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_ASYNCLOGSINK_H_
+#define WPIUTIL_SUPPORT_ASYNCLOGSINK_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "llvm/ArrayRef.h"
+#include "llvm/StringRef.h"
+#include "llvm/raw_ostream.h"
+#include "support/BinaryLog.h"
+#include "support/Logger.h"
+#include "support/SafeThread.h"
+
+namespace wpi {
+
+// A log message as delivered to an AsyncLogSink writer.
+struct LogRecord {
+  uint64_t time;  // WPI_Now() when the message was logged
+  unsigned int level;
+  const char* file;
+  unsigned int line;
+  std::string message;
+  // Set for binary messages that were not rendered (see
+  // AsyncLogSink::Options::renderBinary); message then holds the encoded
+  // arguments.
+  const BinaryLogSite* site = nullptr;
+};
+
+// Logger backend that moves formatting and I/O off the logging thread.
+//
+// Each logging thread gets its own bounded single-producer ring, so logging
+// takes no locks and makes no system calls: the message (or a deferred
+// formatting function) is copied into a preallocated ring slot with its
+// WPI_Now() timestamp.  A background SafeThread polls the rings, formats
+// deferred messages, and hands the records to the writer in batches sorted
+// by time.
+//
+// Binary messages (WPI_BLOG, see BinaryLog.h) only copy their arguments on
+// the logging thread; they are rendered to text on the drain thread, or
+// passed through unrendered for BinaryWriter to store.
+//
+// When a thread's ring is full, new messages are dropped and counted (or,
+// with kBlock, the logging thread waits for space).  The drain thread
+// reports drops in a synthetic warning record.
+//
+// Typical use:
+//
+//   AsyncLogSink sink(AsyncLogSink::StreamWriter(os));
+//   Logger logger(sink.GetLogFunc());
+class AsyncLogSink {
+ public:
+  typedef std::function<void(llvm::ArrayRef<LogRecord> records)> Writer;
+  typedef std::function<void(llvm::raw_ostream& os)> Formatter;
+
+  enum OverflowPolicy {
+    kDropNewest,  // discard the message and count it
+    kBlock        // wait for the drain thread to make room
+  };
+
+  struct Options {
+    // Messages each thread can have queued.
+    size_t ringCapacity = 256;
+    OverflowPolicy overflow = kDropNewest;
+    // Most records passed to one writer call.
+    size_t batchSize = 64;
+    // How often the drain thread checks the rings.
+    std::chrono::milliseconds pollInterval{10};
+    // Render binary messages to text before passing them to the writer.
+    // Turn off when using BinaryWriter.
+    bool renderBinary = true;
+  };
+
+  // Longest pre-formatted message kept; longer messages are truncated.  Also
+  // bounds the encoded arguments of a binary message.
+  static constexpr size_t kMaxMessage = 200;
+
+  explicit AsyncLogSink(Writer writer);
+  AsyncLogSink(Writer writer, const Options& options);
+
+  // Flushes and stops.
+  ~AsyncLogSink();
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  // Returns a Logger::LogFunc that enqueues to this sink.  The sink must
+  // outlive any Logger using it.
+  Logger::LogFunc GetLogFunc();
+
+  // Enqueues a pre-formatted message.
+  void Log(unsigned int level, const char* file, unsigned int line,
+           llvm::StringRef msg);
+
+  // Enqueues a message formatted on the drain thread by calling
+  // format(raw_ostream&).  Anything it captures must remain valid until
+  // then, so capture by value.
+  void LogDeferred(unsigned int level, const char* file, unsigned int line,
+                   Formatter format);
+
+  // Enqueues a binary message; normally called through WPI_BLOG.
+  template <typename... Args>
+  void LogBinary(const BinaryLogSite& site, const Args&... args) {
+    uint8_t buf[kMaxMessage];
+    uint8_t* end = detail::BinaryEncode(buf, buf + sizeof(buf), args...);
+    LogEncoded(site, buf, end - buf);
+  }
+
+  // Enqueues a binary message with already encoded arguments.
+  void LogEncoded(const BinaryLogSite& site, const uint8_t* args,
+                  size_t len);
+
+  // Blocks until every message enqueued before the call has been written.
+  void Flush();
+
+  // Flushes, then stops the drain thread.  Messages logged afterwards are
+  // dropped.
+  void Stop();
+
+  // Total messages dropped because a ring was full or the sink stopped.
+  uint64_t GetDropped() const;
+
+  // Returns a writer that prints each record as
+  // "<seconds> <level> <file>:<line>: <message>" and flushes the stream once
+  // per batch.  The stream must outlive the sink.
+  static Writer StreamWriter(llvm::raw_ostream& os);
+
+  // Returns a writer that stores records in the binary log file format (see
+  // BinaryLogFileWriter); decode the file with the wpilogdecode tool.  The
+  // stream must outlive the sink.
+  static Writer BinaryWriter(llvm::raw_ostream& os);
+
+  // Prints a record as described for StreamWriter (without flushing).
+  static void PrintRecord(llvm::raw_ostream& os, const LogRecord& record);
+
+ private:
+  class Thread;
+  struct Shared;
+  struct Ring;
+
+  template <typename Fill>
+  void Enqueue(Fill fill);
+  Ring* GetRing();
+
+  std::shared_ptr<Shared> m_shared;
+  SafeThreadOwner<Thread> m_owner;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_ASYNCLOGSINK_H_
@@ -0,0 +1,198 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_BINARYLOG_H_
+#define WPIUTIL_SUPPORT_BINARYLOG_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "llvm/StringRef.h"
+#include "llvm/raw_ostream.h"
+
+namespace wpi {
+
+struct LogRecord;
+
+// Binary deferred-format logging.
+//
+// A call site describes its message once, in a static BinaryLogSite holding
+// the level, file, line and format string.  Each call then only copies the
+// raw argument values (tagged with their type) next to the site id; the
+// text is rendered later, either by the AsyncLogSink drain thread or offline
+// from a binary log file (see BinaryLogFileWriter and the wpilogdecode
+// tool).
+//
+// Formats use "{}" for each argument, e.g.
+//   WPI_BLOG(sink, WPI_LOG_INFO, "sensor {} read {}", id, value);
+// Use "{{" for a literal "{".  Supported argument types are integers,
+// floating point, bool, char, and strings (const char*, StringRef,
+// std::string), which are copied.
+
+// Static description of a binary log call site.  Registers itself on
+// construction and must have static storage duration.
+class BinaryLogSite {
+ public:
+  BinaryLogSite(unsigned int level, const char* file, unsigned int line,
+                const char* format);
+
+  BinaryLogSite(const BinaryLogSite&) = delete;
+  BinaryLogSite& operator=(const BinaryLogSite&) = delete;
+
+  // Process-unique id (nonzero), assigned at registration.
+  uint32_t id() const { return m_id; }
+  unsigned int level() const { return m_level; }
+  const char* file() const { return m_file; }
+  unsigned int line() const { return m_line; }
+  const char* format() const { return m_format; }
+
+  // Looks up a registered site; returns nullptr if unknown.
+  static const BinaryLogSite* Get(uint32_t id);
+
+ private:
+  uint32_t m_id;
+  unsigned int m_level;
+  const char* m_file;
+  unsigned int m_line;
+  const char* m_format;
+};
+
+// Renders encoded arguments (see detail::BinaryEncode) with format.
+// Malformed or truncated argument data renders as "<?>".
+void RenderBinaryLog(llvm::StringRef format, llvm::StringRef args,
+                     llvm::raw_ostream& os);
+
+// Writes LogRecords in the binary log file format.  Binary records are
+// stored unrendered along with a one-time description of their site; text
+// records are stored as text.  Values are written in host byte order.
+class BinaryLogFileWriter {
+ public:
+  // Writes the file header.
+  explicit BinaryLogFileWriter(llvm::raw_ostream& os);
+
+  void Write(const LogRecord& record);
+
+ private:
+  llvm::raw_ostream& m_os;
+  std::vector<bool> m_sitesWritten;
+};
+
+// Decodes a binary log file, printing one line per message in the same
+// format as AsyncLogSink::StreamWriter.  Returns false if the data is not a
+// binary log or is malformed (everything before the error is printed).
+bool DecodeBinaryLog(llvm::StringRef data, llvm::raw_ostream& os);
+
+namespace detail {
+
+enum BinaryArgTag : uint8_t {
+  kBinaryArgInt = 1,     // int64_t
+  kBinaryArgUInt = 2,    // uint64_t
+  kBinaryArgDouble = 3,  // double
+  kBinaryArgBool = 4,    // uint8_t
+  kBinaryArgChar = 5,    // char
+  kBinaryArgString = 6   // uint16_t length, then bytes
+};
+
+// Encoders for each supported type.  Each writes a tag and the value into
+// [pos, end) and returns the new position; a value that doesn't fit is
+// dropped (strings are truncated instead).
+template <typename T>
+inline uint8_t* BinaryPut(uint8_t* pos, uint8_t* end, BinaryArgTag tag,
+                          T value) {
+  if (static_cast<size_t>(end - pos) < 1 + sizeof(T)) return pos;
+  *pos++ = tag;
+  std::memcpy(pos, &value, sizeof(T));
+  return pos + sizeof(T);
+}
+
+inline uint8_t* BinaryPutString(uint8_t* pos, uint8_t* end, const char* str,
+                                size_t len) {
+  if (end - pos < 3) return pos;
+  *pos++ = kBinaryArgString;
+  size_t room = static_cast<size_t>(end - pos) - 2;
+  uint16_t n = static_cast<uint16_t>(len < room ? len : room);
+  std::memcpy(pos, &n, 2);
+  std::memcpy(pos + 2, str, n);
+  return pos + 2 + n;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value &&
+                                   std::is_signed<T>::value &&
+                                   !std::is_same<T, char>::value,
+                               uint8_t*>::type
+BinaryEncodeArg(uint8_t* pos, uint8_t* end, T value) {
+  return BinaryPut(pos, end, kBinaryArgInt, static_cast<int64_t>(value));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value &&
+                                   std::is_unsigned<T>::value &&
+                                   !std::is_same<T, bool>::value &&
+                                   !std::is_same<T, char>::value,
+                               uint8_t*>::type
+BinaryEncodeArg(uint8_t* pos, uint8_t* end, T value) {
+  return BinaryPut(pos, end, kBinaryArgUInt, static_cast<uint64_t>(value));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value,
+                               uint8_t*>::type
+BinaryEncodeArg(uint8_t* pos, uint8_t* end, T value) {
+  return BinaryPut(pos, end, kBinaryArgDouble, static_cast<double>(value));
+}
+
+inline uint8_t* BinaryEncodeArg(uint8_t* pos, uint8_t* end, bool value) {
+  return BinaryPut(pos, end, kBinaryArgBool, static_cast<uint8_t>(value));
+}
+
+inline uint8_t* BinaryEncodeArg(uint8_t* pos, uint8_t* end, char value) {
+  return BinaryPut(pos, end, kBinaryArgChar, value);
+}
+
+inline uint8_t* BinaryEncodeArg(uint8_t* pos, uint8_t* end,
+                                const char* value) {
+  return BinaryPutString(pos, end, value, std::strlen(value));
+}
+
+inline uint8_t* BinaryEncodeArg(uint8_t* pos, uint8_t* end,
+                                llvm::StringRef value) {
+  return BinaryPutString(pos, end, value.data(), value.size());
+}
+
+inline uint8_t* BinaryEncodeArg(uint8_t* pos, uint8_t* end,
+                                const std::string& value) {
+  return BinaryPutString(pos, end, value.data(), value.size());
+}
+
+inline uint8_t* BinaryEncode(uint8_t* pos, uint8_t*) { return pos; }
+
+template <typename T, typename... Args>
+inline uint8_t* BinaryEncode(uint8_t* pos, uint8_t* end, const T& value,
+                             const Args&... args) {
+  return BinaryEncode(BinaryEncodeArg(pos, end, value), end, args...);
+}
+
+}  // namespace detail
+
+}  // namespace wpi
+
+// Logs a binary message to an AsyncLogSink.  Requires at least one argument
+// after the format; use AsyncLogSink::Log for constant messages.
+#define WPI_BLOG(sink, level, format, ...)                                \
+  do {                                                                    \
+    static const ::wpi::BinaryLogSite WPI_blog_site_{level, __FILE__,     \
+                                                     __LINE__, format};   \
+    (sink).LogBinary(WPI_blog_site_, __VA_ARGS__);                        \
+  } while (0)
+
+#endif  // WPIUTIL_SUPPORT_BINARYLOG_H_
@@ -7,10 +7,12 @@
 #ifndef WPIUTIL_SUPPORT_CONCURRENTQUEUE_H_
 #define WPIUTIL_SUPPORT_CONCURRENTQUEUE_H_
 
+#include <chrono>
 #include <queue>
 #include <thread>
 #include <utility>
 
+#include "support/Metrics.h"
 #include "support/condition_variable.h"
 #include "support/mutex.h"
 
@@ -19,21 +21,21 @@ namespace wpi {
 template <typename T>
 class ConcurrentQueue {
  public:
+  typedef typename std::queue<T>::size_type size_type;
+
   bool empty() const {
     std::unique_lock<wpi::mutex> mlock(mutex_);
     return queue_.empty();
   }
 
-  typename std::queue<T>::size_type size() const {
+  size_type size() const {
     std::unique_lock<wpi::mutex> mlock(mutex_);
     return queue_.size();
   }
 
   T pop() {
     std::unique_lock<wpi::mutex> mlock(mutex_);
-    while (queue_.empty()) {
-      cond_.wait(mlock);
-    }
+    wait_nonempty(mlock);
     auto item = std::move(queue_.front());
     queue_.pop();
     return item;
@@ -41,11 +43,61 @@ class ConcurrentQueue {
 
   void pop(T& item) {
     std::unique_lock<wpi::mutex> mlock(mutex_);
-    while (queue_.empty()) {
-      cond_.wait(mlock);
-    }
-    item = queue_.front();
+    wait_nonempty(mlock);
+    item = std::move(queue_.front());
+    queue_.pop();
+  }
+
+  // Pops an item if one is available.  Returns false if the queue is empty.
+  bool try_pop(T& item) {
+    std::unique_lock<wpi::mutex> mlock(mutex_);
+    if (queue_.empty()) return false;
+    item = std::move(queue_.front());
     queue_.pop();
+    return true;
+  }
+
+  // Waits up to timeout for an item.  Returns false if the timeout expired
+  // with the queue still empty.
+  template <typename Rep, typename Period>
+  bool pop_for(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<wpi::mutex> mlock(mutex_);
+    if (!cond_.wait_for(mlock, timeout, [&] { return !queue_.empty(); }))
+      return false;
+    item = std::move(queue_.front());
+    queue_.pop();
+    return true;
+  }
+
+  // Waits for at least one item, then moves up to max items to out, all
+  // under a single lock acquisition.  Returns the number of items popped.
+  template <typename OutputIt>
+  size_type pop_n(OutputIt out, size_type max) {
+    std::unique_lock<wpi::mutex> mlock(mutex_);
+    wait_nonempty(mlock);
+    size_type count = 0;
+    for (; count < max && !queue_.empty(); ++count) {
+      *out++ = std::move(queue_.front());
+      queue_.pop();
+    }
+    return count;
+  }
+
+  // Waits for at least one item, then takes every queued item.  The queue
+  // contents are swapped out under the lock and moved to out after the lock
+  // is released, so producers are only blocked for the swap.  Returns the
+  // number of items popped.
+  template <typename OutputIt>
+  size_type pop_all(OutputIt out) {
+    std::queue<T> items;
+    {
+      std::unique_lock<wpi::mutex> mlock(mutex_);
+      wait_nonempty(mlock);
+      items.swap(queue_);
+    }
+    size_type count = items.size();
+    for (; !items.empty(); items.pop()) *out++ = std::move(items.front());
+    return count;
   }
 
   void push(const T& item) {
@@ -70,11 +122,35 @@ class ConcurrentQueue {
     cond_.notify_one();
   }
 
+  // Pushes all items in [first, last) under a single lock acquisition.
+  template <typename InputIt>
+  void push_range(InputIt first, InputIt last) {
+    std::unique_lock<wpi::mutex> mlock(mutex_);
+    size_type count = 0;
+    for (; first != last; ++first, ++count) queue_.push(*first);
+    mlock.unlock();
+    if (count == 1)
+      cond_.notify_one();
+    else if (count > 1)
+      cond_.notify_all();
+  }
+
   ConcurrentQueue() = default;
   ConcurrentQueue(const ConcurrentQueue&) = delete;
   ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
 
  private:
+  void wait_nonempty(std::unique_lock<wpi::mutex>& mlock) {
+    if (!queue_.empty()) return;
+    // time spent blocked, when instrumentation is enabled
+    static LatencyHistogram& waits =
+        MetricsRegistry::GetInstance().GetHistogram("concurrentqueue.wait_ns");
+    ScopedLatency timer(waits);
+    do {
+      cond_.wait(mlock);
+    } while (queue_.empty());
+  }
+
   std::queue<T> queue_;
   mutable wpi::mutex mutex_;
   wpi::condition_variable cond_;
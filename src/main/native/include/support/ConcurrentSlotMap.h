@@ -0,0 +1,257 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_CONCURRENTSLOTMAP_H_
+#define WPIUTIL_SUPPORT_CONCURRENTSLOTMAP_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "llvm/MathExtras.h"
+#include "support/Rcu.h"
+#include "support/UidVector.h"
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Occupancy of a ConcurrentSlotMap at one point in time.
+struct ConcurrentSlotMapStats {
+  size_t live;            // elements currently stored
+  size_t peakLive;        // most elements ever stored at once
+  size_t capacity;        // slots in allocated segments
+  size_t used;            // slots ever handed out (live + free)
+  size_t free;            // slots waiting on the freelist
+  size_t segments;        // allocated segments
+  uint64_t staleLookups;  // lookups with an erased or reused handle
+};
+
+// Handle table shared between threads.
+//
+// Like SlotMap, handles pack a slot index with a generation so erased
+// handles are detected as stale.  Lookups are lock-free, and successful
+// lookups never write shared memory: they run inside an RCU read-side
+// critical section, and erased elements are reclaimed through RcuRetire()
+// once no lookup can still be using them.  Insertion and erasure are
+// serialized by a mutex.
+//
+// Slots live in segments of doubling size that are allocated on demand and
+// never moved, so growing the table doesn't disturb concurrent lookups.
+//
+// @tparam T element type
+// @tparam reuse_threshold how many free slots to store up before starting
+//                         to recycle them (delays reuse of a slot index)
+template <typename T, size_t reuse_threshold = 0>
+class ConcurrentSlotMap {
+ public:
+  typedef uint64_t handle_type;
+
+  // Never returned by emplace().
+  static constexpr handle_type kInvalidHandle = 0;
+
+  ConcurrentSlotMap() = default;
+  ConcurrentSlotMap(const ConcurrentSlotMap&) = delete;
+  ConcurrentSlotMap& operator=(const ConcurrentSlotMap&) = delete;
+
+  // Not safe to call concurrently with any other member function.
+  ~ConcurrentSlotMap() {
+    for (size_t s = 0; s < kMaxSegments; ++s) {
+      Slot* segment = m_segments[s].load(std::memory_order_relaxed);
+      if (!segment) continue;
+      for (size_t i = 0; i < SegmentSize(s); ++i)
+        delete segment[i].value.load(std::memory_order_relaxed);
+      delete[] segment;
+    }
+  }
+
+  // Constructs a new element and returns its handle.  Returns
+  // kInvalidHandle if the table is full (2^32 - 1 slots).
+  template <class... Args>
+  handle_type emplace(Args&&... args) {
+    std::unique_ptr<T> value(new T(std::forward<Args>(args)...));
+    std::lock_guard<wpi::mutex> lock(m_mutex);
+    uint32_t index;
+    if (m_free.size() < reuse_threshold || m_free.empty()) {
+      size_t used = m_used.load(std::memory_order_relaxed);
+      if (used >= kMaxIndex) return kInvalidHandle;
+      index = static_cast<uint32_t>(used);
+      size_t s = SegmentOf(index);
+      if (!m_segments[s].load(std::memory_order_relaxed)) {
+        m_segments[s].store(new Slot[SegmentSize(s)],
+                            std::memory_order_release);
+        ++m_segmentCount;
+      }
+      m_used.store(used + 1, std::memory_order_release);
+    } else {
+      index = m_free.pop();
+    }
+    Slot& slot = GetSlot(index);
+    uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+    // Publishes the element; the generation was already bumped by erase(),
+    // so lookups of old handles that see the new element reject it.
+    slot.value.store(value.release(), std::memory_order_release);
+    if (++m_live > m_peakLive) m_peakLive = m_live;
+    return MakeHandle(index, generation);
+  }
+
+  // Removes the element.  Lookups already in progress may still see it; it
+  // is destroyed after they finish.  Returns false if the handle is stale.
+  bool erase(handle_type handle) {
+    T* value;
+    {
+      std::lock_guard<wpi::mutex> lock(m_mutex);
+      uint32_t index = GetIndex(handle);
+      if (index >= m_used.load(std::memory_order_relaxed)) return false;
+      Slot& slot = GetSlot(index);
+      value = slot.value.load(std::memory_order_relaxed);
+      uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+      if (!value || generation != GetGeneration(handle)) return false;
+      slot.value.store(nullptr, std::memory_order_relaxed);
+      // generation 0 is skipped so kInvalidHandle never matches
+      if (++generation == 0) generation = 1;
+      slot.generation.store(generation, std::memory_order_release);
+      m_free.push(index);
+      --m_live;
+    }
+    RcuRetire(value, [](void* p) { delete static_cast<T*>(p); });
+    return true;
+  }
+
+  // Returns the element, or nullptr if the handle is stale.  Must be called
+  // inside an RcuReadLock; the element remains valid until the lock is
+  // released even if it is erased concurrently.
+  const T* get(handle_type handle) const {
+    uint32_t index = GetIndex(handle);
+    if (index >= m_used.load(std::memory_order_acquire)) return nullptr;
+    const Slot& slot = GetSlot(index);
+    // Load the element before the generation: an element published after
+    // an erase is only visible together with the bumped generation.
+    const T* value = slot.value.load(std::memory_order_acquire);
+    if (!value ||
+        slot.generation.load(std::memory_order_acquire) !=
+            GetGeneration(handle)) {
+      m_staleLookups.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return value;
+  }
+
+  // Calls func(const T&) on the element.  Returns false (without calling
+  // func) if the handle is stale.
+  template <typename F>
+  bool Read(handle_type handle, F func) const {
+    RcuReadLock lock;
+    const T* value = get(handle);
+    if (!value) return false;
+    func(*value);
+    return true;
+  }
+
+  bool contains(handle_type handle) const {
+    RcuReadLock lock;
+    return get(handle) != nullptr;
+  }
+
+  // Calls func(handle_type, const T&) for every live element, in slot order.
+  // Elements inserted or erased concurrently may or may not be visited.
+  template <typename F>
+  void ForEach(F func) const {
+    RcuReadLock lock;
+    size_t used = m_used.load(std::memory_order_acquire);
+    for (size_t i = 0; i < used; ++i) {
+      const Slot& slot = GetSlot(static_cast<uint32_t>(i));
+      uint32_t generation = slot.generation.load(std::memory_order_acquire);
+      const T* value = slot.value.load(std::memory_order_acquire);
+      // skip slots being erased or reused while we look
+      if (!value ||
+          slot.generation.load(std::memory_order_acquire) != generation)
+        continue;
+      func(MakeHandle(static_cast<uint32_t>(i), generation), *value);
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<wpi::mutex> lock(m_mutex);
+    return m_live;
+  }
+
+  ConcurrentSlotMapStats GetStats() const {
+    std::lock_guard<wpi::mutex> lock(m_mutex);
+    ConcurrentSlotMapStats stats;
+    stats.live = m_live;
+    stats.peakLive = m_peakLive;
+    stats.capacity = 0;
+    for (size_t s = 0; s < m_segmentCount; ++s)
+      stats.capacity += SegmentSize(s);
+    stats.used = m_used.load(std::memory_order_relaxed);
+    stats.free = m_free.size();
+    stats.segments = m_segmentCount;
+    stats.staleLookups = m_staleLookups.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<T*> value{nullptr};
+    std::atomic<uint32_t> generation{1};
+  };
+
+  // Segment s holds kFirstSegment << s slots.
+  static constexpr size_t kFirstSegmentBits = 6;
+  static constexpr size_t kFirstSegment = size_t(1) << kFirstSegmentBits;
+  static constexpr size_t kMaxSegments = 32 - kFirstSegmentBits;
+  static constexpr size_t kMaxIndex =
+      kFirstSegment * ((uint64_t(1) << kMaxSegments) - 1);
+
+  static size_t SegmentSize(size_t s) { return kFirstSegment << s; }
+  static size_t SegmentOf(uint32_t index) {
+    return llvm::Log2_32((index >> kFirstSegmentBits) + 1);
+  }
+
+  Slot& GetSlot(uint32_t index) {
+    return const_cast<Slot&>(
+        static_cast<const ConcurrentSlotMap*>(this)->GetSlot(index));
+  }
+  const Slot& GetSlot(uint32_t index) const {
+    size_t s = SegmentOf(index);
+    size_t offset = index - kFirstSegment * ((size_t(1) << s) - 1);
+    return m_segments[s].load(std::memory_order_acquire)[offset];
+  }
+
+  static handle_type MakeHandle(uint32_t index, uint32_t generation) {
+    return (static_cast<handle_type>(generation) << 32) | index;
+  }
+  static uint32_t GetIndex(handle_type handle) {
+    return static_cast<uint32_t>(handle);
+  }
+  static uint32_t GetGeneration(handle_type handle) {
+    return static_cast<uint32_t>(handle >> 32);
+  }
+
+  std::atomic<Slot*> m_segments[kMaxSegments] = {};
+  // Slots [0, m_used) are in allocated segments.
+  std::atomic<size_t> m_used{0};
+  mutable std::atomic<uint64_t> m_staleLookups{0};
+
+  mutable wpi::mutex m_mutex;
+  detail::FreeRing<uint32_t> m_free;
+  size_t m_live = 0;
+  size_t m_peakLive = 0;
+  size_t m_segmentCount = 0;
+};
+
+template <typename T, size_t reuse_threshold>
+constexpr typename ConcurrentSlotMap<T, reuse_threshold>::handle_type
+    ConcurrentSlotMap<T, reuse_threshold>::kInvalidHandle;
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_CONCURRENTSLOTMAP_H_
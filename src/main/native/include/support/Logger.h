@@ -8,10 +8,14 @@
 #ifndef WPIUTIL_SUPPORT_LOGGER_H_
 #define WPIUTIL_SUPPORT_LOGGER_H_
 
+#include <stdint.h>
+
+#include <atomic>
 #include <functional>
 
 #include "llvm/SmallString.h"
 #include "llvm/raw_ostream.h"
+#include "support/timestamp.h"
 
 namespace wpi {
 
@@ -56,21 +60,115 @@ class Logger {
   unsigned int m_min_level = 20;
 };
 
+namespace detail {
+
+// Per-call-site state for the sampling and rate-limiting macros.  Each
+// macro use has its own static instance, shared by all threads and Logger
+// instances.  A suppressed call costs one or two relaxed atomic operations
+// (plus a WPI_Now() call for rate limiting) and does no formatting.
+class LogSiteState {
+ public:
+  // True for the first n calls.
+  bool FirstN(uint64_t n) {
+    if (m_count.load(std::memory_order_relaxed) >= n) return false;
+    return m_count.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+  // True for calls 1, n + 1, 2n + 1, ...
+  bool EveryN(uint64_t n) {
+    return m_count.fetch_add(1, std::memory_order_relaxed) % n == 0;
+  }
+
+  // True at most once per interval (in microseconds).  When true, sets
+  // suppressed to the number of calls dropped since the last logged one.
+  bool RateLimit(uint64_t interval, uint64_t* suppressed) {
+    uint64_t now = WPI_Now();
+    uint64_t next = m_next.load(std::memory_order_relaxed);
+    if (now < next || !m_next.compare_exchange_strong(
+                          next, now + interval, std::memory_order_relaxed)) {
+      m_suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    *suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_next{0};
+  std::atomic<uint64_t> m_suppressed{0};
+};
+
+}  // namespace detail
+
+#define WPI_LOG_EMIT_(logger, level, x)                         \
+  do {                                                          \
+    llvm::SmallString<128> log_buf_;                            \
+    llvm::raw_svector_ostream log_os_{log_buf_};                \
+    log_os_ << x;                                               \
+    (logger).Log(level, __FILE__, __LINE__, log_buf_.c_str());  \
+  } while (0)
+
 #define WPI_LOG(logger_inst, level, x)                                 \
   do {                                                                 \
     ::wpi::Logger& WPI_logger_ = logger_inst;                          \
     if (WPI_logger_.min_level() <= level && WPI_logger_.HasLogger()) { \
-      llvm::SmallString<128> log_buf_;                                 \
-      llvm::raw_svector_ostream log_os_{log_buf_};                     \
-      log_os_ << x;                                                    \
-      WPI_logger_.Log(level, __FILE__, __LINE__, log_buf_.c_str());    \
+      WPI_LOG_EMIT_(WPI_logger_, level, x);                            \
     }                                                                  \
   } while (0)
 
+// Logs only the first n times this statement runs.
+#define WPI_LOG_FIRST_N(logger_inst, level, n, x)                     \
+  do {                                                                \
+    static ::wpi::detail::LogSiteState WPI_site_;                     \
+    ::wpi::Logger& WPI_logger_ = logger_inst;                         \
+    if (WPI_logger_.min_level() <= level && WPI_logger_.HasLogger() && \
+        WPI_site_.FirstN(n)) {                                        \
+      WPI_LOG_EMIT_(WPI_logger_, level, x);                           \
+    }                                                                 \
+  } while (0)
+
+// Logs the first time and every nth time after that this statement runs.
+#define WPI_LOG_EVERY_N(logger_inst, level, n, x)                     \
+  do {                                                                \
+    static ::wpi::detail::LogSiteState WPI_site_;                     \
+    ::wpi::Logger& WPI_logger_ = logger_inst;                         \
+    if (WPI_logger_.min_level() <= level && WPI_logger_.HasLogger() && \
+        WPI_site_.EveryN(n)) {                                        \
+      WPI_LOG_EMIT_(WPI_logger_, level, x);                           \
+    }                                                                 \
+  } while (0)
+
+// Logs at most once per interval (in microseconds) from this statement.
+// The next message logged after a storm notes how many were suppressed.
+// There is no timer behind this: if the statement never runs again once
+// a storm ends, the count of suppressed messages is never reported.
+#define WPI_LOG_RATE_LIMITED(logger_inst, level, interval, x)           \
+  do {                                                                  \
+    static ::wpi::detail::LogSiteState WPI_site_;                       \
+    ::wpi::Logger& WPI_logger_ = logger_inst;                           \
+    uint64_t WPI_suppressed_;                                           \
+    if (WPI_logger_.min_level() <= level && WPI_logger_.HasLogger() &&  \
+        WPI_site_.RateLimit(interval, &WPI_suppressed_)) {              \
+      if (WPI_suppressed_ == 0)                                         \
+        WPI_LOG_EMIT_(WPI_logger_, level, x);                           \
+      else                                                              \
+        WPI_LOG_EMIT_(WPI_logger_, level,                               \
+                      x << " (suppressed " << WPI_suppressed_           \
+                        << " similar messages)");                       \
+    }                                                                   \
+  } while (0)
+
 #define WPI_ERROR(inst, x) WPI_LOG(inst, ::wpi::WPI_LOG_ERROR, x)
 #define WPI_WARNING(inst, x) WPI_LOG(inst, ::wpi::WPI_LOG_WARNING, x)
 #define WPI_INFO(inst, x) WPI_LOG(inst, ::wpi::WPI_LOG_INFO, x)
 
+// Rate-limited variants for errors that can repeat in a tight loop.
+#define WPI_ERROR_RATE_LIMITED(inst, interval, x) \
+  WPI_LOG_RATE_LIMITED(inst, ::wpi::WPI_LOG_ERROR, interval, x)
+#define WPI_WARNING_RATE_LIMITED(inst, interval, x) \
+  WPI_LOG_RATE_LIMITED(inst, ::wpi::WPI_LOG_WARNING, interval, x)
+
 #ifdef NDEBUG
 #define WPI_DEBUG(inst, x) \
   do {                     \
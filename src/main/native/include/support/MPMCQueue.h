@@ -0,0 +1,252 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_MPMCQUEUE_H_
+#define WPIUTIL_SUPPORT_MPMCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "support/condition_variable.h"
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Bounded lock-free multi-producer multi-consumer queue.
+//
+// This is a ring of sequence-numbered slots (after Dmitry Vyukov's bounded
+// MPMC queue).  Producers and consumers each claim a position with a single
+// CAS and then hand the slot over by publishing its sequence number, so the
+// non-blocking try_push() and try_pop() never take a lock.  Each slot is
+// padded to its own cache line so neighboring operations do not false-share.
+//
+// The blocking push() and pop() spin briefly and only fall back to sleeping
+// on a condition variable when the queue stays full (or empty).  Wakeups are
+// only signaled when a thread is actually sleeping, so the uncontended path
+// never touches the mutex.
+//
+// @tparam T element type; must be move-constructible
+template <typename T>
+class MPMCQueue {
+ public:
+  typedef size_t size_type;
+
+  // Creates a queue.  The capacity is rounded up to the next power of two
+  // (minimum 2).
+  explicit MPMCQueue(size_type capacity);
+  ~MPMCQueue();
+
+  MPMCQueue(const MPMCQueue&) = delete;
+  MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+  size_type capacity() const { return m_mask + 1; }
+
+  // Approximate number of elements; exact only when no other thread is
+  // pushing or popping.
+  size_type size() const {
+    size_type tail = m_tail.load(std::memory_order_acquire);
+    size_type head = m_head.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Non-blocking operations.  Return false if the queue is full (for push)
+  // or empty (for pop).
+  bool try_push(const T& item) { return try_emplace(item); }
+  bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    Slot* slot;
+    if (!claim_push(&slot)) return false;
+    new (&slot->storage) T(std::forward<Args>(args)...);
+    publish_push(slot);
+    return true;
+  }
+
+  bool try_pop(T& item) {
+    Slot* slot;
+    if (!claim_pop(&slot)) return false;
+    T* elem = reinterpret_cast<T*>(&slot->storage);
+    item = std::move(*elem);
+    elem->~T();
+    publish_pop(slot);
+    return true;
+  }
+
+  // Blocking operations.  Wait until space (for push) or an element (for
+  // pop) is available.
+  void push(const T& item) { emplace(item); }
+  void push(T&& item) { emplace(std::move(item)); }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    Slot* slot;
+    if (!claim_push(&slot)) {
+      // Slow path: wait for a consumer to free a slot.
+      wait_for_claim(m_pushWaiters, m_notFull,
+                     [&] { return claim_push(&slot); });
+    }
+    new (&slot->storage) T(std::forward<Args>(args)...);
+    publish_push(slot);
+  }
+
+  T pop() {
+    Slot* slot;
+    if (!claim_pop(&slot)) {
+      wait_for_claim(m_popWaiters, m_notEmpty,
+                     [&] { return claim_pop(&slot); });
+    }
+    T* elem = reinterpret_cast<T*>(&slot->storage);
+    T item = std::move(*elem);
+    elem->~T();
+    publish_pop(slot);
+    return item;
+  }
+
+  void pop(T& item) { item = pop(); }
+
+ private:
+  // Number of failed claim attempts before a blocking operation sleeps.
+  static constexpr int kSpinCount = 64;
+
+  // Assumed cache line size for padding.
+  static constexpr size_t kCacheLine = 64;
+
+  struct Slot {
+    std::atomic<size_type> seq;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    char pad[kCacheLine > sizeof(std::atomic<size_type>) + sizeof(T)
+                 ? kCacheLine - sizeof(std::atomic<size_type>) - sizeof(T)
+                 : 1];
+  };
+
+  static size_type RoundUpCapacity(size_type capacity) {
+    size_type n = 2;
+    while (n < capacity) n <<= 1;
+    return n;
+  }
+
+  bool claim_push(Slot** out) {
+    size_type pos = m_tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot* slot = &m_slots[pos & m_mask];
+      size_type seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (m_tail.compare_exchange_weak(pos, pos + 1,
+                                         std::memory_order_relaxed)) {
+          *out = slot;
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // full
+      } else {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool claim_pop(Slot** out) {
+    size_type pos = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot* slot = &m_slots[pos & m_mask];
+      size_type seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1,
+                                         std::memory_order_relaxed)) {
+          *out = slot;
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // empty
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void publish_push(Slot* slot) {
+    size_type seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_release);
+    wake(m_popWaiters, m_notEmpty);
+  }
+
+  void publish_pop(Slot* slot) {
+    // The slot was claimed at sequence pos + 1; hand it to the producer that
+    // will claim position pos + capacity.
+    size_type seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + m_mask, std::memory_order_release);
+    wake(m_pushWaiters, m_notFull);
+  }
+
+  void wake(std::atomic<int>& waiters, wpi::condition_variable& cond) {
+    // Pairs with the increment of waiters in wait_for_claim(); either the
+    // waiter sees our publication or we see the waiter.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<wpi::mutex> lock(m_mutex);
+    cond.notify_one();
+  }
+
+  template <typename Claim>
+  void wait_for_claim(std::atomic<int>& waiters, wpi::condition_variable& cond,
+                      Claim claim) {
+    for (int i = 0; i < kSpinCount; ++i) {
+      std::this_thread::yield();
+      if (claim()) return;
+    }
+    std::unique_lock<wpi::mutex> lock(m_mutex);
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!claim()) cond.wait(lock);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<Slot[]> m_slots;
+  size_type m_mask;
+
+  char m_pad0[kCacheLine];
+  std::atomic<size_type> m_tail{0};
+  char m_pad1[kCacheLine - sizeof(std::atomic<size_type>)];
+  std::atomic<size_type> m_head{0};
+  char m_pad2[kCacheLine - sizeof(std::atomic<size_type>)];
+
+  std::atomic<int> m_pushWaiters{0};
+  std::atomic<int> m_popWaiters{0};
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_notFull;
+  wpi::condition_variable m_notEmpty;
+};
+
+template <typename T>
+MPMCQueue<T>::MPMCQueue(size_type capacity)
+    : m_slots(new Slot[RoundUpCapacity(capacity)]),
+      m_mask(RoundUpCapacity(capacity) - 1) {
+  for (size_type i = 0; i <= m_mask; ++i)
+    m_slots[i].seq.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+MPMCQueue<T>::~MPMCQueue() {
+  size_type head = m_head.load(std::memory_order_relaxed);
+  size_type tail = m_tail.load(std::memory_order_relaxed);
+  for (; head != tail; ++head)
+    reinterpret_cast<T*>(&m_slots[head & m_mask].storage)->~T();
+}
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_MPMCQUEUE_H_
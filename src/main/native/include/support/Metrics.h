@@ -0,0 +1,201 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_METRICS_H_
+#define WPIUTIL_SUPPORT_METRICS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/MathExtras.h"
+#include "llvm/StringRef.h"
+#include "support/mutex.h"
+#include "support/timestamp.h"
+
+namespace wpi {
+
+class json;
+
+// Monotonically increasing count.
+class MetricCounter {
+ public:
+  void Add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> m_value{0};
+};
+
+// Value that can go up and down.
+class MetricGauge {
+ public:
+  void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  void Add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+  int64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> m_value{0};
+};
+
+// Point-in-time copy of a LatencyHistogram.
+struct HistogramSnapshot {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+  std::vector<uint64_t> buckets;  // counts, indexed as LatencyHistogram
+
+  double Mean() const { return count == 0 ? 0 : double(sum) / count; }
+
+  // Returns an upper bound for the q quantile (0 <= q <= 1), accurate to
+  // the bucket resolution; 0 if empty.
+  uint64_t Percentile(double q) const;
+};
+
+// Log-linear (HDR-style) histogram of non-negative values, normally
+// latencies in nanoseconds.  Each power of two is split into kSubBuckets
+// linear buckets, so recorded values keep a relative precision of 1 /
+// kSubBuckets; values of 2^kMaxBits and above are counted in the last
+// bucket.
+//
+// Recording is lock-free: each thread updates one of kShards shards with
+// relaxed atomic adds, and Snapshot() merges the shards.
+class LatencyHistogram {
+ public:
+  static constexpr unsigned int kSubBucketBits = 4;
+  static constexpr unsigned int kSubBuckets = 1u << kSubBucketBits;
+  static constexpr unsigned int kMaxBits = 48;
+  static constexpr size_t kBuckets =
+      (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+  static constexpr size_t kShards = 8;
+
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(uint64_t value) {
+    Shard& shard = m_shards[ShardIndex()];
+    shard.counts[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = shard.max.load(std::memory_order_relaxed);
+    while (value > max &&
+           !shard.max.compare_exchange_weak(max, value,
+                                            std::memory_order_relaxed)) {
+    }
+  }
+
+  HistogramSnapshot Snapshot() const;
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < 2 * kSubBuckets) return static_cast<size_t>(value);
+    unsigned int shift = llvm::Log2_64(value) - kSubBucketBits;
+    size_t index = shift * kSubBuckets + static_cast<size_t>(value >> shift);
+    return index < kBuckets ? index : kBuckets - 1;
+  }
+
+  // Smallest and largest values counted in a bucket.
+  static uint64_t BucketLowerBound(size_t index);
+  static uint64_t BucketUpperBound(size_t index);
+
+ private:
+  struct Shard {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> counts[kBuckets];
+    char pad[64];
+  };
+
+  static size_t ShardIndex();
+
+  std::unique_ptr<Shard[]> m_shards;
+};
+
+namespace detail {
+extern std::atomic<bool> gMetricsInstrumentation;
+}  // namespace detail
+
+// Records the time from construction to destruction (from NowNs()) in a
+// histogram, if instrumentation is enabled (see
+// MetricsRegistry::EnableInstrumentation).
+class ScopedLatency {
+ public:
+  explicit ScopedLatency(LatencyHistogram& hist)
+      : m_hist(detail::gMetricsInstrumentation.load(std::memory_order_relaxed)
+                   ? &hist
+                   : nullptr) {
+    if (m_hist) m_start = NowNs();
+  }
+
+  ~ScopedLatency() {
+    if (m_hist) m_hist->Record(NowNs() - m_start);
+  }
+
+  ScopedLatency(const ScopedLatency&) = delete;
+  ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+  // True if this timer is recording.
+  explicit operator bool() const { return m_hist != nullptr; }
+
+ private:
+  LatencyHistogram* m_hist;
+  uint64_t m_start = 0;
+};
+
+// Named counters, gauges, and histograms.  Metrics are created on first
+// lookup and live as long as the registry, so callers should look a metric
+// up once and keep the reference.
+//
+// wpiutil's own instrumentation points (TCPStream send/receive, time spent
+// waiting in ConcurrentQueue, json::parse) record into the global registry
+// only while instrumentation is enabled.
+class MetricsRegistry {
+ public:
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  // The process-wide registry.
+  static MetricsRegistry& GetInstance();
+
+  // Turns wpiutil's built-in instrumentation on or off (off by default).
+  static void EnableInstrumentation(bool enable);
+  static bool IsInstrumentationEnabled() {
+    return detail::gMetricsInstrumentation.load(std::memory_order_relaxed);
+  }
+
+  MetricCounter& GetCounter(llvm::StringRef name);
+  MetricGauge& GetGauge(llvm::StringRef name);
+  LatencyHistogram& GetHistogram(llvm::StringRef name);
+
+  // Returns every metric as
+  //   {"counters": {name: value, ...},
+  //    "gauges": {name: value, ...},
+  //    "histograms": {name: {"count", "sum", "mean", "max", "p50", "p90",
+  //                          "p99", "p999"}, ...}}
+  json Snapshot() const;
+
+  // Snapshot() encoded as CBOR.
+  std::string SnapshotCbor() const;
+
+ private:
+  mutable wpi::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<MetricCounter>> m_counters;
+  std::map<std::string, std::unique_ptr<MetricGauge>> m_gauges;
+  std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_METRICS_H_
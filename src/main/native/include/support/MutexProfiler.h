@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_MUTEXPROFILER_H_
+#define WPIUTIL_SUPPORT_MUTEXPROFILER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/raw_ostream.h"
+#include "support/priority_mutex.h"
+
+namespace wpi {
+
+// Lock contention profiling for priority_mutex and priority_recursive_mutex
+// (and so wpi::mutex on Linux).
+//
+// Profiling is compiled in by defining WPI_MUTEX_PROFILING for the whole
+// build, wpiutil and its users alike, as it changes the layout of the mutex
+// classes.  Without it, the mutexes are unchanged and the profiler reports
+// nothing.
+//
+// With it, each mutex gets a profile on its first acquisition that records
+// acquisitions, contended acquisitions, and histograms of the time spent
+// waiting for and holding the lock.  Optionally, contended acquisitions also
+// record their call site.  Profiles of destroyed mutexes are kept if they
+// saw contention, so short-lived hot mutexes still show up.
+//
+// Name important mutexes with set_profile_name() (or SetMutexProfileName) so
+// they are easy to find in Dump() output.
+
+// Profile of one mutex.
+struct MutexProfileSnapshot {
+  std::string name;     // empty if unnamed
+  const void* mutex;    // nullptr if the mutex has been destroyed
+  uint64_t acquisitions = 0;
+  uint64_t contended = 0;  // acquisitions that had to wait
+  uint64_t waitNs = 0;     // total time spent waiting
+  uint64_t holdNs = 0;     // total time held
+  uint64_t maxWaitNs = 0;
+  uint64_t maxHoldNs = 0;
+  // Bucket i counts times in [2^i, 2^(i+1)) ns; bucket 0 also counts 0.
+  std::vector<uint64_t> waitHistogram;
+  std::vector<uint64_t> holdHistogram;
+  // Return addresses of contended lock() calls with their counts, most
+  // frequent first.  Only recorded while call site capture is on.  Without
+  // optimization, locks taken through std::lock_guard or std::unique_lock
+  // are attributed to those (non-inlined) templates.
+  std::vector<std::pair<const void*, uint64_t>> callSites;
+
+  // Upper bounds (to a power of two) of the q quantile wait and hold time.
+  uint64_t WaitPercentile(double q) const;
+  uint64_t HoldPercentile(double q) const;
+};
+
+class MutexProfiler {
+ public:
+  // True if wpiutil was built with WPI_MUTEX_PROFILING.
+  static bool IsEnabled();
+
+  // Turns recording of contended call sites on or off (off by default).
+  static void SetCaptureCallSites(bool capture);
+
+  // Returns all profiles, sorted by total wait time (highest first).
+  static std::vector<MutexProfileSnapshot> Snapshot();
+
+  // Writes a table of the profiles with any contention, sorted as for
+  // Snapshot().  Call sites are printed as addresses; resolve them with
+  // addr2line.
+  static void Dump(llvm::raw_ostream& os);
+
+  // Clears all statistics, and forgets destroyed mutexes.
+  static void Reset();
+};
+
+// Names a mutex in profiler output; works for any mutex type, but only
+// priority mutexes are profiled.
+template <typename Mutex>
+inline void SetMutexProfileName(Mutex&, const char*) {}
+
+#ifdef WPI_HAVE_PRIORITY_MUTEX
+inline void SetMutexProfileName(priority_mutex& mutex, const char* name) {
+  mutex.set_profile_name(name);
+}
+
+inline void SetMutexProfileName(priority_recursive_mutex& mutex,
+                                const char* name) {
+  mutex.set_profile_name(name);
+}
+#endif
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_MUTEXPROFILER_H_
@@ -0,0 +1,148 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_RCU_H_
+#define WPIUTIL_SUPPORT_RCU_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Epoch-based read-copy-update.
+//
+// Readers enter a read-side critical section (RcuReadLock), load pointers
+// published with RcuPtr, and may use the pointed-to objects until the
+// critical section ends.  Writers publish a new object and retire the old
+// one; a background SafeThread frees retired objects once every reader that
+// could still see them has left its critical section.
+//
+// Entering and leaving a critical section only writes a per-thread record
+// on its own cache line, so reads never block and never write memory shared
+// with other threads.  Critical sections may nest, but must not block
+// indefinitely (that delays all reclamation).
+
+namespace detail {
+
+struct RcuRecord {
+  // Epoch pinned by the outermost active critical section, 0 if none.
+  std::atomic<uint64_t> epoch{0};
+  unsigned int nesting = 0;  // only touched by the owning thread
+};
+
+extern std::atomic<uint64_t> rcuGlobalEpoch;
+
+// Registers the calling thread; its record is released at thread exit.
+RcuRecord* RcuRegisterThread();
+
+inline RcuRecord* RcuThisThread() {
+  static thread_local RcuRecord* record = nullptr;
+  if (!record) record = RcuRegisterThread();
+  return record;
+}
+
+}  // namespace detail
+
+// RAII read-side critical section.
+class RcuReadLock {
+ public:
+  RcuReadLock() : m_record(detail::RcuThisThread()) {
+    if (m_record->nesting++ != 0) return;
+    m_record->epoch.store(
+        detail::rcuGlobalEpoch.load(std::memory_order_acquire),
+        std::memory_order_relaxed);
+    // Pairs with the fence in the reclaimer: either it sees our epoch, or
+    // we see pointers published before it last advanced the epoch.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  ~RcuReadLock() {
+    if (--m_record->nesting == 0)
+      m_record->epoch.store(0, std::memory_order_release);
+  }
+
+  RcuReadLock(const RcuReadLock&) = delete;
+  RcuReadLock& operator=(const RcuReadLock&) = delete;
+
+ private:
+  detail::RcuRecord* m_record;
+};
+
+// Schedules deleter(ptr) to run once all current readers have finished.
+// Never blocks on readers.
+void RcuRetire(void* ptr, void (*deleter)(void*));
+
+// Blocks until every read-side critical section that was active when called
+// has ended.  Must not be called from inside a critical section.
+void RcuSynchronize();
+
+// Blocks until every object retired before the call has been freed.  Must
+// not be called from inside a critical section.
+void RcuBarrier();
+
+// Atomic pointer to an RCU-managed object.
+//
+// Reads (get() inside an RcuReadLock, or Read()) are a single acquire load.
+// Store() and Update() publish a new object and retire the previous one.
+template <typename T>
+class RcuPtr {
+ public:
+  RcuPtr() = default;
+  explicit RcuPtr(std::unique_ptr<T> value) : m_ptr(value.release()) {}
+  ~RcuPtr() { Retire(m_ptr.load(std::memory_order_relaxed)); }
+
+  RcuPtr(const RcuPtr&) = delete;
+  RcuPtr& operator=(const RcuPtr&) = delete;
+
+  // Returns the current object (may be null).  Must be called inside an
+  // RcuReadLock; the object remains valid until the lock is released.
+  const T* get() const { return m_ptr.load(std::memory_order_acquire); }
+
+  // Calls func(const T*) inside a read-side critical section and returns
+  // its result.
+  template <typename F>
+  auto Read(F func) const -> decltype(func(static_cast<const T*>(nullptr))) {
+    RcuReadLock lock;
+    return func(get());
+  }
+
+  // Publishes a new object (may be null) and retires the old one.
+  void Store(std::unique_ptr<T> value) {
+    std::lock_guard<wpi::mutex> lock(m_writeMutex);
+    Retire(m_ptr.exchange(value.release()));
+  }
+
+  // Copy-update: calls func(T&) on a copy of the current object (or a
+  // default-constructed one if null) and publishes the copy.  Serialized
+  // with other writers.
+  template <typename F>
+  void Update(F func) {
+    std::lock_guard<wpi::mutex> lock(m_writeMutex);
+    const T* cur = m_ptr.load(std::memory_order_relaxed);
+    std::unique_ptr<T> next(cur ? new T(*cur) : new T());
+    func(*next);
+    Retire(m_ptr.exchange(next.release()));
+  }
+
+ private:
+  static void Retire(T* ptr) {
+    if (ptr) RcuRetire(ptr, [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  std::atomic<T*> m_ptr{nullptr};
+  wpi::mutex m_writeMutex;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_RCU_H_
@@ -0,0 +1,293 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_SPSCQUEUE_H_
+#define WPIUTIL_SUPPORT_SPSCQUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "llvm/ArrayRef.h"
+#include "support/SafeThread.h"
+#include "support/condition_variable.h"
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Bounded wait-free single-producer single-consumer ring buffer.
+//
+// Exactly one thread may call the producer functions (try_push, reserve,
+// commit) and exactly one thread may call the consumer functions (try_pop,
+// peek, consume).  Each side keeps a private cached copy of the other side's
+// index and only reloads the shared index when the cache says the ring is
+// full (or empty), so in steady state an operation touches no cache line
+// written by the other thread.
+//
+// reserve()/commit() and peek()/consume() give direct access to contiguous
+// runs of elements, so records can be written and read in place with one
+// synchronization per batch rather than one per element.
+//
+// @tparam T element type; must be default-constructible and move-assignable
+//           (all slots are constructed up front)
+template <typename T>
+class SPSCQueue {
+ public:
+  typedef size_t size_type;
+
+  // Creates a queue.  The capacity is rounded up to the next power of two
+  // (minimum 2).
+  explicit SPSCQueue(size_type capacity)
+      : m_mask(RoundUpCapacity(capacity) - 1), m_buf(new T[m_mask + 1]) {}
+
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  size_type capacity() const { return m_mask + 1; }
+
+  // Number of elements; exact when called from the producer or consumer
+  // thread with the other side idle, approximate otherwise.
+  size_type size() const {
+    return m_tail.load(std::memory_order_acquire) -
+           m_head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Producer: adds an element.  Returns false if the queue is full.
+  bool try_push(const T& item) {
+    auto buf = reserve(1);
+    if (buf.empty()) return false;
+    buf[0] = item;
+    commit(1);
+    return true;
+  }
+
+  bool try_push(T&& item) {
+    auto buf = reserve(1);
+    if (buf.empty()) return false;
+    buf[0] = std::move(item);
+    commit(1);
+    return true;
+  }
+
+  // Producer: returns a contiguous run of up to n writable slots.  The run
+  // may be shorter than n (if the ring is nearly full or the free space
+  // wraps around the end of the buffer) and is empty if the ring is full.
+  // Nothing is visible to the consumer until commit() is called.
+  llvm::MutableArrayRef<T> reserve(size_type n) {
+    size_type tail = m_tail.load(std::memory_order_relaxed);
+    size_type avail = capacity() - (tail - m_headCache);
+    if (avail < n) {
+      m_headCache = m_head.load(std::memory_order_acquire);
+      avail = capacity() - (tail - m_headCache);
+    }
+    size_type index = tail & m_mask;
+    n = std::min(n, std::min(avail, capacity() - index));
+    return llvm::MutableArrayRef<T>(&m_buf[index], n);
+  }
+
+  // Producer: publishes the first n slots of the last reserve().
+  void commit(size_type n) {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + n,
+                 std::memory_order_release);
+  }
+
+  // Consumer: removes an element.  Returns false if the queue is empty.
+  bool try_pop(T& item) {
+    auto buf = peek(1);
+    if (buf.empty()) return false;
+    item = std::move(buf[0]);
+    consume(1);
+    return true;
+  }
+
+  // Consumer: returns a contiguous run of up to max readable elements
+  // (shorter if the data wraps around the end of the buffer; empty if the
+  // queue is empty).  Elements may be moved from; the slots are not reused
+  // until consume() is called.
+  llvm::MutableArrayRef<T> peek(size_type max = static_cast<size_type>(-1)) {
+    size_type head = m_head.load(std::memory_order_relaxed);
+    size_type avail = m_tailCache - head;
+    if (avail == 0 || avail < max) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+      avail = m_tailCache - head;
+    }
+    size_type index = head & m_mask;
+    size_type n = std::min(max, std::min(avail, capacity() - index));
+    return llvm::MutableArrayRef<T>(&m_buf[index], n);
+  }
+
+  // Consumer: releases the first n elements of the last peek() back to the
+  // producer.
+  void consume(size_type n) {
+    m_head.store(m_head.load(std::memory_order_relaxed) + n,
+                 std::memory_order_release);
+  }
+
+ private:
+  static constexpr size_t kCacheLine = 64;
+
+  static size_type RoundUpCapacity(size_type capacity) {
+    size_type n = 2;
+    while (n < capacity) n <<= 1;
+    return n;
+  }
+
+  // Read-only after construction.
+  size_type m_mask;
+  std::unique_ptr<T[]> m_buf;
+
+  // Producer-owned line.
+  char m_pad0[kCacheLine];
+  std::atomic<size_type> m_tail{0};
+  size_type m_headCache = 0;
+
+  // Consumer-owned line.
+  char m_pad1[kCacheLine - sizeof(std::atomic<size_type>) - sizeof(size_type)];
+  std::atomic<size_type> m_head{0};
+  size_type m_tailCache = 0;
+  char m_pad2[kCacheLine - sizeof(std::atomic<size_type>) - sizeof(size_type)];
+};
+
+// SPSCQueue with blocking push and pop.
+//
+// The waits use an externally provided mutex and condition variable so the
+// consumer can be a SafeThread: constructing the queue from the thread
+// shares its m_mutex and m_cond, so SafeThreadOwner::Stop() (which clears
+// m_active and signals m_cond) also wakes a consumer blocked in pop().  The
+// mutex is only taken when one side is actually asleep.
+template <typename T>
+class BlockingSPSCQueue {
+ public:
+  typedef typename SPSCQueue<T>::size_type size_type;
+
+  BlockingSPSCQueue(size_type capacity, wpi::mutex& mutex,
+                    wpi::condition_variable& cond)
+      : m_queue(capacity), m_mutex(mutex), m_cond(cond) {}
+  BlockingSPSCQueue(size_type capacity, SafeThread& thr)
+      : BlockingSPSCQueue(capacity, thr.m_mutex, thr.m_cond) {}
+
+  size_type capacity() const { return m_queue.capacity(); }
+  size_type size() const { return m_queue.size(); }
+  bool empty() const { return m_queue.empty(); }
+
+  // Producer: adds an element without waiting.  Returns false if the queue
+  // is full.
+  bool try_push(const T& item) { return notify_if(m_queue.try_push(item)); }
+  bool try_push(T&& item) {
+    return notify_if(m_queue.try_push(std::move(item)));
+  }
+
+  // Producer: adds an element, waiting for space if the queue is full.
+  // Returns false (without adding) if active becomes false while waiting.
+  bool push(T&& item, const std::atomic_bool& active) {
+    llvm::MutableArrayRef<T> buf;
+    if (!wait([&] { return !(buf = m_queue.reserve(1)).empty(); }, active))
+      return false;
+    buf[0] = std::move(item);
+    commit(1);
+    return true;
+  }
+
+  bool push(const T& item, const std::atomic_bool& active) {
+    T copy(item);
+    return push(std::move(copy), active);
+  }
+
+  // Producer: see SPSCQueue::reserve().  commit() also wakes a sleeping
+  // consumer.
+  llvm::MutableArrayRef<T> reserve(size_type n) { return m_queue.reserve(n); }
+  void commit(size_type n) {
+    m_queue.commit(n);
+    notify();
+  }
+
+  // Consumer: removes an element without waiting.  Returns false if the
+  // queue is empty.
+  bool try_pop(T& item) { return notify_if(m_queue.try_pop(item)); }
+
+  // Consumer: removes an element, waiting for one if the queue is empty.
+  // Returns false if active becomes false while waiting.
+  bool pop(T& item, const std::atomic_bool& active) {
+    llvm::MutableArrayRef<T> buf;
+    if (!wait([&] { return !(buf = m_queue.peek(1)).empty(); }, active))
+      return false;
+    item = std::move(buf[0]);
+    consume(1);
+    return true;
+  }
+
+  // Consumer: see SPSCQueue::peek().  consume() also wakes a producer
+  // waiting for space.
+  llvm::MutableArrayRef<T> peek(size_type max = static_cast<size_type>(-1)) {
+    return m_queue.peek(max);
+  }
+  void consume(size_type n) {
+    m_queue.consume(n);
+    notify();
+  }
+
+  // Consumer: waits for data and returns a contiguous run of up to max
+  // elements.  Returns an empty run if active becomes false while waiting.
+  llvm::MutableArrayRef<T> wait_peek(size_type max,
+                                     const std::atomic_bool& active) {
+    llvm::MutableArrayRef<T> buf;
+    wait([&] { return !(buf = m_queue.peek(max)).empty(); }, active);
+    return buf;
+  }
+
+  // Wakes whichever side is sleeping.
+  void notify() {
+    // Pairs with the fence in wait(): either the sleeper sees the index we
+    // just published or we see the sleeper.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<wpi::mutex> lock(m_mutex);
+    m_cond.notify_all();
+  }
+
+ private:
+  bool notify_if(bool changed) {
+    if (changed) notify();
+    return changed;
+  }
+
+  template <typename Ready>
+  bool wait(Ready ready, const std::atomic_bool& active) {
+    if (ready()) return true;
+    std::unique_lock<wpi::mutex> lock(m_mutex);
+    m_sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool rv;
+    for (;;) {
+      if (ready()) {
+        rv = true;
+        break;
+      }
+      if (!active) {
+        rv = false;
+        break;
+      }
+      m_cond.wait(lock);
+    }
+    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return rv;
+  }
+
+  SPSCQueue<T> m_queue;
+  wpi::mutex& m_mutex;
+  wpi::condition_variable& m_cond;
+  std::atomic<int> m_sleepers{0};
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_SPSCQUEUE_H_
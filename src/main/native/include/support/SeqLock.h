@@ -0,0 +1,123 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_SEQLOCK_H_
+#define WPIUTIL_SUPPORT_SEQLOCK_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Sequence lock publishing a small trivially-copyable value.
+//
+// Readers never write shared memory: a read copies the value between two
+// loads of a sequence counter and retries if a write overlapped.  Writes
+// are serialized by a mutex and make the counter odd while in progress.
+// Suited to values that are read far more often than written (robot state,
+// configuration snapshots); a read costs about one copy of T.
+//
+// The value is stored as relaxed atomic words, so concurrent reads and
+// writes are well-defined.
+//
+// @tparam T value type; must be trivially copyable and default-constructible
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock requires a trivially copyable type");
+
+ public:
+  SeqLock() : SeqLock(T()) {}
+  explicit SeqLock(const T& value) { StoreWords(value); }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  // Returns a consistent copy of the value.  Never blocks, but retries (and
+  // eventually yields) while a write is in progress.
+  T Load() const {
+    T value;
+    for (int tries = 0;; ++tries) {
+      if (TryLoad(value)) return value;
+      if (tries >= 100) std::this_thread::yield();
+    }
+  }
+
+  // Tries once to copy the value.  Returns false if a write overlapped.
+  bool TryLoad(T& value) const {
+    uint64_t seq0 = m_seq.load(std::memory_order_acquire);
+    if ((seq0 & 1) != 0) return false;
+    uint64_t buf[kWords];
+    for (size_t i = 0; i < kWords; ++i)
+      buf[i] = m_words[i].load(std::memory_order_relaxed);
+    // keep the word loads from moving below the second counter load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_seq.load(std::memory_order_relaxed) != seq0) return false;
+    std::memcpy(&value, buf, sizeof(T));
+    return true;
+  }
+
+  // Publishes a new value.
+  void Store(const T& value) {
+    std::lock_guard<wpi::mutex> lock(m_writeMutex);
+    Publish(value);
+  }
+
+  // Read-modify-write: calls func(T&) on a copy of the current value and
+  // publishes the result.  Serialized with other writers.
+  template <typename F>
+  void Update(F func) {
+    std::lock_guard<wpi::mutex> lock(m_writeMutex);
+    T value;
+    LoadWordsUnsynchronized(value);
+    func(value);
+    Publish(value);
+  }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+  // Only called with m_writeMutex held.
+  void Publish(const T& value) {
+    uint64_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);
+    // keep the word stores from moving above the odd counter
+    std::atomic_thread_fence(std::memory_order_release);
+    StoreWords(value);
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+  void StoreWords(const T& value) {
+    uint64_t buf[kWords] = {0};
+    std::memcpy(buf, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; ++i)
+      m_words[i].store(buf[i], std::memory_order_relaxed);
+  }
+
+  // Only valid with m_writeMutex held.
+  void LoadWordsUnsynchronized(T& value) const {
+    uint64_t buf[kWords];
+    for (size_t i = 0; i < kWords; ++i)
+      buf[i] = m_words[i].load(std::memory_order_relaxed);
+    std::memcpy(&value, buf, sizeof(T));
+  }
+
+  std::atomic<uint64_t> m_seq{0};
+  std::atomic<uint64_t> m_words[kWords];
+  wpi::mutex m_writeMutex;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_SEQLOCK_H_
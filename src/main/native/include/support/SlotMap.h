@@ -0,0 +1,209 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_SLOTMAP_H_
+#define WPIUTIL_SUPPORT_SLOTMAP_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "support/UidVector.h"
+
+namespace wpi {
+
+// Container addressed by generation-tagged handles.
+//
+// A handle packs a slot index (low 32 bits) with the slot's generation (high
+// 32 bits).  Erasing an element bumps its slot's generation, so handles to
+// erased elements are detected as stale even after the slot is reused.
+// Insert, erase and lookup are O(1); freed slots are reused oldest first.
+//
+// Elements are never moved: pointers and references remain valid until the
+// element is erased.  Iterating visits only live elements, in slot order.
+//
+// @tparam T element type
+// @tparam reuse_threshold how many free slots to store up before starting
+//                         to recycle them
+template <typename T, size_t reuse_threshold = 0>
+class SlotMap {
+  template <bool Const>
+  class Iterator;
+
+ public:
+  typedef uint64_t handle_type;
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  // Never returned by emplace().
+  static constexpr handle_type kInvalidHandle = 0;
+
+  SlotMap() = default;
+  ~SlotMap() { clear(); }
+
+  SlotMap(const SlotMap&) = delete;
+  SlotMap& operator=(const SlotMap&) = delete;
+
+  bool empty() const { return m_size == 0; }
+  size_t size() const { return m_size; }
+
+  // Constructs a new element in place and returns its handle.
+  template <class... Args>
+  handle_type emplace(Args&&... args) {
+    uint32_t index;
+    if (m_free.size() < reuse_threshold || m_free.empty()) {
+      index = static_cast<uint32_t>(m_slots.size());
+      m_slots.emplace_back();
+    } else {
+      index = m_free.pop();
+    }
+    Slot& slot = m_slots[index];
+    new (&slot.storage) T(std::forward<Args>(args)...);
+    slot.live = true;
+    ++m_size;
+    return MakeHandle(index, slot.generation);
+  }
+
+  // Destroys the element.  Returns false if the handle is stale.
+  bool erase(handle_type handle) {
+    Slot* slot = Lookup(handle);
+    if (!slot) return false;
+    Release(*slot, GetIndex(handle));
+    return true;
+  }
+
+  // Returns true if the handle refers to a live element.
+  bool contains(handle_type handle) const { return Lookup(handle) != nullptr; }
+
+  // Returns the element, or nullptr if the handle is stale.
+  T* get(handle_type handle) {
+    Slot* slot = Lookup(handle);
+    return slot ? slot->value() : nullptr;
+  }
+  const T* get(handle_type handle) const {
+    const Slot* slot = Lookup(handle);
+    return slot ? slot->value() : nullptr;
+  }
+
+  // Destroys all elements.  Outstanding handles become stale.
+  void clear() {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+      if (m_slots[i].live) Release(m_slots[i], static_cast<uint32_t>(i));
+    }
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, m_slots.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_slots.size()); }
+
+ private:
+  struct Slot {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    uint32_t generation = 1;
+    bool live = false;
+
+    T* value() { return reinterpret_cast<T*>(&storage); }
+    const T* value() const { return reinterpret_cast<const T*>(&storage); }
+  };
+
+  static handle_type MakeHandle(uint32_t index, uint32_t generation) {
+    return (static_cast<handle_type>(generation) << 32) | index;
+  }
+  static uint32_t GetIndex(handle_type handle) {
+    return static_cast<uint32_t>(handle);
+  }
+  static uint32_t GetGeneration(handle_type handle) {
+    return static_cast<uint32_t>(handle >> 32);
+  }
+
+  Slot* Lookup(handle_type handle) {
+    return const_cast<Slot*>(
+        static_cast<const SlotMap*>(this)->Lookup(handle));
+  }
+  const Slot* Lookup(handle_type handle) const {
+    uint32_t index = GetIndex(handle);
+    if (index >= m_slots.size()) return nullptr;
+    const Slot& slot = m_slots[index];
+    if (!slot.live || slot.generation != GetGeneration(handle)) return nullptr;
+    return &slot;
+  }
+
+  void Release(Slot& slot, uint32_t index) {
+    slot.value()->~T();
+    slot.live = false;
+    // generation 0 is skipped so kInvalidHandle never matches
+    if (++slot.generation == 0) slot.generation = 1;
+    m_free.push(index);
+    --m_size;
+  }
+
+  // Forward iterator over live elements; handle() gives the element handle.
+  template <bool Const>
+  class Iterator {
+    typedef typename std::conditional<Const, const SlotMap, SlotMap>::type
+        Container;
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type reference;
+
+    Iterator(Container* map, size_t pos) : m_map(map), m_pos(pos) {
+      SkipFree();
+    }
+
+    handle_type handle() const {
+      return MakeHandle(static_cast<uint32_t>(m_pos),
+                        m_map->m_slots[m_pos].generation);
+    }
+    reference operator*() const { return *m_map->m_slots[m_pos].value(); }
+    pointer operator->() const { return m_map->m_slots[m_pos].value(); }
+
+    Iterator& operator++() {
+      ++m_pos;
+      SkipFree();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const Iterator& oth) const { return m_pos == oth.m_pos; }
+    bool operator!=(const Iterator& oth) const { return m_pos != oth.m_pos; }
+
+   private:
+    void SkipFree() {
+      while (m_pos < m_map->m_slots.size() && !m_map->m_slots[m_pos].live)
+        ++m_pos;
+    }
+
+    Container* m_map;
+    size_t m_pos;
+  };
+
+  std::deque<Slot> m_slots;  // deque so elements never move
+  detail::FreeRing<uint32_t> m_free;
+  size_t m_size = 0;
+};
+
+template <typename T, size_t reuse_threshold>
+constexpr typename SlotMap<T, reuse_threshold>::handle_type
+    SlotMap<T, reuse_threshold>::kInvalidHandle;
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_SLOTMAP_H_
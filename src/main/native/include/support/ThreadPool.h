@@ -0,0 +1,138 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_THREADPOOL_H_
+#define WPIUTIL_SUPPORT_THREADPOOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "support/SafeThread.h"
+
+namespace wpi {
+
+// Fixed-size work-stealing thread pool.
+//
+// Each worker is a SafeThread with its own task deque.  Tasks submitted from
+// outside the pool go to a bounded global queue; tasks submitted from a
+// worker (including continuations) go to that worker's deque and run LIFO
+// while the data they touch is still hot in cache.  Idle workers take from
+// the global queue and then steal (FIFO) from other workers' deques.
+//
+// Stop() follows SafeThreadOwnerBase::Stop(): it returns immediately, and the
+// detached workers exit and clean up on their own.  By default the workers
+// first run every task already queued; the pool's shared state stays alive
+// until the last worker exits, so tasks may outlive the ThreadPool object.
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+
+  struct Options {
+    // Number of worker threads; 0 uses std::thread::hardware_concurrency().
+    unsigned int numThreads = 0;
+    // Maximum number of tasks in the global queue before Execute() blocks
+    // (tasks queued by workers are not limited).
+    size_t queueCapacity = 1024;
+    // Base thread name; workers are named "<name>-<index>".  Names are
+    // truncated to the platform limit (15 characters on Linux).
+    std::string name = "wpipool";
+    // CPUs to pin workers to; worker i is pinned to cpus[i % cpus.size()].
+    // Empty means no pinning.  Only supported on Linux.
+    std::vector<int> cpus;
+  };
+
+  ThreadPool();
+  explicit ThreadPool(const Options& options);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned int GetNumThreads() const { return m_numThreads; }
+
+  // Queues a task, waiting for space if the global queue is full.  Tasks
+  // must not throw; use Submit() to have exceptions captured in a future.
+  // Returns false if the pool has been stopped.
+  bool Execute(Task task);
+
+  // Queues a task without waiting.  Returns false if the global queue is
+  // full or the pool has been stopped.
+  bool TryExecute(Task task);
+
+  // Queues a callable and returns a future for its result.  If the pool has
+  // been stopped the future holds a std::future_error (broken_promise).
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> Submit(F&& func) {
+    typedef typename std::result_of<F()>::type R;
+    auto task =
+        std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+    auto result = task->get_future();
+    Execute([task] { (*task)(); });
+    return result;
+  }
+
+  // Queues a callable and a continuation.  When func finishes, cont is
+  // queued on the same worker and called with a ready std::future holding
+  // func's result (or exception).  Returns a future for cont's result.
+  template <typename F, typename C>
+  std::future<typename std::result_of<
+      C(std::future<typename std::result_of<F()>::type>)>::type>
+  Submit(F&& func, C&& cont) {
+    typedef typename std::result_of<F()>::type R;
+    typedef typename std::result_of<C(std::future<R>)>::type R2;
+    auto first =
+        std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+    auto second = std::make_shared<std::packaged_task<R2(std::future<R>)>>(
+        std::forward<C>(cont));
+    auto result = second->get_future();
+    std::shared_ptr<Impl> impl = m_impl;
+    Execute([impl, first, second] {
+      auto future = first->get_future();
+      (*first)();
+      auto cont_future = std::make_shared<std::future<R>>(std::move(future));
+      EnqueueLocal(*impl, [second, cont_future] {
+        (*second)(std::move(*cont_future));
+      });
+    });
+    return result;
+  }
+
+  // Blocks until every queued task has finished running (or, after
+  // Stop(false), until the pool is stopped).
+  void WaitIdle();
+
+  // Stops the pool.  Returns immediately; if drain is true the workers run
+  // all already-queued tasks before exiting, otherwise queued tasks are
+  // discarded.  Further Execute() calls fail.
+  void Stop(bool drain = true);
+
+  // Returns true if called from one of this pool's worker threads.
+  bool IsWorkerThread() const;
+
+ private:
+  class Impl;
+  class Worker;
+
+  // Queues a task submitted from one of this pool's workers.
+  bool ExecuteLocal(Task task);
+  // Queues a continuation; never fails, even after Stop().
+  static void EnqueueLocal(Impl& impl, Task task);
+
+  std::shared_ptr<Impl> m_impl;
+  std::vector<SafeThreadOwner<Worker>> m_workers;
+  unsigned int m_numThreads;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_THREADPOOL_H_
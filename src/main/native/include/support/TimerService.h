@@ -0,0 +1,89 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_TIMERSERVICE_H_
+#define WPIUTIL_SUPPORT_TIMERSERVICE_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <functional>
+
+#include "support/SafeThread.h"
+#include "support/TimerWheel.h"
+
+namespace wpi {
+
+// Shared timer thread for one-shot and periodic callbacks.
+//
+// A single SafeThread drives a TimerWheel from WPI_Now() and sleeps until
+// the next expiry, so components that only need deadlines or periodic work
+// don't each need their own thread.  Expired callbacks are handed to an
+// executor; the default runs them directly on the timer thread, so they
+// should be short.  To run them elsewhere, pass an executor such as:
+//
+//   ThreadPool pool;
+//   TimerService timers([&](TimerService::Callback cb) {
+//     pool.Execute(std::move(cb));
+//   });
+//
+// Times are in microseconds.  All functions are thread-safe and may be
+// called from callbacks.
+class TimerService {
+ public:
+  typedef TimerWheel::Callback Callback;
+  typedef TimerWheel::TimerId TimerId;
+  typedef std::function<void(Callback)> Executor;
+
+  static constexpr TimerId kInvalidTimer = TimerWheel::kInvalidTimer;
+
+  // Creates a service that runs callbacks on its own thread.
+  TimerService();
+
+  // Creates a service that passes expired callbacks to executor.
+  // @param executor called on the timer thread with each expired callback
+  // @param resolution timer tick length; deadlines are rounded up to a tick
+  explicit TimerService(Executor executor, uint64_t resolution = 1000);
+
+  ~TimerService();
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  // Runs callback once, delay from now.  Returns kInvalidTimer if the
+  // service has been stopped.
+  TimerId Schedule(uint64_t delay, Callback callback);
+
+  // Runs callback once at the given WPI_Now() time.
+  TimerId ScheduleAt(uint64_t time, Callback callback);
+
+  // Runs callback every period, starting period from now.  Expiries missed
+  // because the timer thread was delayed are not made up.
+  TimerId SchedulePeriodic(uint64_t period, Callback callback);
+
+  // Cancels a timer.  Returns false if it already ran (one-shot) or was
+  // already cancelled.  A callback already handed to the executor still
+  // runs.
+  bool Cancel(TimerId id);
+
+  // Number of pending timers.
+  size_t GetPending() const;
+
+  // Stops the timer thread.  Pending timers never run.
+  void Stop();
+
+ private:
+  class Thread;
+
+  TimerId Add(uint64_t time, uint64_t period, Callback callback);
+
+  SafeThreadOwner<Thread> m_owner;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_TIMERSERVICE_H_
@@ -0,0 +1,199 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_TIMERWHEEL_H_
+#define WPIUTIL_SUPPORT_TIMERWHEEL_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace wpi {
+
+// Hierarchical timing wheel.
+//
+// Four levels of 256 slots each; level 0 slots are one tick wide and each
+// higher level's slots are 256 times wider than the level below.  A timer is
+// placed in the coarsest slot that still separates it from the current tick
+// and is moved ("cascaded") down a level each time the wheel turns past that
+// slot, so Schedule() and Cancel() are O(1) and Advance() is O(1) per tick
+// plus the timers it touches.  Timers further out than 2^32 ticks are parked
+// in the top level and re-cascaded until they are in range.
+//
+// Timer nodes live in a slab and are linked intrusively into their slot, so
+// a million pending timers cost one node each and no per-timer allocation
+// beyond the callback itself.  Timer ids carry a generation count, so a
+// stale id (for a timer that already fired or was cancelled) is harmless.
+//
+// Times are in microseconds on the WPI_Now() timebase.  This class is not
+// thread-safe; see TimerService for a threaded wrapper.
+class TimerWheel {
+ public:
+  typedef std::function<void()> Callback;
+  typedef uint64_t TimerId;
+
+  static constexpr TimerId kInvalidTimer = 0;
+  static constexpr uint64_t kNoTimer = UINT64_MAX;
+
+  // Creates a wheel.
+  // @param now current time
+  // @param resolution tick length; deadlines are rounded up to a tick
+  explicit TimerWheel(uint64_t now, uint64_t resolution = 1000);
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  uint64_t GetResolution() const { return m_resolution; }
+
+  // Number of pending timers.
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+
+  // Schedules a timer to expire at time.  If period is nonzero, the timer is
+  // rescheduled period after each expiry until cancelled.  Times in the past
+  // expire on the next Advance().
+  TimerId Schedule(uint64_t time, uint64_t period, Callback callback);
+
+  // Cancels a pending timer.  Returns false if the id is stale.  May be
+  // called from within an Advance() visitor, including for the timer being
+  // visited.
+  bool Cancel(TimerId id);
+
+  // Returns true if the id refers to a pending timer.
+  bool IsPending(TimerId id) const;
+
+  // Moves the wheel forward to now, calling visitor(callback, repeating)
+  // for each expired timer in deadline order (to tick resolution).  A
+  // periodic timer fires at most once per call.  The
+  // callback reference is only valid for the duration of the call; if
+  // repeating is false the timer is gone afterwards and the visitor may move
+  // from it.  The visitor may schedule and cancel timers.  Returns the
+  // number of timers that expired.
+  template <typename Visitor>
+  size_t Advance(uint64_t now, Visitor&& visitor);
+
+  // Returns a lower bound on the next expiry time (exact if the next timer
+  // is within 256 ticks), or kNoTimer if no timers are pending.
+  uint64_t GetNextExpiry() const;
+
+ private:
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotBits = 8;
+  static constexpr uint32_t kSlots = 1u << kSlotBits;
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Node {
+    uint64_t expires = 0;  // tick
+    uint64_t period = 0;   // ticks
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t generation = 1;
+    uint32_t list = kNil;  // slot list index, or kNil if not linked
+    bool firing = false;
+    Callback callback;
+  };
+
+  static TimerId MakeId(uint32_t index, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | index;
+  }
+
+  uint64_t ToTick(uint64_t time) const {
+    return (time + m_resolution - 1) / m_resolution;
+  }
+
+  Node* Lookup(TimerId id);
+  const Node* Lookup(TimerId id) const;
+  uint32_t Allocate();
+  void Free(uint32_t index);
+  void Insert(uint32_t index);
+  void Unlink(uint32_t index);
+  void Cascade(int level);
+  template <typename Visitor>
+  size_t Expire(uint64_t target, Visitor& visitor);
+
+  uint64_t m_resolution;
+  uint64_t m_tick;  // last processed tick
+  size_t m_count = 0;
+
+  std::deque<Node> m_nodes;  // deque so references survive growth
+  uint32_t m_freeHead = kNil;
+
+  uint32_t m_heads[kLevels * kSlots];
+  uint64_t m_occupied[kLevels][kSlots / 64];
+};
+
+template <typename Visitor>
+size_t TimerWheel::Advance(uint64_t now, Visitor&& visitor) {
+  uint64_t target = now / m_resolution;
+  size_t fired = 0;
+  while (m_tick < target) {
+    // Jump over ticks with nothing to expire or cascade.
+    uint64_t next = GetNextExpiry();
+    if (next == kNoTimer) {
+      m_tick = target;
+      break;
+    }
+    next /= m_resolution;
+    if (next > target) {
+      m_tick = target;
+      break;
+    }
+    if (next - 1 > m_tick) m_tick = next - 1;
+
+    ++m_tick;
+    // cascade from the top down so timers settle in one pass
+    for (int level = kLevels - 1; level >= 1; --level) {
+      uint64_t mask = (static_cast<uint64_t>(1) << (kSlotBits * level)) - 1;
+      if ((m_tick & mask) == 0) Cascade(level);
+    }
+    fired += Expire(target, visitor);
+  }
+  return fired;
+}
+
+template <typename Visitor>
+size_t TimerWheel::Expire(uint64_t target, Visitor& visitor) {
+  uint32_t list = static_cast<uint32_t>(m_tick & (kSlots - 1));
+  size_t fired = 0;
+  uint32_t index;
+  while ((index = m_heads[list]) != kNil) {
+    Unlink(index);
+    Node& node = m_nodes[index];
+    uint32_t generation = node.generation;
+    bool repeating = node.period != 0;
+    node.firing = true;
+    ++fired;
+    visitor(node.callback, repeating);
+    node.firing = false;
+    if (repeating && node.generation == generation) {
+      // skip periods missed because Advance() was called late, keeping
+      // the phase
+      node.expires += node.period;
+      if (node.expires <= target)
+        node.expires +=
+            ((target - node.expires) / node.period + 1) * node.period;
+      Insert(index);
+    } else {
+      // one-shot, or cancelled by the visitor (Cancel() already bumped the
+      // generation and uncounted it)
+      if (node.generation == generation) {
+        ++node.generation;
+        --m_count;
+      }
+      Free(index);
+    }
+  }
+  return fired;
+}
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_TIMERWHEEL_H_
@@ -0,0 +1,132 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_TRACE_H_
+#define WPIUTIL_SUPPORT_TRACE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "llvm/raw_ostream.h"
+#include "support/SafeThread.h"
+#include "support/timestamp.h"
+
+namespace wpi {
+
+// Scoped tracing.
+//
+// WPI_TRACE_SCOPE("name") records the time spent in the enclosing scope as
+// a span.  Spans are only recorded while a TraceRecorder is running; they
+// go into a per-thread ring without locks, and the recorder's background
+// thread exports them as Chrome trace-event JSON (load the file in
+// chrome://tracing or https://ui.perfetto.dev).
+//
+// The macros compile to nothing unless WPI_ENABLE_TRACING is defined.  When
+// enabled but not recording, a span costs one relaxed atomic load.
+//
+//   void Process() {
+//     WPI_TRACE_SCOPE("Process");
+//     ...
+//   }
+
+namespace detail {
+
+extern std::atomic<bool> gTraceRecording;
+
+void TraceRecord(const char* name, uint64_t begin, uint64_t end);
+
+}  // namespace detail
+
+// Returns true while a TraceRecorder is recording.
+inline bool IsTraceRecording() {
+  return detail::gTraceRecording.load(std::memory_order_relaxed);
+}
+
+// Records a span from construction to destruction.  The name must have
+// static storage duration (normally a string literal).  Usually used
+// through WPI_TRACE_SCOPE.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : m_name(IsTraceRecording() ? name : nullptr) {
+    if (m_name) m_begin = Now();
+  }
+
+  ~TraceScope() {
+    if (m_name) detail::TraceRecord(m_name, m_begin, Now());
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* m_name;
+  uint64_t m_begin = 0;
+};
+
+// Records spans and writes them to a stream as Chrome trace-event JSON.
+// Only one recorder can record at a time.
+class TraceRecorder {
+ public:
+  struct Options {
+    // Spans each thread can have buffered.  Applies to threads that record
+    // their first span after Start(); a full ring drops new spans.
+    size_t ringCapacity = 4096;
+    // How often the background thread writes buffered spans.
+    std::chrono::milliseconds exportInterval{100};
+  };
+
+  // The stream must outlive the recorder.
+  explicit TraceRecorder(llvm::raw_ostream& os);
+  TraceRecorder(llvm::raw_ostream& os, const Options& options);
+
+  // Stops recording.
+  ~TraceRecorder();
+
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  // Writes the JSON header and starts recording.  Returns false if this or
+  // another recorder is already recording (or this one has been stopped).
+  bool Start();
+
+  // Stops recording, writes the remaining spans, and completes the JSON
+  // document.
+  void Stop();
+
+  // Spans dropped because a ring was full since Start().
+  uint64_t GetDropped() const;
+
+ private:
+  class Thread;
+  struct Shared;
+
+  std::shared_ptr<Shared> m_shared;
+  SafeThreadOwner<Thread> m_owner;
+};
+
+}  // namespace wpi
+
+#define WPI_TRACE_CONCAT2_(a, b) a##b
+#define WPI_TRACE_CONCAT_(a, b) WPI_TRACE_CONCAT2_(a, b)
+
+#ifdef WPI_ENABLE_TRACING
+// Records the rest of the enclosing scope as a span named name.
+#define WPI_TRACE_SCOPE(name) \
+  ::wpi::TraceScope WPI_TRACE_CONCAT_(WPI_trace_scope_, __LINE__) { name }
+// Records the rest of the enclosing function as a span.
+#define WPI_TRACE_FUNCTION() WPI_TRACE_SCOPE(__func__)
+#else
+#define WPI_TRACE_SCOPE(name) static_cast<void>(0)
+#define WPI_TRACE_FUNCTION() static_cast<void>(0)
+#endif
+
+#endif  // WPIUTIL_SUPPORT_TRACE_H_
@@ -8,40 +8,109 @@
 #ifndef WPIUTIL_SUPPORT_UIDVECTOR_H_
 #define WPIUTIL_SUPPORT_UIDVECTOR_H_
 
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace wpi {
 
+namespace detail {
+
+// FIFO queue of free slot indices, stored in a power-of-two ring buffer so
+// both push and pop are O(1).
+template <typename Index>
+class FreeRing {
+ public:
+  bool empty() const { return m_size == 0; }
+  size_t size() const { return m_size; }
+
+  void push(Index index) {
+    if (m_size == m_buf.size()) Grow();
+    m_buf[(m_head + m_size) & (m_buf.size() - 1)] = index;
+    ++m_size;
+  }
+
+  // Removes and returns the oldest index.  Must not be empty.
+  Index pop() {
+    Index index = m_buf[m_head];
+    m_head = (m_head + 1) & (m_buf.size() - 1);
+    --m_size;
+    return index;
+  }
+
+  void clear() {
+    m_head = 0;
+    m_size = 0;
+  }
+
+ private:
+  void Grow() {
+    std::vector<Index> buf(m_buf.empty() ? 16 : m_buf.size() * 2);
+    for (size_t i = 0; i < m_size; ++i)
+      buf[i] = m_buf[(m_head + i) & (m_buf.size() - 1)];
+    m_buf.swap(buf);
+    m_head = 0;
+  }
+
+  std::vector<Index> m_buf;
+  size_t m_head = 0;
+  size_t m_size = 0;
+};
+
+}  // namespace detail
+
 // Vector which provides an integrated freelist for removal and reuse of
-// individual elements.
-// @tparam T element type; must be default-constructible and evaluate in
-//           boolean context to false when "empty"
+// individual elements.  Adding and removing elements are O(1); freed
+// indices are reused oldest first.
+//
+// Indices are plain positions, so an index kept after erase() refers to
+// whatever element later reuses the slot; use SlotMap if stale handles need
+// to be detected.
+//
+// Iterating visits only live elements, in index order.
+//
+// @tparam T element type; must be default-constructible
 // @tparam reuse_threshold how many free elements to store up before starting
 //                         to recycle them
 template <typename T, typename std::vector<T>::size_type reuse_threshold>
 class UidVector {
+  template <bool Const>
+  class Iterator;
+
  public:
   typedef typename std::vector<T>::size_type size_type;
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
 
   bool empty() const { return m_active_count == 0; }
+  // Size of the index space (one past the largest index ever returned).
   size_type size() const { return m_vector.size(); }
+  // Number of live elements.
+  size_type active_count() const { return m_active_count; }
   T& operator[](size_type i) { return m_vector[i]; }
   const T& operator[](size_type i) const { return m_vector[i]; }
 
-  // Add a new T to the vector.  If there are elements on the freelist,
-  // reuses the last one; otherwise adds to the end of the vector.
+  // Returns true if uid refers to a live element.
+  bool contains(size_type uid) const {
+    return uid < m_live.size() && m_live[uid];
+  }
+
+  // Add a new T to the vector.  If enough elements are on the freelist,
+  // reuses the oldest one; otherwise adds to the end of the vector.
   // Returns the resulting element index.
   template <class... Args>
   size_type emplace_back(Args&&... args) {
     size_type uid;
-    if (m_free.size() < reuse_threshold) {
+    if (m_free.size() < reuse_threshold || m_free.empty()) {
       uid = m_vector.size();
       m_vector.emplace_back(std::forward<Args>(args)...);
+      m_live.push_back(true);
     } else {
-      uid = m_free.front();
-      m_free.erase(m_free.begin());
+      uid = m_free.pop();
       m_vector[uid] = T(std::forward<Args>(args)...);
+      m_live[uid] = true;
     }
     ++m_active_count;
     return uid;
@@ -50,15 +119,74 @@ class UidVector {
   // Removes the identified element by replacing it with a default-constructed
   // one.  The element is added to the freelist for later reuse.
   void erase(size_type uid) {
-    if (uid >= m_vector.size() || !m_vector[uid]) return;
-    m_free.push_back(uid);
+    if (!contains(uid)) return;
+    m_free.push(uid);
     m_vector[uid] = T();
+    m_live[uid] = false;
     --m_active_count;
   }
 
+  // Removes all elements and forgets all indices.
+  void clear() {
+    m_vector.clear();
+    m_live.clear();
+    m_free.clear();
+    m_active_count = 0;
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, m_vector.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_vector.size()); }
+
  private:
+  // Forward iterator over live elements; uid() gives the element index.
+  template <bool Const>
+  class Iterator {
+    typedef typename std::conditional<Const, const UidVector, UidVector>::type
+        Container;
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type reference;
+
+    Iterator(Container* vec, size_type pos) : m_vec(vec), m_pos(pos) {
+      SkipFree();
+    }
+
+    size_type uid() const { return m_pos; }
+    reference operator*() const { return m_vec->m_vector[m_pos]; }
+    pointer operator->() const { return &m_vec->m_vector[m_pos]; }
+
+    Iterator& operator++() {
+      ++m_pos;
+      SkipFree();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const Iterator& oth) const { return m_pos == oth.m_pos; }
+    bool operator!=(const Iterator& oth) const { return m_pos != oth.m_pos; }
+
+   private:
+    void SkipFree() {
+      while (m_pos < m_vec->m_live.size() && !m_vec->m_live[m_pos]) ++m_pos;
+    }
+
+    Container* m_vec;
+    size_type m_pos;
+  };
+
   std::vector<T> m_vector;
-  std::vector<size_type> m_free;
+  std::vector<bool> m_live;
+  detail::FreeRing<size_type> m_free;
   size_type m_active_count{0};
 };
 
@@ -8,9 +8,12 @@
 #pragma once
 
 #ifdef __linux__
-#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <utility>
@@ -23,26 +26,40 @@ namespace wpi {
 
 #define WPI_HAVE_PRIORITY_CONDITION_VARIABLE 1
 
+namespace detail {
+
+// Sleeps while word == value, until woken or the CLOCK_MONOTONIC deadline
+// (if not null) passes.  Returns false on timeout.
+bool FutexWait(std::atomic<uint32_t>& word, uint32_t value,
+               const struct timespec* deadline) noexcept;
+void FutexWake(std::atomic<uint32_t>& word, int count) noexcept;
+
+}  // namespace detail
+
+// Condition variable for use with priority_mutex.
+//
+// Waiters sleep on a futex sequence counter that each notify increments, so
+// notify is a single atomic increment when nobody is waiting.  Timed waits
+// are measured against CLOCK_MONOTONIC (steady_clock), so wall clock
+// adjustments do not shorten or stretch them.
 class priority_condition_variable {
-  typedef std::chrono::system_clock clock;
+  typedef std::chrono::steady_clock clock;
 
  public:
-  typedef pthread_cond_t* native_handle_type;
+  typedef std::atomic<uint32_t>* native_handle_type;
 
-  priority_condition_variable() noexcept = default;
-  ~priority_condition_variable() noexcept { pthread_cond_destroy(&m_cond); }
+  constexpr priority_condition_variable() noexcept = default;
 
   priority_condition_variable(const priority_condition_variable&) = delete;
   priority_condition_variable& operator=(const priority_condition_variable&) =
       delete;
 
-  void notify_one() noexcept { pthread_cond_signal(&m_cond); }
+  void notify_one() noexcept { notify(1); }
 
-  void notify_all() noexcept { pthread_cond_broadcast(&m_cond); }
+  void notify_all() noexcept { notify(INT32_MAX); }
 
   void wait(std::unique_lock<priority_mutex>& lock) noexcept {
-    int e = pthread_cond_wait(&m_cond, lock.mutex()->native_handle());
-    if (e) std::terminate();
+    wait_impl(lock, nullptr);
   }
 
   template <typename Predicate>
@@ -63,12 +80,14 @@ class priority_condition_variable {
   std::cv_status wait_until(
       std::unique_lock<priority_mutex>& lock,
       const std::chrono::time_point<Clock, Duration>& atime) {
-    const typename Clock::time_point c_entry = Clock::now();
-    const clock::time_point s_entry = clock::now();
-    const auto delta = atime - c_entry;
-    const auto s_atime = s_entry + delta;
-
-    return wait_until_impl(lock, s_atime);
+    // Convert to a monotonic deadline.  If the wait times out against that
+    // deadline, but atime's clock was moved back meanwhile, report a
+    // (spurious) wakeup so the caller re-checks against its own clock.
+    if (wait_until_impl(lock, clock::now() + (atime - Clock::now())) ==
+        std::cv_status::no_timeout)
+      return std::cv_status::no_timeout;
+    return Clock::now() < atime ? std::cv_status::no_timeout
+                                : std::cv_status::timeout;
   }
 
   template <typename Clock, typename Duration, typename Predicate>
@@ -95,10 +114,28 @@ class priority_condition_variable {
     return wait_until(lock, clock::now() + rtime, std::move(p));
   }
 
-  native_handle_type native_handle() { return &m_cond; }
+  // Returns the futex sequence word.
+  native_handle_type native_handle() { return &m_seq; }
 
  private:
-  pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+  void notify(int count) noexcept {
+    // Pairs with wait_impl(): either the waiter reads the new sequence
+    // number (and doesn't sleep) or we see its waiter count.
+    m_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_seq_cst) != 0)
+      detail::FutexWake(m_seq, count);
+  }
+
+  bool wait_impl(std::unique_lock<priority_mutex>& lock,
+                 const struct timespec* deadline) noexcept {
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t seq = m_seq.load(std::memory_order_seq_cst);
+    lock.unlock();
+    bool woken = detail::FutexWait(m_seq, seq, deadline);
+    lock.lock();
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+  }
 
   template <typename Dur>
   std::cv_status wait_until_impl(
@@ -106,16 +143,21 @@ class priority_condition_variable {
       const std::chrono::time_point<clock, Dur>& atime) {
     auto s = std::chrono::time_point_cast<std::chrono::seconds>(atime);
     auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(atime - s);
+    if (ns.count() < 0) {
+      s -= std::chrono::seconds(1);
+      ns += std::chrono::seconds(1);
+    }
 
     struct timespec ts = {
         static_cast<std::time_t>(s.time_since_epoch().count()),
         static_cast<long>(ns.count())};  // NOLINT(runtime/int)
 
-    pthread_cond_timedwait(&m_cond, lock.mutex()->native_handle(), &ts);
-
-    return (clock::now() < atime ? std::cv_status::no_timeout
-                                 : std::cv_status::timeout);
+    return wait_impl(lock, &ts) ? std::cv_status::no_timeout
+                                : std::cv_status::timeout;
   }
+
+  std::atomic<uint32_t> m_seq{0};
+  std::atomic<uint32_t> m_waiters{0};
 };
 #endif
 
@@ -7,11 +7,10 @@
 
 #pragma once
 
-// Allows usage with std::lock_guard without including <mutex> separately
-#ifdef __linux__
-#include <pthread.h>
-#endif
+#include <stdint.h>
 
+#include <atomic>
+// Allows usage with std::lock_guard without including <mutex> separately
 #include <mutex>
 
 namespace wpi {
@@ -20,65 +19,279 @@ namespace wpi {
 
 #define WPI_HAVE_PRIORITY_MUTEX 1
 
-class priority_recursive_mutex {
+namespace detail {
+
+// Returns the kernel thread id of the calling thread.  The first call also
+// registers a fork handler that refreshes the cache below in the child.
+uint32_t GetCurrentTid() noexcept;
+
+// Per-thread cache of GetCurrentTid().
+inline uint32_t& CachedTid() noexcept {
+  static thread_local uint32_t tid = GetCurrentTid();
+  return tid;
+}
+
+inline uint32_t CurrentTid() noexcept { return CachedTid(); }
+
+// Slow paths for the futex word of a priority mutex.  The word is 0 when
+// unlocked, otherwise the owner's tid plus kernel-managed flag bits.
+void FutexLockPI(std::atomic<uint32_t>& word, std::atomic<int16_t>& spins,
+                 uint32_t tid);
+void FutexUnlockPI(std::atomic<uint32_t>& word);
+
+// FUTEX_TID_MASK
+constexpr uint32_t kFutexTidMask = 0x3fffffff;
+
+#ifdef WPI_MUTEX_PROFILING
+// Lock profiling hooks; see MutexProfiler.h.
+struct MutexProfile;
+
+// Returns the time a contended lock() started waiting.
+uint64_t ProfileWaitStart() noexcept;
+
+// Records an acquisition (waitStart is 0 if it was uncontended) and returns
+// the acquisition time.  caller is the return address of lock(), recorded
+// as the call site of contended acquisitions.  Creates the mutex's profile
+// on first use.
+uint64_t ProfileAcquired(std::atomic<MutexProfile*>& profile,
+                         const void* mutex, uint64_t waitStart,
+                         const void* caller) noexcept;
+
+// Records the hold time of a release.
+void ProfileReleased(std::atomic<MutexProfile*>& profile,
+                     uint64_t acquired) noexcept;
+
+void ProfileSetName(std::atomic<MutexProfile*>& profile, const void* mutex,
+                    const char* name) noexcept;
+void ProfileDestroyed(std::atomic<MutexProfile*>& profile) noexcept;
+#endif
+
+}  // namespace detail
+
+#ifdef WPI_MUTEX_PROFILING
+// With profiling, lock() is kept out of line so that its return address is
+// in the code that locked the mutex.
+#define WPI_MUTEX_LOCK_ATTR_ __attribute__((noinline))
+#define WPI_MUTEX_CALLER_ __builtin_return_address(0)
+#else
+#define WPI_MUTEX_LOCK_ATTR_
+#define WPI_MUTEX_CALLER_ nullptr
+#endif
+
+// Contention statistics for priority mutexes, aggregated over all mutexes in
+// the process.  Collection is off by default; it only touches the contended
+// (slow) paths, never the uncontended lock/unlock.
+struct priority_mutex_stats {
+  uint64_t contended = 0;      // lock() calls that missed the fast path
+  uint64_t spin_acquired = 0;  // ... and then acquired the lock by spinning
+  uint64_t sleeps = 0;         // ... or had to sleep in the kernel
+  uint64_t wakes = 0;          // unlock() calls that had to wake a waiter
+};
+
+void SetPriorityMutexStatsEnabled(bool enabled);
+priority_mutex_stats GetPriorityMutexStats();
+void ResetPriorityMutexStats();
+
+// Mutex with priority inheritance.
+//
+// Built directly on the Linux PI futex (FUTEX_LOCK_PI/FUTEX_UNLOCK_PI): an
+// uncontended lock or unlock is a single compare-and-swap in userspace.  A
+// contended lock first spins for a bounded, per-mutex adaptive number of
+// iterations (skipped on uniprocessors and when other waiters are already
+// queued in the kernel) before asking the kernel to boost the owner and
+// sleep.
+//
+// Building everything with WPI_MUTEX_PROFILING defined adds per-mutex
+// contention profiling (see MutexProfiler.h); otherwise it costs nothing.
+class priority_mutex {
  public:
-  typedef pthread_mutex_t* native_handle_type;
+  typedef std::atomic<uint32_t>* native_handle_type;
 
-  constexpr priority_recursive_mutex() noexcept = default;
-  priority_recursive_mutex(const priority_recursive_mutex&) = delete;
-  priority_recursive_mutex& operator=(const priority_recursive_mutex&) = delete;
+  constexpr priority_mutex() noexcept = default;
+  priority_mutex(const priority_mutex&) = delete;
+  priority_mutex& operator=(const priority_mutex&) = delete;
+#ifdef WPI_MUTEX_PROFILING
+  ~priority_mutex() { detail::ProfileDestroyed(m_profile); }
+#endif
 
   // Lock the mutex, blocking until it's available.
-  void lock() { pthread_mutex_lock(&m_mutex); }
+  WPI_MUTEX_LOCK_ATTR_ void lock() {
+    uint32_t tid = detail::CurrentTid();
+    uint32_t expected = 0;
+    if (m_word.compare_exchange_strong(expected, tid,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+      profile_acquired(0, nullptr);
+      return;
+    }
+    uint64_t waitStart = profile_wait_start();
+    detail::FutexLockPI(m_word, m_spins, tid);
+    profile_acquired(waitStart, WPI_MUTEX_CALLER_);
+  }
 
   // Unlock the mutex.
-  void unlock() { pthread_mutex_unlock(&m_mutex); }
+  void unlock() {
+    profile_release();
+    uint32_t expected = detail::CurrentTid();
+    if (m_word.compare_exchange_strong(expected, 0, std::memory_order_release,
+                                       std::memory_order_relaxed))
+      return;
+    detail::FutexUnlockPI(m_word);
+  }
 
   // Tries to lock the mutex.
-  bool try_lock() noexcept { return !pthread_mutex_trylock(&m_mutex); }
+  bool try_lock() noexcept {
+    uint32_t expected = 0;
+    if (!m_word.compare_exchange_strong(expected, detail::CurrentTid(),
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed))
+      return false;
+    profile_acquired(0, nullptr);
+    return true;
+  }
 
-  pthread_mutex_t* native_handle() { return &m_mutex; }
+  // Returns the futex word.  Note this is not a pthread_mutex_t* (as it was
+  // when this class wrapped a pthread mutex), so it can't be passed to
+  // pthread_mutex_*() functions.
+  native_handle_type native_handle() { return &m_word; }
+
+  // Names the mutex in MutexProfiler output.  The string must have static
+  // storage duration.  Does nothing unless WPI_MUTEX_PROFILING is defined.
+  void set_profile_name(const char* name) noexcept {
+#ifdef WPI_MUTEX_PROFILING
+    detail::ProfileSetName(m_profile, this, name);
+#else
+    static_cast<void>(name);
+#endif
+  }
 
  private:
-// Do the equivalent of setting PTHREAD_PRIO_INHERIT and
-// PTHREAD_MUTEX_RECURSIVE_NP.
-#ifdef __PTHREAD_MUTEX_HAVE_PREV
-  pthread_mutex_t m_mutex = {
-      {0, 0, 0, 0, 0x20 | PTHREAD_MUTEX_RECURSIVE_NP, __PTHREAD_SPINS, {0, 0}}};
+#ifdef WPI_MUTEX_PROFILING
+  uint64_t profile_wait_start() noexcept { return detail::ProfileWaitStart(); }
+  void profile_acquired(uint64_t waitStart, const void* caller) noexcept {
+    m_acquired = detail::ProfileAcquired(m_profile, this, waitStart, caller);
+  }
+  void profile_release() noexcept {
+    detail::ProfileReleased(m_profile, m_acquired);
+  }
+
+  std::atomic<detail::MutexProfile*> m_profile{nullptr};
+  uint64_t m_acquired = 0;  // only touched by the owner
 #else
-  pthread_mutex_t m_mutex = {
-      {0, 0, 0, 0x20 | PTHREAD_MUTEX_RECURSIVE_NP, 0, {__PTHREAD_SPINS}}};
+  uint64_t profile_wait_start() noexcept { return 0; }
+  void profile_acquired(uint64_t, const void*) noexcept {}
+  void profile_release() noexcept {}
 #endif
+
+  std::atomic<uint32_t> m_word{0};
+  std::atomic<int16_t> m_spins{0};  // adaptive spin estimate
 };
 
-class priority_mutex {
+class priority_recursive_mutex {
  public:
-  typedef pthread_mutex_t* native_handle_type;
+  typedef std::atomic<uint32_t>* native_handle_type;
 
-  constexpr priority_mutex() noexcept = default;
-  priority_mutex(const priority_mutex&) = delete;
-  priority_mutex& operator=(const priority_mutex&) = delete;
+  constexpr priority_recursive_mutex() noexcept = default;
+  priority_recursive_mutex(const priority_recursive_mutex&) = delete;
+  priority_recursive_mutex& operator=(const priority_recursive_mutex&) = delete;
+#ifdef WPI_MUTEX_PROFILING
+  ~priority_recursive_mutex() { detail::ProfileDestroyed(m_profile); }
+#endif
 
   // Lock the mutex, blocking until it's available.
-  void lock() { pthread_mutex_lock(&m_mutex); }
+  WPI_MUTEX_LOCK_ATTR_ void lock() {
+    uint32_t tid = detail::CurrentTid();
+    if (owned_by(tid)) {
+      ++m_count;
+      return;
+    }
+    uint32_t expected = 0;
+    if (m_word.compare_exchange_strong(expected, tid,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+      profile_acquired(0, nullptr);
+    } else {
+      uint64_t waitStart = profile_wait_start();
+      detail::FutexLockPI(m_word, m_spins, tid);
+      profile_acquired(waitStart, WPI_MUTEX_CALLER_);
+    }
+    m_count = 1;
+  }
 
   // Unlock the mutex.
-  void unlock() { pthread_mutex_unlock(&m_mutex); }
+  void unlock() {
+    if (--m_count != 0) return;
+    profile_release();
+    uint32_t expected = detail::CurrentTid();
+    if (m_word.compare_exchange_strong(expected, 0, std::memory_order_release,
+                                       std::memory_order_relaxed))
+      return;
+    detail::FutexUnlockPI(m_word);
+  }
 
   // Tries to lock the mutex.
-  bool try_lock() noexcept { return !pthread_mutex_trylock(&m_mutex); }
+  bool try_lock() noexcept {
+    uint32_t tid = detail::CurrentTid();
+    if (owned_by(tid)) {
+      ++m_count;
+      return true;
+    }
+    uint32_t expected = 0;
+    if (!m_word.compare_exchange_strong(expected, tid,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed))
+      return false;
+    profile_acquired(0, nullptr);
+    m_count = 1;
+    return true;
+  }
 
-  pthread_mutex_t* native_handle() { return &m_mutex; }
+  // Returns the futex word.  Note this is not a pthread_mutex_t* (as it was
+  // when this class wrapped a pthread mutex), so it can't be passed to
+  // pthread_mutex_*() functions.
+  native_handle_type native_handle() { return &m_word; }
+
+  // Names the mutex in MutexProfiler output.  The string must have static
+  // storage duration.  Does nothing unless WPI_MUTEX_PROFILING is defined.
+  void set_profile_name(const char* name) noexcept {
+#ifdef WPI_MUTEX_PROFILING
+    detail::ProfileSetName(m_profile, this, name);
+#else
+    static_cast<void>(name);
+#endif
+  }
 
  private:
-// Do the equivalent of setting PTHREAD_PRIO_INHERIT.
-#ifdef __PTHREAD_MUTEX_HAVE_PREV
-  pthread_mutex_t m_mutex = {{0, 0, 0, 0, 0x20, __PTHREAD_SPINS, {0, 0}}};
+#ifdef WPI_MUTEX_PROFILING
+  uint64_t profile_wait_start() noexcept { return detail::ProfileWaitStart(); }
+  void profile_acquired(uint64_t waitStart, const void* caller) noexcept {
+    m_acquired = detail::ProfileAcquired(m_profile, this, waitStart, caller);
+  }
+  void profile_release() noexcept {
+    detail::ProfileReleased(m_profile, m_acquired);
+  }
+
+  std::atomic<detail::MutexProfile*> m_profile{nullptr};
+  uint64_t m_acquired = 0;
 #else
-  pthread_mutex_t m_mutex = {{0, 0, 0, 0x20, 0, {__PTHREAD_SPINS}}};
+  uint64_t profile_wait_start() noexcept { return 0; }
+  void profile_acquired(uint64_t, const void*) noexcept {}
+  void profile_release() noexcept {}
 #endif
+
+  bool owned_by(uint32_t tid) const {
+    return (m_word.load(std::memory_order_relaxed) & detail::kFutexTidMask) ==
+           tid;
+  }
+
+  std::atomic<uint32_t> m_word{0};
+  std::atomic<int16_t> m_spins{0};
+  unsigned int m_count = 0;  // only touched by the owner
 };
 
+#undef WPI_MUTEX_LOCK_ATTR_
+#undef WPI_MUTEX_CALLER_
+
 #endif  // __linux__
 
 }  // namespace wpi
@@ -8,25 +8,53 @@
 #ifndef WPIUTIL_SUPPORT_RAW_SOCKET_ISTREAM_H_
 #define WPIUTIL_SUPPORT_RAW_SOCKET_ISTREAM_H_
 
+#include <cstddef>
+#include <memory>
+
+#include "llvm/StringRef.h"
 #include "support/raw_istream.h"
 
 namespace wpi {
 
 class NetworkStream;
 
+// Buffered input stream over a NetworkStream.  Each receive reads as much
+// as is available (up to the buffer size), so small reads such as
+// getline() don't cost a syscall per byte.  Reads of at least the buffer
+// size go directly into the caller's memory.
+//
+// Data may be read ahead into the buffer, so once this stream has been
+// used, further input should be read through it rather than from the
+// NetworkStream directly.
 class raw_socket_istream : public raw_istream {
  public:
-  explicit raw_socket_istream(NetworkStream& stream, int timeout = 0)
-      : m_stream(stream), m_timeout(timeout) {}
+  explicit raw_socket_istream(NetworkStream& stream, int timeout = 0,
+                              size_t bufSize = 4096);
 
   void close() override;
+
+  // Number of bytes that can be read without receiving from the socket.
   size_t in_avail() const override;
 
+  // Returns the buffered bytes without consuming them, first receiving
+  // (and waiting, subject to the timeout) if the buffer is empty.  Returns
+  // an empty string, and sets the error flag, if that receive fails.  The
+  // result is valid until the next read or consume().
+  llvm::StringRef peek();
+
+  // Discards len bytes from the buffer; len must not exceed in_avail().
+  void consume(size_t len);
+
  private:
   void read_impl(void* data, size_t len) override;
+  bool fill();
 
   NetworkStream& m_stream;
   int m_timeout;
+  std::unique_ptr<char[]> m_buf;
+  size_t m_bufSize;
+  size_t m_cur = 0;
+  size_t m_end = 0;
 };
 
 }  // namespace wpi
@@ -30,6 +30,8 @@ class raw_socket_ostream : public llvm::raw_ostream {
 
  private:
   void write_impl(const char* data, size_t len) override;
+  void writev_impl(const char* buffered, size_t bufferedLen, const char* data,
+                   size_t len) override;
   uint64_t current_pos() const override;
 
   NetworkStream& m_stream;
@@ -0,0 +1,173 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_SUPPORT_SHARED_MUTEX_H_
+#define WPIUTIL_SUPPORT_SHARED_MUTEX_H_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "support/condition_variable.h"
+#include "support/mutex.h"
+
+namespace wpi {
+
+// Reader-writer lock for read-mostly data.
+//
+// Readers announce themselves on one of several striped counters (each on
+// its own cache line) chosen per thread, so concurrent readers on different
+// cores don't contend on a shared word; an uncontended lock_shared() is one
+// atomic increment plus a load.  Writers serialize on a wpi::mutex, so on
+// Linux writers get priority inheritance from each other and from readers
+// blocked behind them (a blocked reader waits by locking the writer mutex).
+// Readers already holding the lock are not boosted by a waiting writer.
+//
+// Writers are preferred: once a writer has announced itself, new readers
+// wait for it, so a steady stream of readers cannot starve writers.
+//
+// Meets the SharedMutex requirements (lock_shared() etc.), so it can be used
+// with std::shared_lock (C++14) or wpi::shared_lock.  Like the standard
+// mutexes, the lock must be released by the thread that acquired it.
+class shared_mutex {
+ public:
+  shared_mutex() = default;
+  shared_mutex(const shared_mutex&) = delete;
+  shared_mutex& operator=(const shared_mutex&) = delete;
+
+  // Exclusive (writer) locking.
+  void lock() {
+    m_writer.lock();
+    m_writerActive.store(true, std::memory_order_seq_cst);
+    WaitForReaders();
+  }
+
+  bool try_lock() {
+    if (!m_writer.try_lock()) return false;
+    m_writerActive.store(true, std::memory_order_seq_cst);
+    if (HasReaders()) {
+      m_writerActive.store(false, std::memory_order_relaxed);
+      m_writer.unlock();
+      return false;
+    }
+    return true;
+  }
+
+  void unlock() {
+    m_writerActive.store(false, std::memory_order_release);
+    m_writer.unlock();
+  }
+
+  // Shared (reader) locking.
+  void lock_shared() {
+    std::atomic<int>& count = MyStripe();
+    for (;;) {
+      // Pairs with lock(): either we see the writer, or it sees our count.
+      count.fetch_add(1, std::memory_order_seq_cst);
+      if (!m_writerActive.load(std::memory_order_seq_cst)) return;
+      ReaderExit(count);
+      // wait for the writer (boosting it) and try again
+      std::lock_guard<wpi::mutex> lock(m_writer);
+    }
+  }
+
+  bool try_lock_shared() {
+    std::atomic<int>& count = MyStripe();
+    count.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_writerActive.load(std::memory_order_seq_cst)) return true;
+    ReaderExit(count);
+    return false;
+  }
+
+  void unlock_shared() { ReaderExit(MyStripe()); }
+
+ private:
+  static constexpr size_t kStripes = 16;
+  static constexpr size_t kCacheLine = 64;
+
+  struct Stripe {
+    std::atomic<int> count{0};
+    char pad[kCacheLine - sizeof(std::atomic<int>)];
+  };
+
+  std::atomic<int>& MyStripe() {
+    static std::atomic<unsigned int> nextIndex{0};
+    static thread_local unsigned int index =
+        nextIndex.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return m_stripes[index].count;
+  }
+
+  bool HasReaders() const {
+    for (const auto& stripe : m_stripes) {
+      if (stripe.count.load(std::memory_order_seq_cst) != 0) return true;
+    }
+    return false;
+  }
+
+  void ReaderExit(std::atomic<int>& count) {
+    count.fetch_sub(1, std::memory_order_seq_cst);
+    // A waiting writer sleeps until the last reader leaves.
+    if (m_writerActive.load(std::memory_order_seq_cst)) {
+      std::lock_guard<wpi::mutex> lock(m_drainMutex);
+      m_drainCond.notify_one();
+    }
+  }
+
+  void WaitForReaders() {
+    if (!HasReaders()) return;
+    std::unique_lock<wpi::mutex> lock(m_drainMutex);
+    while (HasReaders()) m_drainCond.wait(lock);
+  }
+
+  char m_pad0[kCacheLine];
+  Stripe m_stripes[kStripes];
+  std::atomic<bool> m_writerActive{false};
+  wpi::mutex m_writer;
+  wpi::mutex m_drainMutex;
+  wpi::condition_variable m_drainCond;
+};
+
+// Minimal RAII shared ownership of a shared_mutex (std::shared_lock is not
+// available before C++14).
+template <typename Mutex>
+class shared_lock {
+ public:
+  typedef Mutex mutex_type;
+
+  explicit shared_lock(Mutex& mutex) : m_mutex(&mutex), m_owns(true) {
+    mutex.lock_shared();
+  }
+  shared_lock(Mutex& mutex, std::try_to_lock_t)
+      : m_mutex(&mutex), m_owns(mutex.try_lock_shared()) {}
+  ~shared_lock() {
+    if (m_owns) m_mutex->unlock_shared();
+  }
+
+  shared_lock(const shared_lock&) = delete;
+  shared_lock& operator=(const shared_lock&) = delete;
+
+  void lock() {
+    m_mutex->lock_shared();
+    m_owns = true;
+  }
+  void unlock() {
+    m_mutex->unlock_shared();
+    m_owns = false;
+  }
+
+  bool owns_lock() const { return m_owns; }
+  explicit operator bool() const { return m_owns; }
+  Mutex* mutex() const { return m_mutex; }
+
+ private:
+  Mutex* m_mutex;
+  bool m_owns;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_SUPPORT_SHARED_MUTEX_H_
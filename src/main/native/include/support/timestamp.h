@@ -36,6 +36,30 @@ void WPI_SetNowImpl(uint64_t (*func)(void));
  */
 uint64_t WPI_Now(void);
 
+/**
+ * Return the current time in nanoseconds.
+ * Uses the CPU timestamp counter when WPI_HaveTsc() is true, otherwise the
+ * operating system monotonic clock.  Same epoch as WPI_NowDefault() (scaled
+ * to nanoseconds).
+ * @return Time in nanoseconds.
+ */
+uint64_t WPI_NowNs(void);
+
+/**
+ * Return the current time in microseconds from the CPU timestamp counter.
+ * Same epoch as WPI_NowDefault(); pass to WPI_SetNowImpl() to make
+ * WPI_Now() use the timestamp counter.  Falls back to WPI_NowDefault() when
+ * WPI_HaveTsc() is false.
+ * @return Time in microseconds.
+ */
+uint64_t WPI_NowTsc(void);
+
+/**
+ * Return nonzero if WPI_NowNs() and WPI_NowTsc() use a timestamp counter
+ * (an invariant x86 TSC, or the ARMv8 virtual counter).
+ */
+int WPI_HaveTsc(void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -65,6 +89,29 @@ void SetNowImpl(uint64_t (*func)());
  */
 uint64_t Now(void);
 
+/**
+ * Return the current time in nanoseconds.
+ * Uses the CPU timestamp counter when HaveTsc() is true, otherwise the
+ * operating system monotonic clock.  Same epoch as NowDefault() (scaled to
+ * nanoseconds).
+ * @return Time in nanoseconds.
+ */
+uint64_t NowNs(void);
+
+/**
+ * Return the current time in microseconds from the CPU timestamp counter.
+ * Same epoch as NowDefault(); pass to SetNowImpl() to make Now() use the
+ * timestamp counter.  Falls back to NowDefault() when HaveTsc() is false.
+ * @return Time in microseconds.
+ */
+uint64_t NowTsc(void);
+
+/**
+ * Return true if NowNs() and NowTsc() use a timestamp counter (an invariant
+ * x86 TSC, or the ARMv8 virtual counter).
+ */
+bool HaveTsc(void);
+
 }  // namespace wpi
 #endif
 
@@ -0,0 +1,122 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_TCPSOCKETS_EVENTLOOP_H_
+#define WPIUTIL_TCPSOCKETS_EVENTLOOP_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+
+#include "support/TimerWheel.h"
+
+namespace wpi {
+
+class NetworkStream;
+class TCPAcceptor;
+
+// Single-threaded socket readiness loop.
+//
+// File descriptors (normally sockets from TCPAcceptor and TCPStream) are
+// registered with a handler that is called on the loop thread when they
+// become readable or writable, so one thread can service many connections
+// instead of one blocking thread per connection.  On Linux the loop uses
+// edge-triggered epoll; elsewhere, or when kPollBackend is requested, it
+// uses level-triggered poll.  Handlers should work with both: read (or
+// accept, or write) until kWouldBlock before returning, otherwise an
+// edge-triggered loop will not report the descriptor again until new data
+// arrives.
+//
+// The loop also runs timers (microseconds on the WPI_Now() timebase, with
+// 1 ms resolution) and functions posted from other threads; Post() wakes a
+// sleeping loop through an eventfd (a pipe off Linux).
+//
+// Only Post() and Stop() are thread-safe; everything else must be called
+// from the loop thread (for example from a handler, timer, or posted
+// function) or while the loop is not running.
+//
+// Not available on Windows.
+class EventLoop {
+ public:
+  enum Events : unsigned int {
+    kReadable = 1,
+    kWritable = 2,
+    kError = 4  // error or hangup; always reported, together with kReadable
+  };
+
+  enum Backend {
+    kDefaultBackend,  // epoll on Linux, poll elsewhere
+    kPollBackend
+  };
+
+  typedef std::function<void(unsigned int events)> Handler;
+  typedef TimerWheel::Callback Callback;
+  typedef TimerWheel::TimerId TimerId;
+
+  static constexpr TimerId kInvalidTimer = TimerWheel::kInvalidTimer;
+
+  explicit EventLoop(Backend backend = kDefaultBackend);
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  // True if readiness is reported edge-triggered (the epoll backend).
+  bool IsEdgeTriggered() const;
+
+  // Calls handler with the ready Events whenever fd is ready for any of
+  // events.  Returns false if fd is already registered or cannot be
+  // watched.  The loop does not own fd; Remove() it before closing it.
+  bool Add(int fd, unsigned int events, Handler handler);
+
+  // Puts stream in non-blocking mode and registers it.
+  bool Add(NetworkStream& stream, unsigned int events, Handler handler);
+
+  // Puts a started acceptor in non-blocking mode and registers it for
+  // incoming connections; the handler should call accept() until it
+  // returns nullptr.  Remove it before calling shutdown().
+  bool Add(TCPAcceptor& acceptor, Handler handler);
+
+  // Changes the events fd is watched for.
+  bool Modify(int fd, unsigned int events);
+
+  // Stops watching fd.  Safe to call from any handler, including fd's own;
+  // the handler is not called again even if events for fd are pending.
+  bool Remove(int fd);
+
+  // Runs callback on the loop thread once, delay from now, and then every
+  // period if period is nonzero.
+  TimerId AddTimer(uint64_t delay, uint64_t period, Callback callback);
+
+  // Cancels a timer.  Returns false if it already ran (one-shot) or was
+  // already cancelled.
+  bool CancelTimer(TimerId id);
+
+  // Runs func on the loop thread, waking the loop if it is waiting.
+  // Functions run in the order posted.
+  void Post(Callback func);
+
+  // Runs the loop until Stop() is called.  A Stop() before Run() makes it
+  // return immediately.
+  void Run();
+
+  // Waits up to timeout ms (forever if negative) for events, then dispatches
+  // them and any expired timers.  Returns false if Stop() was called.
+  bool RunOnce(int timeout);
+
+  // Makes Run() (or the current RunOnce()) return.
+  void Stop();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_TCPSOCKETS_EVENTLOOP_H_
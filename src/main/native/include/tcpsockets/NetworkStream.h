@@ -10,6 +10,7 @@
 
 #include <cstddef>
 
+#include "llvm/ArrayRef.h"
 #include "llvm/StringRef.h"
 
 namespace wpi {
@@ -31,6 +32,19 @@ class NetworkStream {
                          int timeout = 0) = 0;
   virtual void close() = 0;
 
+  // Gathering send: sends the buffers in order, as one send() of their
+  // concatenation would, but without copying them together.  Returns the
+  // total number of bytes sent, which may end partway through any buffer.
+  // The default implementation calls send() for each buffer.
+  virtual size_t sendv(llvm::ArrayRef<llvm::StringRef> bufs, Error* err);
+
+  // Scattering receive: fills the buffers in order, as one receive() into
+  // their concatenation would.  Returns the total number of bytes received.
+  // The default implementation calls receive() for the first non-empty
+  // buffer.
+  virtual size_t receivev(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                          Error* err, int timeout = 0);
+
   virtual llvm::StringRef getPeerIP() const = 0;
   virtual int getPeerPort() const = 0;
   virtual void setNoDelay() = 0;
@@ -0,0 +1,40 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_TCPSOCKETS_SOCKETADDRESS_H_
+#define WPIUTIL_TCPSOCKETS_SOCKETADDRESS_H_
+
+#include <string>
+
+#include "llvm/StringRef.h"
+
+struct sockaddr;
+struct sockaddr_storage;
+
+namespace wpi {
+
+// Helpers for IPv4 and IPv6 socket addresses.
+
+// Parses a numeric IPv4 or IPv6 address (no name lookup; IPv4 is tried
+// first) and port into addr.  Returns the length of the address, or 0 if
+// host is not a numeric address.
+int ParseSocketAddress(llvm::StringRef host, int port, sockaddr_storage* addr);
+
+// Returns the length of an IPv4 or IPv6 address, or 0 for other families.
+int GetSocketAddressLength(const sockaddr* addr);
+
+// Returns the numeric host of an IPv4 or IPv6 address; IPv4-mapped IPv6
+// addresses (from dual-stack sockets) are shown in IPv4 form.  Returns an
+// empty string for other families.
+std::string GetSocketAddressHost(const sockaddr* addr);
+
+// Returns the port of an IPv4 or IPv6 address, or 0 for other families.
+int GetSocketAddressPort(const sockaddr* addr);
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_TCPSOCKETS_SOCKETADDRESS_H_
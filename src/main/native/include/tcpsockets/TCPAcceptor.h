@@ -25,8 +25,10 @@
 #define WPIUTIL_TCPSOCKETS_TCPACCEPTOR_H_
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tcpsockets/NetworkAcceptor.h"
 #include "tcpsockets/TCPStream.h"
@@ -40,16 +42,59 @@ class TCPAcceptor : public NetworkAcceptor {
   int m_port;
   std::string m_address;
   bool m_listening;
+  bool m_blocking = true;
+  bool m_v6only = false;
+  bool m_reusePort = false;
+  bool m_streamBlocking = true;
+  int m_backlog = 5;
   std::atomic_bool m_shutdown;
   Logger& m_logger;
 
  public:
+  // address is a numeric IPv4 or IPv6 address to listen on; if empty, the
+  // acceptor listens on all IPv4 interfaces.  Use "::" to listen on all
+  // interfaces for both IPv4 and IPv6.
   TCPAcceptor(int port, const char* address, Logger& logger);
   ~TCPAcceptor();
 
+  // If true, an IPv6 acceptor accepts only IPv6 connections (IPV6_V6ONLY);
+  // otherwise (the default) it also accepts IPv4 connections.  Must be
+  // called before start().
+  void setV6Only(bool v6only) { m_v6only = v6only; }
+
+  // Maximum length of the queue of pending connections passed to listen();
+  // the OS may silently cap it (e.g. at SOMAXCONN).  Defaults to 5.  Must be
+  // called before start().
+  void setBacklog(int backlog) { m_backlog = backlog; }
+
+  // If true, lets several acceptors (typically one per thread) listen on
+  // the same port, with the kernel load-balancing new connections between
+  // them (SO_REUSEPORT on Linux, SO_REUSEPORT_LB on FreeBSD).  Returns false
+  // where the platform can't load-balance; macOS and other BSDs have
+  // SO_REUSEPORT, but it sends every connection to one socket.  Must be
+  // called before start().
+  bool setReusePort(bool enabled);
+
+  // If false, accepted streams are created in non-blocking mode, without
+  // the extra system call setBlocking() would need.  Defaults to true.
+  void setStreamBlocking(bool enabled) { m_streamBlocking = enabled; }
+
   int start() override;
   void shutdown() override;
   std::unique_ptr<NetworkStream> accept() override;
+
+  // Accepts up to max pending connections, appending them to streams, and
+  // returns the number accepted.  Only the first accept() may block; the
+  // rest of the queue is drained without waiting.
+  size_t acceptBatch(std::vector<std::unique_ptr<NetworkStream>>* streams,
+                     size_t max);
+
+  // In non-blocking mode, accept() returns nullptr immediately if no
+  // connection is pending.  Returns false on failure (including before
+  // start()).
+  bool setBlocking(bool enabled);
+  // Listening socket, or -1 if not listening.
+  int getNativeHandle() const;
 };
 
 }  // namespace wpi
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef WPIUTIL_TCPSOCKETS_TCPACCEPTORGROUP_H_
+#define WPIUTIL_TCPSOCKETS_TCPACCEPTORGROUP_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcpsockets/NetworkStream.h"
+#include "tcpsockets/TCPAcceptor.h"
+
+namespace wpi {
+
+class Logger;
+
+// Accepts connections on one port from several threads.  Where the kernel
+// can load-balance between listening sockets (see
+// TCPAcceptor::setReusePort()), each thread owns its own socket.  Elsewhere
+// there is a single socket and a single accept thread, since threads sharing
+// a blocking socket can't all be woken for shutdown on every platform.
+//
+// The handler is called on the accepting thread, so it should hand the
+// stream off rather than serving the connection itself.
+class TCPAcceptorGroup {
+ public:
+  typedef std::function<void(std::unique_ptr<NetworkStream> stream)> Handler;
+
+  TCPAcceptorGroup(int port, const char* address, Logger& logger,
+                   int numThreads);
+  ~TCPAcceptorGroup();
+
+  TCPAcceptorGroup(const TCPAcceptorGroup&) = delete;
+  TCPAcceptorGroup& operator=(const TCPAcceptorGroup&) = delete;
+
+  // Listen backlog for each socket; see TCPAcceptor::setBacklog().
+  void setBacklog(int backlog) { m_backlog = backlog; }
+
+  // Starts listening and the accept threads.  Returns 0 on success;
+  // on failure, nothing is left listening.
+  int start(Handler handler);
+
+  // Stops accepting and waits for the accept threads to exit.
+  void shutdown();
+
+  // Number of listening sockets, each with its own thread (1 where the
+  // kernel can't load-balance).
+  size_t getNumSockets() const { return m_acceptors.size(); }
+
+ private:
+  void ThreadMain(TCPAcceptor& acceptor);
+
+  int m_port;
+  std::string m_address;
+  Logger& m_logger;
+  int m_numThreads;
+  int m_backlog = 128;
+  Handler m_handler;
+  std::atomic_bool m_shutdown{false};
+  std::vector<std::unique_ptr<TCPAcceptor>> m_acceptors;
+  std::vector<std::thread> m_threads;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_TCPSOCKETS_TCPACCEPTORGROUP_H_
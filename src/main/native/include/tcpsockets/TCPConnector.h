@@ -39,9 +39,19 @@ class TCPConnector {
   static std::unique_ptr<NetworkStream> connect(const char* server, int port,
                                                 Logger& logger,
                                                 int timeout = 0);
+
+  // Connects to whichever of servers accepts first, and closes the other
+  // attempts.  Attempts are non-blocking and all run on the calling thread.
+  // Host names are resolved (blocking) before any attempt starts.
+  // @param timeout overall time limit in seconds; 0 waits until every
+  //                attempt has failed
+  // @param stagger delay in milliseconds between starting successive
+  //                attempts, in order ("happy eyeballs"); an attempt that
+  //                fails starts the next one immediately.  0 starts them all
+  //                at once.
   static std::unique_ptr<NetworkStream> connect_parallel(
       llvm::ArrayRef<std::pair<const char*, int>> servers, Logger& logger,
-      int timeout = 0);
+      int timeout = 0, int stagger = 0);
 };
 
 }  // namespace wpi
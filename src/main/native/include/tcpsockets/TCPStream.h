@@ -29,7 +29,7 @@
 
 #include "tcpsockets/NetworkStream.h"
 
-struct sockaddr_in;
+struct sockaddr;
 
 namespace wpi {
 
@@ -49,6 +49,9 @@ class TCPStream : public NetworkStream {
   size_t receive(char* buffer, size_t len, Error* err,
                  int timeout = 0) override;
   void close() override;
+  size_t sendv(llvm::ArrayRef<llvm::StringRef> bufs, Error* err) override;
+  size_t receivev(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                  Error* err, int timeout = 0) override;
 
   llvm::StringRef getPeerIP() const override;
   int getPeerPort() const override;
@@ -62,7 +65,8 @@ class TCPStream : public NetworkStream {
  private:
   bool WaitForReadEvent(int timeout);
 
-  TCPStream(int sd, sockaddr_in* address);
+  // address is the peer's IPv4 or IPv6 address
+  TCPStream(int sd, const sockaddr* address);
   TCPStream() = delete;
 };
 
@@ -8,7 +8,11 @@
 #ifndef WPIUTIL_UDPSOCKETS_UDPCLIENT_H_
 #define WPIUTIL_UDPSOCKETS_UDPCLIENT_H_
 
+#include <stdint.h>
+
+#include <cstddef>
 #include <string>
+#include <type_traits>
 
 #include "llvm/ArrayRef.h"
 #include "llvm/StringRef.h"
@@ -19,12 +23,35 @@ namespace wpi {
 class Logger;
 
 class UDPClient {
+ public:
+  // A datagram address, resolved once with resolve() (or filled in by
+  // receive()) and reused for any number of sends.
+  class Destination {
+   public:
+    Destination() = default;
+
+    explicit operator bool() const { return m_len != 0; }
+    std::string getHost() const;
+    int getPort() const;
+
+   private:
+    friend class UDPClient;
+
+    std::aligned_storage<128, 8>::type m_addr;  // sockaddr_storage
+    int m_len = 0;
+  };
+
+ private:
   int m_lsd;
+  int m_family = 0;
   std::string m_address;
   Logger& m_logger;
 
  public:
   explicit UDPClient(Logger& logger);
+  // address is a numeric IPv4 or IPv6 address to bind to; if empty, binds to
+  // all IPv4 interfaces.  Use "::" for a dual-stack socket that can send to
+  // both IPv4 and IPv6 addresses.
   UDPClient(llvm::StringRef address, Logger& logger);
   UDPClient(const UDPClient& other) = delete;
   UDPClient(UDPClient&& other);
@@ -33,11 +60,44 @@ class UDPClient {
   UDPClient& operator=(const UDPClient& other) = delete;
   UDPClient& operator=(UDPClient&& other);
 
+  // Binds to an ephemeral port, or to the given port (to receive datagrams
+  // sent to a known port).
   int start();
+  int start(int port);
   void shutdown();
-  // The passed in address MUST be a resolved IP address.
+
+  // Resolves a destination for send() and sendBatch().  The server MUST be a
+  // numeric IPv4 or IPv6 address; on failure, the result is false.
+  Destination resolve(llvm::StringRef server, int port) const;
+
+  // The passed in address MUST be a numeric IPv4 or IPv6 address.
   int send(llvm::ArrayRef<uint8_t> data, llvm::StringRef server, int port);
   int send(llvm::StringRef data, llvm::StringRef server, int port);
+  int send(llvm::ArrayRef<uint8_t> data, const Destination& dest);
+  int send(llvm::StringRef data, const Destination& dest);
+
+  // Sends each element of datagrams as a separate datagram, using
+  // sendmmsg() where available.  Returns the number of datagrams sent,
+  // which may be fewer than requested, or -1 if none could be sent.
+  int sendBatch(llvm::ArrayRef<llvm::StringRef> datagrams,
+                const Destination& dest);
+
+  // Receives a single datagram into buf, blocking until one arrives.
+  // Returns its length (datagrams longer than buf are truncated) or -1 on
+  // error.  If source is not null, it is set to the sender's address.
+  int receive(llvm::MutableArrayRef<char> buf, Destination* source = nullptr);
+
+  // Receives up to bufs.size() datagrams, one into each buffer, using
+  // recvmmsg() where available.  Only the first receive blocks; datagrams
+  // already queued are then drained without waiting.  The length of each
+  // datagram is stored in lens, and if sources is not null, the sender of
+  // each in sources; both must have room for bufs.size() elements.  Returns
+  // the number of datagrams received, or -1 on error.
+  int receiveBatch(llvm::ArrayRef<llvm::MutableArrayRef<char>> bufs,
+                   size_t* lens, Destination* sources = nullptr);
+
+  // Socket, or -1 if not started.
+  int getNativeHandle() const { return m_lsd > 0 ? m_lsd : -1; }
 };
 
 }  // namespace wpi
@@ -0,0 +1,164 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/AsyncLogSink.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/mutex.h"
+
+namespace wpi {
+
+namespace {
+// Collects written records; only touched by the drain thread until the sink
+// is flushed.
+struct Collector {
+  std::vector<LogRecord> records;
+  std::vector<size_t> batches;
+  AsyncLogSink::Writer Writer() {
+    return [this](llvm::ArrayRef<LogRecord> batch) {
+      batches.push_back(batch.size());
+      records.insert(records.end(), batch.begin(), batch.end());
+    };
+  }
+};
+}  // namespace
+
+TEST(AsyncLogSinkTest, LoggerAndFlush) {
+  Collector out;
+  AsyncLogSink sink(out.Writer());
+  Logger logger(sink.GetLogFunc());
+  WPI_INFO(logger, "hello " << 42);
+  WPI_DEBUG(logger, "below min level");
+  WPI_ERROR(logger, "oops");
+  sink.Flush();
+
+  ASSERT_EQ(2u, out.records.size());
+  EXPECT_EQ("hello 42", out.records[0].message);
+  EXPECT_EQ(unsigned(WPI_LOG_INFO), out.records[0].level);
+  EXPECT_EQ("oops", out.records[1].message);
+  EXPECT_LE(out.records[0].time, out.records[1].time);
+  EXPECT_EQ(0u, sink.GetDropped());
+}
+
+TEST(AsyncLogSinkTest, Deferred) {
+  Collector out;
+  AsyncLogSink sink(out.Writer());
+  int value = 7;
+  sink.LogDeferred(WPI_LOG_WARNING, __FILE__, __LINE__,
+                   [value](llvm::raw_ostream& os) { os << "value=" << value; });
+  sink.Log(WPI_LOG_INFO, __FILE__, __LINE__, std::string(500, 'x'));
+  sink.Flush();
+
+  ASSERT_EQ(2u, out.records.size());
+  EXPECT_EQ("value=7", out.records[0].message);
+  // pre-formatted messages are truncated
+  EXPECT_EQ(AsyncLogSink::kMaxMessage, out.records[1].message.size());
+}
+
+TEST(AsyncLogSinkTest, DropWhenFull) {
+  Collector out;
+  AsyncLogSink::Options options;
+  options.ringCapacity = 8;
+  options.pollInterval = std::chrono::milliseconds(1000);
+  AsyncLogSink sink(out.Writer(), options);
+  // let the drain thread go to sleep so nothing is consumed
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 0; i < 20; ++i)
+    sink.Log(WPI_LOG_INFO, __FILE__, __LINE__, "msg");
+  EXPECT_EQ(12u, sink.GetDropped());
+  sink.Flush();
+
+  // 8 messages plus the drop report
+  ASSERT_EQ(9u, out.records.size());
+  EXPECT_EQ("dropped 12 log messages (ring full)", out.records[8].message);
+}
+
+TEST(AsyncLogSinkTest, BlockWhenFull) {
+  Collector out;
+  AsyncLogSink::Options options;
+  options.ringCapacity = 4;
+  options.overflow = AsyncLogSink::kBlock;
+  options.batchSize = 3;
+  AsyncLogSink sink(out.Writer(), options);
+  for (int i = 0; i < 50; ++i)
+    sink.Log(WPI_LOG_INFO, __FILE__, __LINE__, std::to_string(i));
+  sink.Flush();
+
+  EXPECT_EQ(0u, sink.GetDropped());
+  ASSERT_EQ(50u, out.records.size());
+  for (int i = 0; i < 50; ++i)
+    EXPECT_EQ(std::to_string(i), out.records[i].message);
+  for (auto n : out.batches) EXPECT_LE(n, 3u);
+}
+
+TEST(AsyncLogSinkTest, MultipleThreads) {
+  Collector out;
+  {
+    AsyncLogSink sink(out.Writer());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < 100; ++i) {
+          sink.Log(WPI_LOG_INFO, __FILE__, __LINE__, std::to_string(t));
+          if (i % 10 == 0) std::this_thread::yield();
+        }
+      });
+    }
+    for (auto& thr : threads) thr.join();
+    EXPECT_EQ(0u, sink.GetDropped());
+  }  // destructor flushes
+
+  ASSERT_EQ(300u, out.records.size());
+  int counts[3] = {0, 0, 0};
+  for (auto& record : out.records) ++counts[std::stoi(record.message)];
+  EXPECT_EQ(100, counts[0]);
+  EXPECT_EQ(100, counts[2]);
+}
+
+TEST(AsyncLogSinkTest, StreamWriterAndStop) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  AsyncLogSink sink(AsyncLogSink::StreamWriter(os));
+  sink.Log(WPI_LOG_ERROR, "file.cpp", 12, "bad thing");
+  sink.Stop();
+  sink.Log(WPI_LOG_ERROR, "file.cpp", 13, "too late");
+  EXPECT_EQ(1u, sink.GetDropped());
+
+  os.flush();
+  EXPECT_NE(std::string::npos, text.find(" ERROR file.cpp:12: bad thing\n"));
+  EXPECT_EQ(std::string::npos, text.find("too late"));
+}
+
+TEST(AsyncLogSinkTest, StopWhileLogging) {
+  Collector out;
+  AsyncLogSink sink(out.Writer());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 2000; ++i)
+        sink.Log(WPI_LOG_INFO, __FILE__, __LINE__, "msg");
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  sink.Stop();
+  for (auto& thr : threads) thr.join();
+
+  // every message is either written or counted as dropped
+  uint64_t written = 0;
+  for (auto& record : out.records) {
+    if (record.message == "msg") ++written;
+  }
+  EXPECT_EQ(6000u, written + sink.GetDropped());
+}
+
+}  // namespace wpi
@@ -0,0 +1,110 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/BinaryLog.h"  // NOLINT(build/include_order)
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/AsyncLogSink.h"
+
+namespace wpi {
+
+namespace {
+std::string Render(llvm::StringRef format, llvm::StringRef args) {
+  std::string out;
+  llvm::raw_string_ostream os(out);
+  RenderBinaryLog(format, args, os);
+  return os.str();
+}
+
+template <typename... Args>
+std::string Encode(const Args&... args) {
+  uint8_t buf[256];
+  uint8_t* end = detail::BinaryEncode(buf, buf + sizeof(buf), args...);
+  return std::string(reinterpret_cast<char*>(buf), end - buf);
+}
+}  // namespace
+
+TEST(BinaryLogTest, RenderTypes) {
+  std::string name = "arm";
+  EXPECT_EQ("-5 7 true x arm str {} {",
+            Render("{} {} {} {} {} {} {{} {",
+                   Encode(-5, 7u, true, 'x', name, "str")));
+  EXPECT_EQ("v=1.500000e+00", Render("v={}", Encode(1.5)));
+}
+
+TEST(BinaryLogTest, MissingAndMalformedArgs) {
+  EXPECT_EQ("a=1 b={}", Render("a={} b={}", Encode(1)));
+  std::string bad = Encode(1);
+  bad.resize(4);  // truncated value
+  EXPECT_EQ("a=<?> b=<?>", Render("a={} b={}", bad));
+}
+
+TEST(BinaryLogTest, TruncateStrings) {
+  uint8_t buf[16];
+  uint8_t* end =
+      detail::BinaryEncode(buf, buf + sizeof(buf), 1, std::string(100, 'y'));
+  EXPECT_EQ(buf + sizeof(buf), end);
+  EXPECT_EQ("1 yyyy", Render("{} {}", llvm::StringRef(
+                                          reinterpret_cast<char*>(buf), 16)));
+}
+
+TEST(BinaryLogTest, SiteRegistry) {
+  static const BinaryLogSite site{WPI_LOG_INFO, "f.cpp", 3, "x={}"};
+  EXPECT_NE(0u, site.id());
+  EXPECT_EQ(&site, BinaryLogSite::Get(site.id()));
+  EXPECT_EQ(nullptr, BinaryLogSite::Get(0));
+}
+
+TEST(BinaryLogTest, SinkRendersText) {
+  std::vector<std::string> messages;
+  AsyncLogSink sink([&](llvm::ArrayRef<LogRecord> records) {
+    for (auto& record : records) messages.push_back(record.message);
+  });
+  for (int i = 0; i < 3; ++i)
+    WPI_BLOG(sink, WPI_LOG_INFO, "iteration {} of {}", i, "three");
+  sink.Flush();
+  ASSERT_EQ(3u, messages.size());
+  EXPECT_EQ("iteration 2 of three", messages[2]);
+}
+
+TEST(BinaryLogTest, FileRoundTrip) {
+  std::string file;
+  llvm::raw_string_ostream fileStream(file);
+  {
+    AsyncLogSink::Options options;
+    options.renderBinary = false;
+    AsyncLogSink sink(AsyncLogSink::BinaryWriter(fileStream), options);
+    for (int i = 0; i < 2; ++i)
+      WPI_BLOG(sink, WPI_LOG_WARNING, "speed {} rpm", 100 * i);
+    sink.Log(WPI_LOG_ERROR, "text.cpp", 9, "plain text");
+  }
+  fileStream.flush();
+
+  std::string text;
+  llvm::raw_string_ostream textStream(text);
+  ASSERT_TRUE(DecodeBinaryLog(file, textStream));
+  textStream.flush();
+  EXPECT_NE(std::string::npos, text.find("WARNING "));
+  EXPECT_NE(std::string::npos, text.find(": speed 0 rpm\n"));
+  EXPECT_NE(std::string::npos, text.find(": speed 100 rpm\n"));
+  EXPECT_NE(std::string::npos, text.find(" ERROR text.cpp:9: plain text\n"));
+
+  // the format string is stored once
+  EXPECT_EQ(file.find("speed {} rpm"), file.rfind("speed {} rpm"));
+
+  // truncated files decode up to the damage
+  std::string partial;
+  llvm::raw_string_ostream partialStream(partial);
+  EXPECT_FALSE(DecodeBinaryLog(llvm::StringRef(file).drop_back(3),
+                               partialStream));
+  EXPECT_FALSE(DecodeBinaryLog("not a log", partialStream));
+}
+
+}  // namespace wpi
@@ -0,0 +1,90 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/ConcurrentQueue.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(ConcurrentQueueTest, TryPop) {
+  ConcurrentQueue<int> q;
+  int val = 0;
+  EXPECT_FALSE(q.try_pop(val));
+  q.push(5);
+  EXPECT_TRUE(q.try_pop(val));
+  EXPECT_EQ(5, val);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ConcurrentQueueTest, PopMoves) {
+  ConcurrentQueue<std::unique_ptr<int>> q;
+  q.push(std::unique_ptr<int>(new int(3)));
+  std::unique_ptr<int> val;
+  q.pop(val);
+  ASSERT_TRUE(val);
+  EXPECT_EQ(3, *val);
+}
+
+TEST(ConcurrentQueueTest, PopForTimeout) {
+  ConcurrentQueue<int> q;
+  int val = 0;
+  EXPECT_FALSE(q.pop_for(val, std::chrono::milliseconds(10)));
+
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    q.push(7);
+  });
+  EXPECT_TRUE(q.pop_for(val, std::chrono::seconds(5)));
+  EXPECT_EQ(7, val);
+  producer.join();
+}
+
+TEST(ConcurrentQueueTest, PushRangePopN) {
+  ConcurrentQueue<int> q;
+  std::vector<int> in{1, 2, 3, 4, 5};
+  q.push_range(in.begin(), in.end());
+  EXPECT_EQ(5u, q.size());
+
+  std::vector<int> out;
+  EXPECT_EQ(3u, q.pop_n(std::back_inserter(out), 3));
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), out);
+  EXPECT_EQ(2u, q.pop_n(std::back_inserter(out), 10));
+  EXPECT_EQ(in, out);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ConcurrentQueueTest, PopAll) {
+  ConcurrentQueue<std::unique_ptr<int>> q;
+  for (int i = 0; i < 4; ++i) q.emplace(new int(i));
+
+  std::vector<std::unique_ptr<int>> out;
+  EXPECT_EQ(4u, q.pop_all(std::back_inserter(out)));
+  ASSERT_EQ(4u, out.size());
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(i, *out[i]);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ConcurrentQueueTest, PopAllWaits) {
+  ConcurrentQueue<int> q;
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    int items[] = {1, 2};
+    q.push_range(std::begin(items), std::end(items));
+  });
+  std::vector<int> out;
+  EXPECT_EQ(2u, q.pop_all(std::back_inserter(out)));
+  producer.join();
+}
+
+}  // namespace wpi
@@ -0,0 +1,111 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/ConcurrentSlotMap.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(ConcurrentSlotMapTest, EmplaceReadErase) {
+  ConcurrentSlotMap<std::string> map;
+  auto a = map.emplace("alpha");
+  auto b = map.emplace(2, 'b');
+  std::string seen;
+  EXPECT_TRUE(map.Read(b, [&](const std::string& s) { seen = s; }));
+  EXPECT_EQ("bb", seen);
+
+  EXPECT_TRUE(map.erase(a));
+  EXPECT_FALSE(map.erase(a));
+  EXPECT_FALSE(map.contains(a));
+  EXPECT_FALSE(map.Read(a, [](const std::string&) { FAIL(); }));
+
+  // reused slot gets a new generation
+  auto c = map.emplace("gamma");
+  EXPECT_EQ(a & 0xffffffffu, c & 0xffffffffu);
+  EXPECT_NE(a, c);
+  EXPECT_FALSE(map.contains(a));
+  EXPECT_TRUE(map.contains(c));
+  EXPECT_EQ(2u, map.size());
+}
+
+TEST(ConcurrentSlotMapTest, Stats) {
+  ConcurrentSlotMap<int> map;
+  std::vector<ConcurrentSlotMap<int>::handle_type> handles;
+  for (int i = 0; i < 100; ++i) handles.push_back(map.emplace(i));
+  for (int i = 0; i < 30; ++i) map.erase(handles[i]);
+  map.contains(handles[0]);
+
+  auto stats = map.GetStats();
+  EXPECT_EQ(70u, stats.live);
+  EXPECT_EQ(100u, stats.peakLive);
+  EXPECT_EQ(100u, stats.used);
+  EXPECT_EQ(30u, stats.free);
+  EXPECT_EQ(2u, stats.segments);  // 64 + 128 slots
+  EXPECT_EQ(192u, stats.capacity);
+  EXPECT_EQ(1u, stats.staleLookups);
+}
+
+TEST(ConcurrentSlotMapTest, ForEach) {
+  ConcurrentSlotMap<int> map;
+  std::vector<ConcurrentSlotMap<int>::handle_type> handles;
+  for (int i = 0; i < 200; ++i) handles.push_back(map.emplace(i));
+  for (int i = 0; i < 200; i += 2) map.erase(handles[i]);
+
+  int count = 0;
+  map.ForEach([&](ConcurrentSlotMap<int>::handle_type h, int v) {
+    EXPECT_EQ(1, v % 2);
+    EXPECT_EQ(handles[v], h);
+    ++count;
+  });
+  EXPECT_EQ(100, count);
+}
+
+TEST(ConcurrentSlotMapTest, ConcurrentLookups) {
+  auto tracker = std::make_shared<int>(0);
+  {
+    ConcurrentSlotMap<std::shared_ptr<int>> map;
+    std::vector<ConcurrentSlotMap<std::shared_ptr<int>>::handle_type> handles;
+    for (int i = 0; i < 64; ++i) handles.push_back(map.emplace(tracker));
+
+    std::atomic<bool> done{false};
+    std::atomic<int> bad{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+      readers.emplace_back([&] {
+        while (!done) {
+          for (auto h : handles) {
+            map.Read(h, [&](const std::shared_ptr<int>& p) {
+              if (p != tracker) ++bad;
+            });
+          }
+          std::this_thread::yield();
+        }
+      });
+    }
+    // churn: erase and re-add, growing into new segments
+    for (int i = 0; i < 2000; ++i) {
+      map.erase(handles[i % 64]);
+      map.emplace(tracker);
+      if (i % 32 == 0) std::this_thread::yield();
+    }
+    done = true;
+    for (auto& thr : readers) thr.join();
+    EXPECT_EQ(0, bad);
+    EXPECT_EQ(64u + 2000u - 64u, map.size());
+  }
+  RcuBarrier();
+  EXPECT_EQ(1, tracker.use_count());
+}
+
+}  // namespace wpi
@@ -0,0 +1,157 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef _WIN32
+
+#include "tcpsockets/EventLoop.h"  // NOLINT(build/include_order)
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+#include "tcpsockets/TCPAcceptor.h"
+#include "tcpsockets/TCPConnector.h"
+
+namespace wpi {
+
+class EventLoopTest : public ::testing::TestWithParam<EventLoop::Backend> {};
+
+TEST_P(EventLoopTest, PostWakesLoop) {
+  EventLoop loop(GetParam());
+  std::vector<int> ran;
+  std::thread poster([&] {
+    loop.Post([&] { ran.push_back(1); });
+    loop.Post([&] {
+      ran.push_back(2);
+      loop.Stop();
+    });
+  });
+  loop.Run();
+  poster.join();
+  ASSERT_EQ(ran.size(), 2u);
+  EXPECT_EQ(ran[0], 1);
+  EXPECT_EQ(ran[1], 2);
+}
+
+TEST_P(EventLoopTest, StopBeforeRun) {
+  EventLoop loop(GetParam());
+  loop.Stop();
+  loop.Run();  // returns immediately
+  EXPECT_TRUE(loop.RunOnce(0));
+}
+
+TEST_P(EventLoopTest, Timers) {
+  EventLoop loop(GetParam());
+  std::vector<int> fired;
+  int ticks = 0;
+  EventLoop::TimerId periodic = EventLoop::kInvalidTimer;
+  periodic = loop.AddTimer(1000, 1000, [&] {
+    if (++ticks == 3) {
+      loop.CancelTimer(periodic);
+      fired.push_back(1);
+    }
+  });
+  loop.AddTimer(20000, 0, [&] {
+    fired.push_back(2);
+    loop.Stop();
+  });
+  auto cancelled = loop.AddTimer(5000, 0, [&] { fired.push_back(3); });
+  EXPECT_TRUE(loop.CancelTimer(cancelled));
+  loop.Run();
+  EXPECT_EQ(ticks, 3);
+  ASSERT_EQ(fired.size(), 2u);
+  EXPECT_EQ(fired[0], 1);
+  EXPECT_EQ(fired[1], 2);
+}
+
+TEST_P(EventLoopTest, RemoveDuringDispatch) {
+  EventLoop loop(GetParam());
+  int a[2], b[2];
+  ASSERT_EQ(pipe(a), 0);
+  ASSERT_EQ(pipe(b), 0);
+  int calls = 0;
+  auto handler = [&](unsigned int events) {
+    EXPECT_TRUE(events & EventLoop::kReadable);
+    ++calls;
+    loop.Remove(a[0]);
+    loop.Remove(b[0]);
+  };
+  ASSERT_TRUE(loop.Add(a[0], EventLoop::kReadable, handler));
+  ASSERT_TRUE(loop.Add(b[0], EventLoop::kReadable, handler));
+  EXPECT_FALSE(loop.Add(a[0], EventLoop::kReadable, handler));
+  ASSERT_EQ(write(a[1], "x", 1), 1);
+  ASSERT_EQ(write(b[1], "x", 1), 1);
+  loop.RunOnce(1000);
+  EXPECT_EQ(calls, 1);
+  EXPECT_FALSE(loop.Remove(a[0]));
+  for (int fd : {a[0], a[1], b[0], b[1]}) close(fd);
+}
+
+TEST_P(EventLoopTest, TcpEcho) {
+  Logger logger;
+  int port = 39412 + static_cast<int>(GetParam());
+  TCPAcceptor acceptor(port, "127.0.0.1", logger);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  EventLoop loop(GetParam());
+  std::vector<std::shared_ptr<NetworkStream>> streams;
+  ASSERT_TRUE(loop.Add(acceptor, [&](unsigned int) {
+    while (auto accepted = acceptor.accept()) {
+      std::shared_ptr<NetworkStream> stream(std::move(accepted));
+      streams.push_back(stream);
+      NetworkStream* s = stream.get();
+      loop.Add(*stream, EventLoop::kReadable, [&loop, s](unsigned int) {
+        char buf[64];
+        for (;;) {
+          NetworkStream::Error err = NetworkStream::kConnectionClosed;
+          size_t len = s->receive(buf, sizeof(buf), &err);
+          if (len == 0) {
+            if (err != NetworkStream::kWouldBlock)
+              loop.Remove(s->getNativeHandle());
+            return;
+          }
+          s->send(buf, len, &err);
+        }
+      });
+    }
+  }));
+
+  std::string echoed;
+  std::thread client([&] {
+    auto stream = TCPConnector::connect("127.0.0.1", port, logger, 1);
+    if (stream) {
+      NetworkStream::Error err;
+      stream->send("hello", 5, &err);
+      char buf[16];
+      while (echoed.size() < 5) {
+        size_t len = stream->receive(buf, sizeof(buf), &err, 1);
+        if (len == 0) break;
+        echoed.append(buf, len);
+      }
+    }
+    loop.Post([&] { loop.Stop(); });
+  });
+  loop.Run();
+  client.join();
+
+  EXPECT_EQ(echoed, "hello");
+  EXPECT_EQ(streams.size(), 1u);
+  loop.Remove(acceptor.getNativeHandle());
+}
+
+INSTANTIATE_TEST_CASE_P(EventLoopTests, EventLoopTest,
+                        ::testing::Values(EventLoop::kDefaultBackend,
+                                          EventLoop::kPollBackend), );
+
+}  // namespace wpi
+
+#endif  // _WIN32
@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Logger.h"  // NOLINT(build/include_order)
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+namespace {
+uint64_t fakeNow;
+}  // namespace
+
+class LoggerTest : public ::testing::Test {
+ protected:
+  LoggerTest()
+      : logger([this](unsigned int, const char*, unsigned int,
+                      const char* msg) { messages.push_back(msg); }) {}
+
+  std::vector<std::string> messages;
+  Logger logger;
+};
+
+TEST_F(LoggerTest, FirstN) {
+  for (int i = 0; i < 10; ++i) WPI_LOG_FIRST_N(logger, WPI_LOG_INFO, 3, i);
+  EXPECT_EQ((std::vector<std::string>{"0", "1", "2"}), messages);
+}
+
+TEST_F(LoggerTest, EveryN) {
+  for (int i = 0; i < 10; ++i) WPI_LOG_EVERY_N(logger, WPI_LOG_INFO, 4, i);
+  EXPECT_EQ((std::vector<std::string>{"0", "4", "8"}), messages);
+}
+
+TEST_F(LoggerTest, RateLimited) {
+  fakeNow = 1000000;
+  SetNowImpl([] { return fakeNow; });
+
+  auto log = [&](int i) {
+    WPI_ERROR_RATE_LIMITED(logger, 1000, "error " << i);
+  };
+  log(0);
+  for (int i = 1; i <= 5; ++i) log(i);  // suppressed
+  fakeNow += 1000;
+  log(6);
+  fakeNow += 1000;
+  log(7);
+  SetNowImpl(nullptr);
+
+  EXPECT_EQ((std::vector<std::string>{
+                "error 0", "error 6 (suppressed 5 similar messages)",
+                "error 7"}),
+            messages);
+}
+
+TEST_F(LoggerTest, SuppressedBelowMinLevel) {
+  // disabled levels don't consume the site's budget
+  logger.set_min_level(WPI_LOG_WARNING);
+  for (int i = 0; i < 2; ++i) {
+    WPI_LOG_FIRST_N(logger, WPI_LOG_INFO, 1, "info");
+    logger.set_min_level(WPI_LOG_INFO);
+  }
+  EXPECT_EQ((std::vector<std::string>{"info"}), messages);
+}
+
+}  // namespace wpi
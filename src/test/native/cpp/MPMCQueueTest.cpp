@@ -0,0 +1,99 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/MPMCQueue.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(MPMCQueueTest, Capacity) {
+  MPMCQueue<int> q1(1);
+  EXPECT_EQ(2u, q1.capacity());
+  MPMCQueue<int> q5(5);
+  EXPECT_EQ(8u, q5.capacity());
+  MPMCQueue<int> q16(16);
+  EXPECT_EQ(16u, q16.capacity());
+}
+
+TEST(MPMCQueueTest, TryPushPop) {
+  MPMCQueue<int> q(4);
+  int val;
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(val));
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+  EXPECT_FALSE(q.try_push(4));
+  EXPECT_EQ(4u, q.size());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(q.try_pop(val));
+    EXPECT_EQ(i, val);
+  }
+  EXPECT_FALSE(q.try_pop(val));
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(MPMCQueueTest, MoveOnly) {
+  MPMCQueue<std::unique_ptr<std::string>> q(2);
+  q.push(std::unique_ptr<std::string>(new std::string("hello")));
+  q.emplace(new std::string("world"));
+  EXPECT_EQ("hello", *q.pop());
+  std::unique_ptr<std::string> val;
+  q.pop(val);
+  EXPECT_EQ("world", *val);
+}
+
+TEST(MPMCQueueTest, DestroysRemaining) {
+  auto ptr = std::make_shared<int>(5);
+  {
+    MPMCQueue<std::shared_ptr<int>> q(4);
+    q.push(ptr);
+    q.push(ptr);
+    EXPECT_EQ(3, ptr.use_count());
+  }
+  EXPECT_EQ(1, ptr.use_count());
+}
+
+TEST(MPMCQueueTest, MultiProducerMultiConsumer) {
+  static constexpr int kProducers = 4;
+  static constexpr int kConsumers = 4;
+  static constexpr int kPerProducer = 20000;
+
+  // Small capacity so both blocking paths are exercised.
+  MPMCQueue<int> q(16);
+  std::atomic<long long> sum{0};  // NOLINT(runtime/int)
+  std::atomic<int> count{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&] {
+      for (int i = 1; i <= kPerProducer; ++i) q.push(i);
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        sum += q.pop();
+        ++count;
+      }
+    });
+  }
+  for (auto& thr : threads) thr.join();
+
+  EXPECT_EQ(kProducers * kPerProducer, count.load());
+  EXPECT_EQ(static_cast<long long>(kProducers) * kPerProducer *  // NOLINT
+                (kPerProducer + 1) / 2,
+            sum.load());
+  EXPECT_TRUE(q.empty());
+}
+
+}  // namespace wpi
@@ -0,0 +1,115 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Metrics.h"  // NOLINT(build/include_order)
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/ConcurrentQueue.h"
+#include "support/json.h"
+
+namespace wpi {
+
+TEST(MetricsTest, BucketBounds) {
+  uint64_t prevUpper = 0;
+  for (size_t i = 0; i < LatencyHistogram::kBuckets - 1; ++i) {
+    uint64_t lower = LatencyHistogram::BucketLowerBound(i);
+    uint64_t upper = LatencyHistogram::BucketUpperBound(i);
+    if (i > 0) {
+      EXPECT_EQ(prevUpper + 1, lower) << i;
+    }
+    EXPECT_EQ(i, LatencyHistogram::BucketIndex(lower));
+    EXPECT_EQ(i, LatencyHistogram::BucketIndex(upper));
+    // relative precision
+    EXPECT_LE(upper - lower, lower / LatencyHistogram::kSubBuckets) << i;
+    prevUpper = upper;
+  }
+  EXPECT_EQ(LatencyHistogram::kBuckets - 1,
+            LatencyHistogram::BucketIndex(UINT64_MAX));
+}
+
+TEST(MetricsTest, Percentiles) {
+  LatencyHistogram hist;
+  for (uint64_t v = 1; v <= 10000; ++v) hist.Record(v * 1000);
+  auto snapshot = hist.Snapshot();
+  EXPECT_EQ(10000u, snapshot.count);
+  EXPECT_EQ(10000000u, snapshot.max);
+  EXPECT_NEAR(5000500.0, snapshot.Mean(), 1);
+  EXPECT_NEAR(5000000.0, snapshot.Percentile(0.5), 5000000.0 / 16);
+  EXPECT_NEAR(9900000.0, snapshot.Percentile(0.99), 9900000.0 / 16);
+  EXPECT_GE(snapshot.Percentile(0.99), 9900000u);
+  EXPECT_EQ(10000000u, snapshot.Percentile(1.0));
+  EXPECT_EQ(0u, HistogramSnapshot().Percentile(0.5));
+}
+
+TEST(MetricsTest, ThreadsMerged) {
+  LatencyHistogram hist;
+  MetricCounter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        hist.Record(100);
+        counter.Add();
+      }
+    });
+  }
+  for (auto& thr : threads) thr.join();
+  auto snapshot = hist.Snapshot();
+  EXPECT_EQ(4000u, snapshot.count);
+  EXPECT_EQ(400000u, snapshot.sum);
+  EXPECT_EQ(4000u, snapshot.buckets[LatencyHistogram::BucketIndex(100)]);
+  EXPECT_EQ(4000u, counter.Get());
+}
+
+TEST(MetricsTest, RegistrySnapshot) {
+  MetricsRegistry registry;
+  registry.GetCounter("requests").Add(3);
+  registry.GetGauge("connections").Set(5);
+  registry.GetGauge("connections").Add(-2);
+  registry.GetHistogram("latency_ns").Record(1000);
+  EXPECT_EQ(&registry.GetCounter("requests"), &registry.GetCounter("requests"));
+
+  json snapshot = registry.Snapshot();
+  EXPECT_EQ(3u, snapshot["counters"]["requests"].get<uint64_t>());
+  EXPECT_EQ(3, snapshot["gauges"]["connections"].get<int64_t>());
+  EXPECT_EQ(1u, snapshot["histograms"]["latency_ns"]["count"].get<uint64_t>());
+  EXPECT_EQ(1000u, snapshot["histograms"]["latency_ns"]["p99"].get<uint64_t>());
+
+  EXPECT_EQ(snapshot, json::from_cbor(registry.SnapshotCbor()));
+}
+
+TEST(MetricsTest, Instrumentation) {
+  auto& registry = MetricsRegistry::GetInstance();
+  auto& parse = registry.GetHistogram("json.parse_ns");
+  auto& wait = registry.GetHistogram("concurrentqueue.wait_ns");
+  uint64_t parseBase = parse.Snapshot().count;
+  uint64_t waitBase = wait.Snapshot().count;
+
+  json::parse("[1, 2, 3]");
+  EXPECT_EQ(parseBase, parse.Snapshot().count);
+
+  MetricsRegistry::EnableInstrumentation(true);
+  json::parse("[1, 2, 3]");
+  ConcurrentQueue<int> queue;
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.push(1);
+  });
+  EXPECT_EQ(1, queue.pop());
+  producer.join();
+  MetricsRegistry::EnableInstrumentation(false);
+
+  EXPECT_EQ(parseBase + 1, parse.Snapshot().count);
+  auto waits = wait.Snapshot();
+  EXPECT_EQ(waitBase + 1, waits.count);
+  EXPECT_GE(waits.max, 5000000u);
+}
+
+}  // namespace wpi
@@ -0,0 +1,176 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/MutexProfiler.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(MutexProfilerTest, Percentile) {
+  MutexProfileSnapshot s;
+  s.waitHistogram.resize(48);
+  s.waitHistogram[3] = 99;   // [8, 16)
+  s.waitHistogram[10] = 1;   // [1024, 2048)
+  s.maxWaitNs = 1500;
+  EXPECT_EQ(15u, s.WaitPercentile(0.5));
+  EXPECT_EQ(15u, s.WaitPercentile(0.98));
+  EXPECT_EQ(1500u, s.WaitPercentile(1.0));
+  EXPECT_EQ(0u, s.HoldPercentile(0.5));
+}
+
+#if defined(WPI_HAVE_PRIORITY_MUTEX) && defined(WPI_MUTEX_PROFILING)
+
+namespace {
+// Runs fn while another thread holds mutex, so fn's lock() contends.
+template <typename Mutex, typename F>
+void WhileHeld(Mutex& mutex, F fn) {
+  std::atomic<bool> locked{false};
+  std::thread holder([&] {
+    std::lock_guard<Mutex> lock(mutex);
+    locked = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  });
+  while (!locked) std::this_thread::yield();
+  fn();
+  holder.join();
+}
+
+const MutexProfileSnapshot* Find(const std::vector<MutexProfileSnapshot>& v,
+                                 llvm::StringRef name) {
+  for (auto& s : v) {
+    if (s.name == name) return &s;
+  }
+  return nullptr;
+}
+}  // namespace
+
+TEST(MutexProfilerTest, Contention) {
+  ASSERT_TRUE(MutexProfiler::IsEnabled());
+  MutexProfiler::SetCaptureCallSites(true);
+  priority_mutex mutex;
+  SetMutexProfileName(mutex, "test.contention");
+
+  std::atomic<bool> locked{false};
+  std::thread holder([&] {
+    std::lock_guard<priority_mutex> lock(mutex);
+    locked = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  while (!locked) std::this_thread::yield();
+  { std::lock_guard<priority_mutex> lock(mutex); }
+  holder.join();
+  for (int i = 0; i < 10; ++i) {
+    std::lock_guard<priority_mutex> lock(mutex);
+  }
+  MutexProfiler::SetCaptureCallSites(false);
+
+  auto snapshot = MutexProfiler::Snapshot();
+  auto s = Find(snapshot, "test.contention");
+  ASSERT_NE(nullptr, s);
+  EXPECT_EQ(&mutex, s->mutex);
+  EXPECT_EQ(12u, s->acquisitions);
+  EXPECT_EQ(1u, s->contended);
+  EXPECT_GE(s->maxWaitNs, 10000000u);
+  EXPECT_GE(s->maxHoldNs, 10000000u);
+  EXPECT_GE(s->holdNs, s->maxHoldNs);
+  ASSERT_EQ(1u, s->callSites.size());
+  EXPECT_EQ(1u, s->callSites[0].second);
+
+  std::string out;
+  llvm::raw_string_ostream os(out);
+  MutexProfiler::Dump(os);
+  EXPECT_NE(std::string::npos, os.str().find("test.contention"));
+}
+
+TEST(MutexProfilerTest, DistinctCallSites) {
+  MutexProfiler::SetCaptureCallSites(true);
+  priority_mutex mutex;
+  SetMutexProfileName(mutex, "test.callsites");
+  for (int i = 0; i < 2; ++i) {
+    WhileHeld(mutex, [&] {
+      mutex.lock();
+      mutex.unlock();
+    });
+  }
+  WhileHeld(mutex, [&] { std::lock_guard<priority_mutex> lock(mutex); });
+  MutexProfiler::SetCaptureCallSites(false);
+
+  auto snapshot = MutexProfiler::Snapshot();
+  auto s = Find(snapshot, "test.callsites");
+  ASSERT_NE(nullptr, s);
+  EXPECT_EQ(3u, s->contended);
+  ASSERT_EQ(2u, s->callSites.size());
+  EXPECT_EQ(2u, s->callSites[0].second);
+  EXPECT_EQ(1u, s->callSites[1].second);
+}
+
+TEST(MutexProfilerTest, Recursive) {
+  priority_recursive_mutex mutex;
+  SetMutexProfileName(mutex, "test.recursive");
+  {
+    std::lock_guard<priority_recursive_mutex> outer(mutex);
+    std::lock_guard<priority_recursive_mutex> inner(mutex);
+  }
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+  auto snapshot = MutexProfiler::Snapshot();
+  auto s = Find(snapshot, "test.recursive");
+  ASSERT_NE(nullptr, s);
+  EXPECT_EQ(2u, s->acquisitions);  // outermost acquisitions only
+  EXPECT_EQ(0u, s->contended);
+}
+
+TEST(MutexProfilerTest, Destroyed) {
+  {
+    priority_mutex quiet;
+    SetMutexProfileName(quiet, "test.quiet");
+    std::lock_guard<priority_mutex> lock(quiet);
+  }
+  EXPECT_EQ(nullptr, Find(MutexProfiler::Snapshot(), "test.quiet"));
+
+  {
+    priority_mutex hot;
+    SetMutexProfileName(hot, "test.hot");
+    std::atomic<bool> locked{false};
+    std::thread holder([&] {
+      std::lock_guard<priority_mutex> lock(hot);
+      locked = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+    while (!locked) std::this_thread::yield();
+    { std::lock_guard<priority_mutex> lock(hot); }
+    holder.join();
+  }
+  auto snapshot = MutexProfiler::Snapshot();
+  auto s = Find(snapshot, "test.hot");
+  ASSERT_NE(nullptr, s);
+  EXPECT_EQ(nullptr, s->mutex);
+  EXPECT_EQ(1u, s->contended);
+
+  MutexProfiler::Reset();
+  EXPECT_EQ(nullptr, Find(MutexProfiler::Snapshot(), "test.hot"));
+}
+
+#else
+
+TEST(MutexProfilerTest, Disabled) {
+  EXPECT_FALSE(MutexProfiler::IsEnabled());
+  EXPECT_TRUE(MutexProfiler::Snapshot().empty());
+  std::mutex mutex;
+  SetMutexProfileName(mutex, "ignored");
+}
+
+#endif
+
+}  // namespace wpi
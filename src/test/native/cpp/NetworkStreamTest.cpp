@@ -0,0 +1,143 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/NetworkStream.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+#include "support/raw_socket_ostream.h"
+#include "tcpsockets/TCPAcceptor.h"
+#include "tcpsockets/TCPConnector.h"
+
+namespace wpi {
+
+namespace {
+
+// Records the data passed to each send() or sendv() call, accepting at most
+// maxSend bytes per call.
+class RecordingStream : public NetworkStream {
+ public:
+  explicit RecordingStream(bool gather, size_t maxSend = SIZE_MAX)
+      : m_gather(gather), m_maxSend(maxSend) {}
+
+  size_t send(const char* buffer, size_t len, Error* err) override {
+    len = std::min(len, m_maxSend);
+    calls.emplace_back(buffer, len);
+    return len;
+  }
+
+  size_t sendv(llvm::ArrayRef<llvm::StringRef> bufs, Error* err) override {
+    if (!m_gather) return NetworkStream::sendv(bufs, err);
+    std::string data;
+    for (auto buf : bufs) data += buf;
+    if (data.size() > m_maxSend) data.resize(m_maxSend);
+    calls.push_back(data);
+    return data.size();
+  }
+
+  size_t receive(char*, size_t, Error* err, int) override {
+    *err = kConnectionClosed;
+    return 0;
+  }
+  void close() override {}
+  llvm::StringRef getPeerIP() const override { return ""; }
+  int getPeerPort() const override { return 0; }
+  void setNoDelay() override {}
+  bool setBlocking(bool) override { return true; }
+  int getNativeHandle() const override { return -1; }
+
+  std::vector<std::string> calls;
+
+ private:
+  bool m_gather;
+  size_t m_maxSend;
+};
+
+}  // namespace
+
+TEST(NetworkStreamTest, DefaultSendv) {
+  RecordingStream stream(false, 4);
+  llvm::StringRef bufs[] = {"ab", "", "cdef"};
+  NetworkStream::Error err;
+  // stops at the first short send
+  EXPECT_EQ(stream.sendv(bufs, &err), 6u);
+  ASSERT_EQ(stream.calls.size(), 2u);
+  EXPECT_EQ(stream.calls[0], "ab");
+  EXPECT_EQ(stream.calls[1], "cdef");
+
+  llvm::StringRef big[] = {"123456", "78"};
+  EXPECT_EQ(stream.sendv(big, &err), 4u);
+  EXPECT_EQ(stream.calls.size(), 3u);
+}
+
+TEST(NetworkStreamTest, OstreamCoalescesLargeWrite) {
+  RecordingStream stream(true);
+  std::string payload(20000, 'x');
+  {
+    raw_socket_ostream os(stream, false);
+    os << "header";
+    os << payload;
+    EXPECT_EQ(stream.calls.size(), 1u);
+    os << "trailer";
+  }
+  ASSERT_EQ(stream.calls.size(), 2u);
+  EXPECT_EQ(stream.calls[0], "header" + payload);
+  EXPECT_EQ(stream.calls[1], "trailer");
+}
+
+TEST(NetworkStreamTest, OstreamShortSendv) {
+  RecordingStream stream(true, 7000);
+  std::string payload(20000, 'x');
+  {
+    raw_socket_ostream os(stream, false);
+    os << "header" << payload;
+  }
+  std::string sent;
+  for (auto& call : stream.calls) sent += call;
+  EXPECT_EQ(stream.calls.size(), 3u);
+  EXPECT_EQ(sent, "header" + payload);
+}
+
+TEST(NetworkStreamTest, TcpSendvReceivev) {
+  Logger logger;
+  TCPAcceptor acceptor(39420, "127.0.0.1", logger);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  std::unique_ptr<NetworkStream> client;
+  std::thread connector([&] {
+    client = TCPConnector::connect("127.0.0.1", 39420, logger, 1);
+  });
+  auto server = acceptor.accept();
+  connector.join();
+  ASSERT_TRUE(server);
+  ASSERT_TRUE(client);
+
+  NetworkStream::Error err;
+  llvm::StringRef bufs[] = {"head", "", "er:", "payload"};
+  ASSERT_EQ(client->sendv(bufs, &err), 14u);
+
+  char a[6], b[16];
+  llvm::MutableArrayRef<char> recvBufs[] = {a, b};
+  std::string received;
+  while (received.size() < 14) {
+    size_t len = server->receivev(recvBufs, &err, 1);
+    ASSERT_NE(len, 0u);
+    received.append(a, std::min(len, sizeof(a)));
+    if (len > sizeof(a)) received.append(b, len - sizeof(a));
+  }
+  EXPECT_EQ(received, "header:payload");
+}
+
+}  // namespace wpi
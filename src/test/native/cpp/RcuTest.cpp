@@ -0,0 +1,141 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/Rcu.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+namespace {
+// Counts live instances so tests can observe reclamation.
+struct Tracked {
+  static std::atomic<int> live;
+  explicit Tracked(int v = 0) : value(v) { ++live; }
+  Tracked(const Tracked& other) : value(other.value) { ++live; }
+  ~Tracked() { --live; }
+  int value;
+};
+std::atomic<int> Tracked::live{0};
+}  // namespace
+
+TEST(RcuTest, ReadStoreUpdate) {
+  RcuPtr<Tracked> ptr(std::unique_ptr<Tracked>(new Tracked(1)));
+  EXPECT_EQ(1, ptr.Read([](const Tracked* t) { return t->value; }));
+
+  ptr.Store(std::unique_ptr<Tracked>(new Tracked(2)));
+  {
+    RcuReadLock lock;
+    EXPECT_EQ(2, ptr.get()->value);
+  }
+
+  ptr.Update([](Tracked& t) { t.value += 10; });
+  EXPECT_EQ(12, ptr.Read([](const Tracked* t) { return t->value; }));
+
+  ptr.Store(nullptr);
+  EXPECT_TRUE(ptr.Read([](const Tracked* t) { return t == nullptr; }));
+}
+
+TEST(RcuTest, Reclaim) {
+  RcuBarrier();  // objects retired by earlier tests
+  int before = Tracked::live;
+  {
+    RcuPtr<Tracked> ptr(std::unique_ptr<Tracked>(new Tracked(0)));
+    for (int i = 1; i <= 100; ++i)
+      ptr.Store(std::unique_ptr<Tracked>(new Tracked(i)));
+  }
+  RcuBarrier();
+  EXPECT_EQ(before, Tracked::live);
+}
+
+TEST(RcuTest, ReaderDelaysReclaim) {
+  RcuBarrier();  // objects retired by earlier tests
+  int before = Tracked::live;
+  RcuPtr<Tracked> ptr(std::unique_ptr<Tracked>(new Tracked(1)));
+
+  std::atomic<bool> reading{false};
+  std::atomic<bool> release{false};
+  std::atomic<int> seen{0};
+  std::thread reader([&] {
+    RcuReadLock lock;
+    const Tracked* t = ptr.get();
+    reading = true;
+    while (!release) std::this_thread::yield();
+    // still valid even though it was replaced
+    seen = t->value;
+  });
+  while (!reading) std::this_thread::yield();
+
+  ptr.Store(std::unique_ptr<Tracked>(new Tracked(2)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  // the old object is pinned by the reader
+  EXPECT_EQ(before + 2, Tracked::live);
+
+  release = true;
+  reader.join();
+  EXPECT_EQ(1, seen);
+  RcuBarrier();
+  EXPECT_EQ(before + 1, Tracked::live);
+}
+
+TEST(RcuTest, SynchronizeWaitsForReader) {
+  std::atomic<bool> reading{false};
+  std::atomic<bool> finished{false};
+  std::thread reader([&] {
+    RcuReadLock outer;
+    {
+      RcuReadLock inner;  // nesting
+    }
+    reading = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    finished = true;
+  });
+  while (!reading) std::this_thread::yield();
+  RcuSynchronize();
+  EXPECT_TRUE(finished);
+  reader.join();
+}
+
+TEST(RcuTest, ConcurrentReaders) {
+  RcuBarrier();  // objects retired by earlier tests
+  int before = Tracked::live;
+  {
+    RcuPtr<Tracked> ptr(std::unique_ptr<Tracked>(new Tracked(0)));
+    std::atomic<bool> done{false};
+    std::atomic<int> bad{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+      readers.emplace_back([&] {
+        int last = 0;
+        while (!done) {
+          int v = ptr.Read([](const Tracked* t) { return t->value; });
+          if (v < last) ++bad;  // values are published in increasing order
+          last = v;
+          std::this_thread::yield();
+        }
+      });
+    }
+    for (int i = 1; i <= 1000; ++i) {
+      ptr.Update([](Tracked& t) { ++t.value; });
+      if (i % 16 == 0) std::this_thread::yield();
+    }
+    done = true;
+    for (auto& thr : readers) thr.join();
+    EXPECT_EQ(0, bad);
+    EXPECT_EQ(1000, ptr.Read([](const Tracked* t) { return t->value; }));
+  }
+  RcuBarrier();
+  EXPECT_EQ(before, Tracked::live);
+}
+
+}  // namespace wpi
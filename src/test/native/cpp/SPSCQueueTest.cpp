@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/SPSCQueue.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(SPSCQueueTest, TryPushPop) {
+  SPSCQueue<int> q(4);
+  int val;
+  EXPECT_EQ(4u, q.capacity());
+  EXPECT_FALSE(q.try_pop(val));
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+  EXPECT_FALSE(q.try_push(4));
+  EXPECT_EQ(4u, q.size());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(q.try_pop(val));
+    EXPECT_EQ(i, val);
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueueTest, ReserveWraps) {
+  SPSCQueue<int> q(8);
+  int val;
+  // advance indices so free space wraps around the end of the buffer
+  for (int i = 0; i < 6; ++i) q.try_push(i);
+  for (int i = 0; i < 6; ++i) q.try_pop(val);
+
+  auto buf = q.reserve(8);
+  ASSERT_EQ(2u, buf.size());  // up to end of buffer
+  buf[0] = 10;
+  buf[1] = 11;
+  q.commit(2);
+
+  buf = q.reserve(8);
+  ASSERT_EQ(6u, buf.size());  // rest of the ring
+  for (int i = 0; i < 6; ++i) buf[i] = 12 + i;
+  q.commit(6);
+  EXPECT_TRUE(q.reserve(1).empty());
+
+  auto data = q.peek();
+  ASSERT_EQ(2u, data.size());
+  EXPECT_EQ(10, data[0]);
+  EXPECT_EQ(11, data[1]);
+  q.consume(2);
+
+  data = q.peek(4);
+  ASSERT_EQ(4u, data.size());
+  EXPECT_EQ(12, data[0]);
+  q.consume(4);
+  EXPECT_EQ(2u, q.size());
+}
+
+TEST(SPSCQueueTest, Threaded) {
+  static constexpr int kCount = 100000;
+  SPSCQueue<int> q(64);
+
+  std::thread producer([&] {
+    int next = 0;
+    while (next < kCount) {
+      auto buf = q.reserve(16);
+      if (buf.empty()) std::this_thread::yield();
+      for (auto& elem : buf) elem = next++;
+      q.commit(buf.size());
+    }
+  });
+
+  int expected = 0;
+  bool ordered = true;
+  while (expected < kCount) {
+    auto buf = q.peek();
+    if (buf.empty()) std::this_thread::yield();
+    for (int elem : buf) {
+      if (elem != expected) ordered = false;
+      ++expected;
+    }
+    q.consume(buf.size());
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueueTest, BlockingSafeThread) {
+  static constexpr int kCount = 10000;
+
+  class Consumer : public SafeThread {
+   public:
+    void Main() override {
+      int val;
+      while (m_active) {
+        if (!m_queue.pop(val, m_active)) break;
+        m_sum += val;
+      }
+      m_done = true;
+    }
+
+    BlockingSPSCQueue<int> m_queue{8, *this};
+    std::atomic<int> m_sum{0};
+    std::atomic_bool m_done{false};
+  };
+
+  // The owner stops the consumer (waking it out of pop()) on destruction.
+  Consumer* consumer = new Consumer;
+  SafeThreadOwner<Consumer> owner;
+  owner.Start(consumer);
+
+  std::atomic_bool active{true};
+  int expected = 0;
+  for (int i = 1; i <= kCount; ++i) {
+    ASSERT_TRUE(consumer->m_queue.push(i, active));
+    expected += i;
+  }
+  while (consumer->m_sum != expected) std::this_thread::yield();
+  EXPECT_FALSE(consumer->m_done);
+}
+
+}  // namespace wpi
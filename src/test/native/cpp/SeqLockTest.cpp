@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/SeqLock.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+namespace {
+struct Pose {
+  double x;
+  double y;
+  double heading;
+  int32_t seq;  // odd size so the last word is partial
+};
+}  // namespace
+
+TEST(SeqLockTest, StoreLoad) {
+  SeqLock<Pose> lock(Pose{1.0, 2.0, 3.0, 4});
+  Pose p = lock.Load();
+  EXPECT_EQ(1.0, p.x);
+  EXPECT_EQ(4, p.seq);
+
+  lock.Store(Pose{5.0, 6.0, 7.0, 8});
+  ASSERT_TRUE(lock.TryLoad(p));
+  EXPECT_EQ(6.0, p.y);
+  EXPECT_EQ(8, p.seq);
+
+  lock.Update([](Pose& v) { ++v.seq; });
+  p = lock.Load();
+  EXPECT_EQ(7.0, p.heading);
+  EXPECT_EQ(9, p.seq);
+}
+
+TEST(SeqLockTest, Consistency) {
+  // Every field of a published value is the same, so a torn read shows up
+  // as mismatched fields.
+  SeqLock<Pose> lock(Pose{0, 0, 0, 0});
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; ++i) {
+    readers.emplace_back([&] {
+      while (!done) {
+        Pose p = lock.Load();
+        if (p.x != p.y || p.y != p.heading || p.heading != p.seq) ++torn;
+        std::this_thread::yield();
+      }
+    });
+  }
+  for (int i = 1; i <= 5000; ++i) {
+    lock.Store(Pose{double(i), double(i), double(i), i});
+    if (i % 16 == 0) std::this_thread::yield();
+  }
+  done = true;
+  for (auto& thr : readers) thr.join();
+
+  EXPECT_EQ(0, torn);
+  EXPECT_EQ(5000, lock.Load().seq);
+}
+
+}  // namespace wpi
@@ -0,0 +1,92 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/SlotMap.h"  // NOLINT(build/include_order)
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(SlotMapTest, EmplaceGetErase) {
+  SlotMap<std::string> map;
+  auto a = map.emplace("alpha");
+  auto b = map.emplace(3, 'b');
+  EXPECT_NE(SlotMap<std::string>::kInvalidHandle, a);
+  EXPECT_EQ(2u, map.size());
+  ASSERT_NE(nullptr, map.get(b));
+  EXPECT_EQ("bbb", *map.get(b));
+
+  EXPECT_TRUE(map.erase(a));
+  EXPECT_FALSE(map.erase(a));
+  EXPECT_EQ(nullptr, map.get(a));
+  EXPECT_FALSE(map.contains(SlotMap<std::string>::kInvalidHandle));
+  EXPECT_EQ(1u, map.size());
+}
+
+TEST(SlotMapTest, StaleHandle) {
+  SlotMap<int> map;
+  auto a = map.emplace(1);
+  map.erase(a);
+  auto b = map.emplace(2);  // reuses the slot
+  EXPECT_NE(a, b);
+  EXPECT_FALSE(map.contains(a));
+  EXPECT_EQ(nullptr, map.get(a));
+  EXPECT_EQ(2, *map.get(b));
+}
+
+TEST(SlotMapTest, ReuseThreshold) {
+  SlotMap<int, 2> map;
+  auto a = map.emplace(0);
+  auto b = map.emplace(1);
+  map.erase(a);
+  map.emplace(2);  // freelist below threshold: appends
+  map.erase(b);
+  auto c = map.emplace(3);  // reuses a's slot first
+  EXPECT_EQ(a & 0xffffffffu, c & 0xffffffffu);
+  EXPECT_EQ(2u, map.size());
+}
+
+TEST(SlotMapTest, StableAndDestroyed) {
+  auto tracker = std::make_shared<int>(0);
+  {
+    SlotMap<std::shared_ptr<int>> map;
+    auto first = map.emplace(tracker);
+    const std::shared_ptr<int>* p = map.get(first);
+    for (int i = 0; i < 1000; ++i) map.emplace(tracker);
+    EXPECT_EQ(p, map.get(first));  // never moved
+    EXPECT_EQ(1002, tracker.use_count());
+    map.erase(first);
+    EXPECT_EQ(1001, tracker.use_count());
+  }
+  EXPECT_EQ(1, tracker.use_count());
+}
+
+TEST(SlotMapTest, IterateLive) {
+  SlotMap<int> map;
+  std::vector<SlotMap<int>::handle_type> handles;
+  for (int i = 0; i < 6; ++i) handles.push_back(map.emplace(i));
+  map.erase(handles[0]);
+  map.erase(handles[3]);
+
+  std::vector<int> values;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    values.push_back(*it);
+    EXPECT_EQ(handles[*it], it.handle());
+  }
+  EXPECT_EQ((std::vector<int>{1, 2, 4, 5}), values);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_FALSE(map.contains(handles[1]));
+}
+
+}  // namespace wpi
@@ -0,0 +1,121 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/SocketAddress.h"  // NOLINT(build/include_order)
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <Ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+#include "tcpsockets/TCPAcceptor.h"
+#include "tcpsockets/TCPConnector.h"
+#include "udpsockets/UDPClient.h"
+
+namespace wpi {
+
+static const sockaddr* AsSockaddr(const sockaddr_storage& addr) {
+  return reinterpret_cast<const sockaddr*>(&addr);
+}
+
+TEST(SocketAddressTest, ParseIPv4) {
+  sockaddr_storage addr;
+  EXPECT_EQ(ParseSocketAddress("10.1.2.3", 1735, &addr),
+            static_cast<int>(sizeof(sockaddr_in)));
+  EXPECT_EQ(addr.ss_family, AF_INET);
+  EXPECT_EQ(GetSocketAddressLength(AsSockaddr(addr)),
+            static_cast<int>(sizeof(sockaddr_in)));
+  EXPECT_EQ(GetSocketAddressHost(AsSockaddr(addr)), "10.1.2.3");
+  EXPECT_EQ(GetSocketAddressPort(AsSockaddr(addr)), 1735);
+}
+
+TEST(SocketAddressTest, ParseIPv6) {
+  sockaddr_storage addr;
+  EXPECT_EQ(ParseSocketAddress("fe80::1", 5800, &addr),
+            static_cast<int>(sizeof(sockaddr_in6)));
+  EXPECT_EQ(addr.ss_family, AF_INET6);
+  EXPECT_EQ(GetSocketAddressHost(AsSockaddr(addr)), "fe80::1");
+  EXPECT_EQ(GetSocketAddressPort(AsSockaddr(addr)), 5800);
+}
+
+TEST(SocketAddressTest, ParseInvalid) {
+  sockaddr_storage addr;
+  EXPECT_EQ(ParseSocketAddress("", 1, &addr), 0);
+  EXPECT_EQ(ParseSocketAddress("localhost", 1, &addr), 0);
+  EXPECT_EQ(ParseSocketAddress("1.2.3.4.5", 1, &addr), 0);
+}
+
+TEST(SocketAddressTest, MappedIPv4ShownAsIPv4) {
+  sockaddr_storage addr;
+  ASSERT_NE(ParseSocketAddress("::ffff:192.168.0.7", 80, &addr), 0);
+  EXPECT_EQ(addr.ss_family, AF_INET6);
+  EXPECT_EQ(GetSocketAddressHost(AsSockaddr(addr)), "192.168.0.7");
+}
+
+TEST(SocketAddressTest, TcpIPv6Loopback) {
+  Logger logger;
+  TCPAcceptor acceptor(39440, "::1", logger);
+  if (acceptor.start() != 0) return;  // no IPv6 on this host
+
+  std::unique_ptr<NetworkStream> client;
+  std::thread connector(
+      [&] { client = TCPConnector::connect("::1", 39440, logger, 1); });
+  auto server = acceptor.accept();
+  connector.join();
+  ASSERT_TRUE(server);
+  ASSERT_TRUE(client);
+  EXPECT_EQ(server->getPeerIP(), "::1");
+  EXPECT_EQ(client->getPeerIP(), "::1");
+  EXPECT_EQ(client->getPeerPort(), 39440);
+}
+
+TEST(SocketAddressTest, DualStackAcceptsIPv4) {
+  Logger logger;
+  TCPAcceptor acceptor(39441, "::", logger);
+  if (acceptor.start() != 0) return;  // no IPv6 on this host
+
+  std::unique_ptr<NetworkStream> client;
+  std::thread connector(
+      [&] { client = TCPConnector::connect("127.0.0.1", 39441, logger, 1); });
+  auto server = acceptor.accept();
+  connector.join();
+  ASSERT_TRUE(server);
+  ASSERT_TRUE(client);
+  EXPECT_EQ(server->getPeerIP(), "127.0.0.1");
+}
+
+TEST(SocketAddressTest, V6OnlyRejectsIPv4) {
+  Logger logger;
+  TCPAcceptor acceptor(39442, "::", logger);
+  acceptor.setV6Only(true);
+  if (acceptor.start() != 0) return;  // no IPv6 on this host
+  EXPECT_FALSE(TCPConnector::connect("127.0.0.1", 39442, logger, 1));
+}
+
+TEST(SocketAddressTest, UdpFamilies) {
+  Logger logger;
+  UDPClient v4(logger);
+  ASSERT_EQ(v4.start(), 0);
+  EXPECT_EQ(v4.send(llvm::StringRef("hi"), "127.0.0.1", 39443), 2);
+  EXPECT_EQ(v4.send(llvm::StringRef("hi"), "::1", 39443), -1);
+
+  UDPClient dual("::", logger);
+  if (dual.start() != 0) return;  // no IPv6 on this host
+  EXPECT_EQ(dual.send(llvm::StringRef("hi"), "127.0.0.1", 39443), 2);
+  EXPECT_EQ(dual.send(llvm::StringRef("hi"), "::1", 39443), 2);
+}
+
+}  // namespace wpi
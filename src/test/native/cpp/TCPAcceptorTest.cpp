@@ -0,0 +1,108 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/TCPAcceptor.h"  // NOLINT(build/include_order)
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+#include "tcpsockets/TCPAcceptorGroup.h"
+#include "tcpsockets/TCPConnector.h"
+
+namespace wpi {
+
+TEST(TCPAcceptorTest, AcceptBatch) {
+  Logger logger;
+  TCPAcceptor acceptor(39450, "127.0.0.1", logger);
+  acceptor.setBacklog(16);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  // connections complete into the backlog before they are accepted
+  std::vector<std::unique_ptr<NetworkStream>> clients;
+  for (int i = 0; i < 4; ++i) {
+    clients.emplace_back(TCPConnector::connect("127.0.0.1", 39450, logger, 1));
+    ASSERT_TRUE(clients.back());
+  }
+
+  std::vector<std::unique_ptr<NetworkStream>> streams;
+  EXPECT_EQ(acceptor.acceptBatch(&streams, 3), 3u);
+  EXPECT_EQ(acceptor.acceptBatch(&streams, 3), 1u);
+  EXPECT_EQ(streams.size(), 4u);
+
+  ASSERT_TRUE(acceptor.setBlocking(false));
+  EXPECT_EQ(acceptor.acceptBatch(&streams, 3), 0u);
+}
+
+TEST(TCPAcceptorTest, NonBlockingStreams) {
+  Logger logger;
+  TCPAcceptor acceptor(39451, "127.0.0.1", logger);
+  acceptor.setStreamBlocking(false);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  auto client = TCPConnector::connect("127.0.0.1", 39451, logger, 1);
+  ASSERT_TRUE(client);
+  auto server = acceptor.accept();
+  ASSERT_TRUE(server);
+
+  char buf[4];
+  NetworkStream::Error err = NetworkStream::kConnectionClosed;
+  EXPECT_EQ(server->receive(buf, sizeof(buf), &err), 0u);
+  EXPECT_EQ(err, NetworkStream::kWouldBlock);
+#ifndef _WIN32
+  int fd = server->getNativeHandle();
+  EXPECT_TRUE(fcntl(fd, F_GETFL) & O_NONBLOCK);
+  EXPECT_TRUE(fcntl(fd, F_GETFD) & FD_CLOEXEC);
+#endif
+}
+
+TEST(TCPAcceptorTest, ReusePort) {
+  Logger logger;
+  TCPAcceptor first(39452, "127.0.0.1", logger);
+  TCPAcceptor second(39452, "127.0.0.1", logger);
+  if (!first.setReusePort(true)) return;  // no load-balancing here
+  second.setReusePort(true);
+  ASSERT_EQ(first.start(), 0);
+  EXPECT_EQ(second.start(), 0);
+}
+
+TEST(TCPAcceptorTest, Group) {
+  Logger logger;
+  std::atomic<int> accepted{0};
+  std::vector<std::unique_ptr<NetworkStream>> clients;
+  {
+    TCPAcceptorGroup group(39453, "127.0.0.1", logger, 2);
+    auto handler = [&](std::unique_ptr<NetworkStream> stream) {
+      if (stream) ++accepted;
+    };
+    ASSERT_EQ(group.start(handler), 0);
+#ifdef __linux__
+    EXPECT_EQ(group.getNumSockets(), 2u);
+#else
+    EXPECT_GE(group.getNumSockets(), 1u);
+#endif
+
+    for (int i = 0; i < 8; ++i) {
+      clients.emplace_back(
+          TCPConnector::connect("127.0.0.1", 39453, logger, 1));
+      ASSERT_TRUE(clients.back());
+    }
+    for (int i = 0; i < 500 && accepted < 8; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(accepted, 8);
+}
+
+}  // namespace wpi
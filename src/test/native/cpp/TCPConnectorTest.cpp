@@ -0,0 +1,84 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "tcpsockets/TCPConnector.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+#include "tcpsockets/TCPAcceptor.h"
+
+namespace wpi {
+
+// Nothing listens on kClosedPort, so connecting to it is refused.
+static constexpr int kClosedPort = 39431;
+static constexpr int kOpenPort = 39432;
+static constexpr int kClosedPort2 = 39433;
+
+TEST(TCPConnectorTest, ParallelPicksListening) {
+  Logger logger;
+  TCPAcceptor acceptor(kOpenPort, "127.0.0.1", logger);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  std::pair<const char*, int> servers[] = {{"127.0.0.1", kClosedPort},
+                                           {"127.0.0.1", kOpenPort}};
+  auto stream = TCPConnector::connect_parallel(servers, logger, 1);
+  ASSERT_TRUE(stream);
+  EXPECT_EQ(stream->getPeerPort(), kOpenPort);
+}
+
+TEST(TCPConnectorTest, ParallelAllFail) {
+  Logger logger;
+  std::pair<const char*, int> servers[] = {{"127.0.0.1", kClosedPort},
+                                           {"127.0.0.1", kClosedPort}};
+  EXPECT_FALSE(TCPConnector::connect_parallel(servers, logger));
+}
+
+TEST(TCPConnectorTest, ParallelLogsEachServer) {
+  std::vector<std::string> errors;
+  Logger logger([&](unsigned int level, const char*, unsigned int,
+                    const char* msg) {
+    if (level == WPI_LOG_ERROR) errors.emplace_back(msg);
+  });
+  std::pair<const char*, int> servers[] = {{"127.0.0.1", kClosedPort},
+                                           {"127.0.0.1", kClosedPort2}};
+  // failures of different servers are not suppressed as duplicates, even
+  // when retried
+  for (int i = 0; i < 2; ++i)
+    EXPECT_FALSE(TCPConnector::connect_parallel(servers, logger));
+  ASSERT_EQ(errors.size(), 4u);
+  for (int port : {kClosedPort, kClosedPort2}) {
+    int count = 0;
+    for (auto& error : errors) {
+      if (error.find("port " + std::to_string(port)) != std::string::npos)
+        ++count;
+    }
+    EXPECT_EQ(count, 2) << port;
+  }
+}
+
+TEST(TCPConnectorTest, ParallelStaggerFailsOver) {
+  Logger logger;
+  TCPAcceptor acceptor(kOpenPort, "127.0.0.1", logger);
+  ASSERT_EQ(acceptor.start(), 0);
+
+  std::pair<const char*, int> servers[] = {{"127.0.0.1", kClosedPort},
+                                           {"127.0.0.1", kOpenPort}};
+  auto start = std::chrono::steady_clock::now();
+  // the refused first attempt starts the second without waiting 10 s
+  auto stream = TCPConnector::connect_parallel(servers, logger, 0, 10000);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(stream);
+  EXPECT_EQ(stream->getPeerPort(), kOpenPort);
+  EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+}  // namespace wpi
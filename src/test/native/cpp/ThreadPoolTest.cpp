@@ -0,0 +1,180 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/ThreadPool.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+static ThreadPool::Options MakeOptions(unsigned int numThreads,
+                                       size_t queueCapacity = 1024) {
+  ThreadPool::Options options;
+  options.numThreads = numThreads;
+  options.queueCapacity = queueCapacity;
+  return options;
+}
+
+TEST(ThreadPoolTest, Submit) {
+  ThreadPool pool(MakeOptions(2));
+  EXPECT_EQ(2u, pool.GetNumThreads());
+
+  auto sum = pool.Submit([] { return 1 + 2; });
+  EXPECT_EQ(3, sum.get());
+
+  auto onWorker = pool.Submit([&] { return pool.IsWorkerThread(); });
+  EXPECT_TRUE(onWorker.get());
+
+  auto error = pool.Submit([]() -> int { throw std::runtime_error("oops"); });
+  EXPECT_THROW(error.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, Continuation) {
+  ThreadPool pool(MakeOptions(2));
+  auto result = pool.Submit([] { return 20; },
+                            [](std::future<int> f) { return f.get() + 1; });
+  EXPECT_EQ(21, result.get());
+
+  auto caught =
+      pool.Submit([]() -> int { throw std::runtime_error("oops"); },
+                  [](std::future<int> f) {
+                    try {
+                      f.get();
+                    } catch (const std::runtime_error&) {
+                      return true;
+                    }
+                    return false;
+                  });
+  EXPECT_TRUE(caught.get());
+}
+
+TEST(ThreadPoolTest, WaitIdle) {
+  ThreadPool pool(MakeOptions(3, 16));
+  std::atomic<int> count{0};
+  for (int i = 0; i < 1000; ++i) EXPECT_TRUE(pool.Execute([&] { ++count; }));
+  pool.WaitIdle();
+  EXPECT_EQ(1000, count);
+}
+
+TEST(ThreadPoolTest, NestedTasks) {
+  ThreadPool pool(MakeOptions(4));
+  std::atomic<int> count{0};
+  // Each top-level task fans out onto its worker's deque; idle workers steal.
+  for (int i = 0; i < 8; ++i) {
+    pool.Execute([&] {
+      for (int j = 0; j < 100; ++j) pool.Execute([&] { ++count; });
+    });
+  }
+  pool.WaitIdle();
+  EXPECT_EQ(800, count);
+}
+
+TEST(ThreadPoolTest, TryExecuteFull) {
+  ThreadPool pool(MakeOptions(1, 2));
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::promise<void> started;
+
+  pool.Execute([&] {
+    started.set_value();
+    opened.wait();
+  });
+  started.get_future().wait();
+
+  // worker is blocked; the global queue holds two tasks
+  EXPECT_TRUE(pool.TryExecute([] {}));
+  EXPECT_TRUE(pool.TryExecute([] {}));
+  EXPECT_FALSE(pool.TryExecute([] {}));
+
+  gate.set_value();
+  pool.WaitIdle();
+  EXPECT_TRUE(pool.TryExecute([] {}));
+}
+
+TEST(ThreadPoolTest, StopDrains) {
+  std::atomic<int> count{0};
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  {
+    ThreadPool pool(MakeOptions(1));
+    pool.Execute([=] { opened.wait(); });
+    for (int i = 0; i < 10; ++i) pool.Execute([&] { ++count; });
+    pool.Stop();
+    EXPECT_FALSE(pool.Execute([] {}));
+    gate.set_value();
+  }
+  // workers outlive the pool object and finish the queued tasks
+  auto start = std::chrono::steady_clock::now();
+  while (count != 10 &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(10, count);
+}
+
+TEST(ThreadPoolTest, StopDiscards) {
+  ThreadPool pool(MakeOptions(1));
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  auto started = std::make_shared<std::promise<void>>();
+  auto running = started->get_future();
+  // the worker may still be finishing this task after the test returns
+  pool.Execute([=] {
+    started->set_value();
+    opened.wait();
+  });
+  running.wait();
+  auto never = pool.Submit([] { return 1; });
+  pool.Stop(false);
+  pool.WaitIdle();  // must not wait for the discarded task
+  gate.set_value();
+  EXPECT_THROW(never.get(), std::future_error);
+}
+
+namespace {
+// A task that submits a copy of itself each time it runs.  The tenth run
+// signals started and waits for opened, so Stop() can be called while a
+// run is in progress.
+struct Resubmit {
+  ThreadPool* pool;
+  std::shared_ptr<std::atomic<int>> runs;
+  std::shared_ptr<std::promise<void>> started;
+  std::shared_future<void> opened;
+  void operator()() const {
+    if (++*runs == 10) {
+      started->set_value();
+      opened.wait();
+    }
+    pool->Execute(*this);
+  }
+};
+}  // namespace
+
+TEST(ThreadPoolTest, StopEndsResubmission) {
+  ThreadPool pool(MakeOptions(1));
+  auto runs = std::make_shared<std::atomic<int>>(0);
+  auto started = std::make_shared<std::promise<void>>();
+  auto running = started->get_future();
+  std::promise<void> gate;
+  pool.Execute(Resubmit{&pool, runs, started, gate.get_future().share()});
+  running.wait();
+  pool.Stop(false);
+  gate.set_value();
+
+  // Execute() from the worker now fails, so the chain ends
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(10, *runs);
+}
+
+}  // namespace wpi
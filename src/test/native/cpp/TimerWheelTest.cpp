@@ -0,0 +1,224 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/TimerWheel.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/TimerService.h"
+
+namespace wpi {
+
+namespace {
+
+// Records the order in which timers fire.
+struct Recorder {
+  std::vector<int> fired;
+  TimerWheel::Callback Add(int n) {
+    return [this, n] { fired.push_back(n); };
+  }
+};
+
+void RunAll(TimerWheel& wheel, uint64_t now) {
+  wheel.Advance(now, [](TimerWheel::Callback& cb, bool) { cb(); });
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, OneShotOrder) {
+  TimerWheel wheel(0, 1);
+  Recorder rec;
+  wheel.Schedule(30, 0, rec.Add(3));
+  wheel.Schedule(10, 0, rec.Add(1));
+  wheel.Schedule(20, 0, rec.Add(2));
+  EXPECT_EQ(3u, wheel.size());
+  EXPECT_EQ(10u, wheel.GetNextExpiry());
+
+  RunAll(wheel, 9);
+  EXPECT_TRUE(rec.fired.empty());
+  RunAll(wheel, 25);
+  EXPECT_EQ((std::vector<int>{1, 2}), rec.fired);
+  RunAll(wheel, 30);
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), rec.fired);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(TimerWheel::kNoTimer, wheel.GetNextExpiry());
+}
+
+TEST(TimerWheelTest, PastDeadline) {
+  TimerWheel wheel(100, 1);
+  Recorder rec;
+  wheel.Schedule(50, 0, rec.Add(1));
+  RunAll(wheel, 100);
+  EXPECT_TRUE(rec.fired.empty());  // current tick already processed
+  RunAll(wheel, 101);
+  EXPECT_EQ(1u, rec.fired.size());
+}
+
+TEST(TimerWheelTest, Cancel) {
+  TimerWheel wheel(0, 1);
+  Recorder rec;
+  auto a = wheel.Schedule(10, 0, rec.Add(1));
+  auto b = wheel.Schedule(10, 0, rec.Add(2));
+  EXPECT_TRUE(wheel.IsPending(a));
+  EXPECT_TRUE(wheel.Cancel(a));
+  EXPECT_FALSE(wheel.Cancel(a));
+  EXPECT_FALSE(wheel.IsPending(a));
+
+  // the freed node is reused, but the old id stays stale
+  auto c = wheel.Schedule(20, 0, rec.Add(3));
+  EXPECT_NE(a, c);
+  EXPECT_FALSE(wheel.Cancel(a));
+
+  RunAll(wheel, 100);
+  EXPECT_EQ((std::vector<int>{2, 3}), rec.fired);
+  EXPECT_FALSE(wheel.Cancel(b));
+}
+
+TEST(TimerWheelTest, Periodic) {
+  TimerWheel wheel(0, 1);
+  int count = 0;
+  auto id = wheel.Schedule(10, 10, [&] { ++count; });
+  for (uint64_t now = 1; now <= 55; ++now) RunAll(wheel, now);
+  EXPECT_EQ(5, count);
+  EXPECT_TRUE(wheel.IsPending(id));
+  EXPECT_EQ(60u, wheel.GetNextExpiry());
+
+  // missed periods are skipped rather than made up in a burst
+  RunAll(wheel, 1005);
+  EXPECT_EQ(6, count);
+  EXPECT_EQ(1010u, wheel.GetNextExpiry());
+  EXPECT_TRUE(wheel.Cancel(id));
+  RunAll(wheel, 2000);
+  EXPECT_EQ(6, count);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, CancelFromVisitor) {
+  TimerWheel wheel(0, 1);
+  int count = 0;
+  TimerWheel::TimerId id = 0;
+  id = wheel.Schedule(5, 5, [&] {
+    if (++count == 3) wheel.Cancel(id);
+  });
+  for (uint64_t now = 1; now <= 100; ++now) RunAll(wheel, now);
+  EXPECT_EQ(3, count);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, ScheduleFromVisitor) {
+  TimerWheel wheel(0, 1);
+  Recorder rec;
+  wheel.Schedule(5, 0, [&] {
+    rec.fired.push_back(1);
+    // a timer due "now" runs on the next tick
+    wheel.Schedule(5, 0, rec.Add(2));
+  });
+  RunAll(wheel, 5);
+  EXPECT_EQ((std::vector<int>{1}), rec.fired);
+  RunAll(wheel, 6);
+  EXPECT_EQ((std::vector<int>{1, 2}), rec.fired);
+}
+
+TEST(TimerWheelTest, Resolution) {
+  TimerWheel wheel(0, 1000);
+  int count = 0;
+  wheel.Schedule(1500, 0, [&] { ++count; });  // rounds up to 2000
+  EXPECT_EQ(2000u, wheel.GetNextExpiry());
+  RunAll(wheel, 1999);
+  EXPECT_EQ(0, count);
+  RunAll(wheel, 2000);
+  EXPECT_EQ(1, count);
+}
+
+TEST(TimerWheelTest, Cascade) {
+  // deadlines on every level and beyond the wheel's 2^32 tick range
+  TimerWheel wheel(12345, 1);
+  std::vector<uint64_t> deadlines{12345 + 300, 12345 + 70000,
+                                  12345 + 20000000, 12345 + 5000000000ull};
+  std::vector<uint64_t> fired;
+  for (auto deadline : deadlines) wheel.Schedule(deadline, 0, [] {});
+
+  uint64_t now = 12345;
+  while (!wheel.empty()) {
+    uint64_t next = wheel.GetNextExpiry();
+    ASSERT_GT(next, now);
+    now = next;
+    size_t before = wheel.size();
+    wheel.Advance(now, [](TimerWheel::Callback&, bool) {});
+    if (wheel.size() != before) fired.push_back(now);
+  }
+  EXPECT_EQ(deadlines, fired);
+}
+
+TEST(TimerWheelTest, Random) {
+  TimerWheel wheel(0, 1);
+  std::srand(1234);
+  std::vector<uint64_t> deadlines(20000);
+  uint64_t late = 0;
+  for (auto& deadline : deadlines) {
+    deadline = 1 + (static_cast<uint64_t>(std::rand()) * 97) % 3000000;
+    uint64_t* slot = &deadline;
+    wheel.Schedule(deadline, 0, [slot] { *slot = 0; });
+  }
+  // advance in uneven steps and check every timer fired on time
+  uint64_t now = 0;
+  while (!wheel.empty()) {
+    now += 1 + std::rand() % 5000;
+    wheel.Advance(now, [&](TimerWheel::Callback& cb, bool) { cb(); });
+    for (auto deadline : deadlines) {
+      if (deadline != 0 && deadline <= now) ++late;
+    }
+    if (late != 0) break;
+  }
+  EXPECT_EQ(0u, late);
+}
+
+TEST(TimerServiceTest, OneShotAndPeriodic) {
+  TimerService timers;
+  std::atomic<int> once{0};
+  std::atomic<int> periodic{0};
+  timers.Schedule(1000, [&] { ++once; });
+  auto id = timers.SchedulePeriodic(2000, [&] { ++periodic; });
+  auto cancelled = timers.Schedule(1000000, [&] { ++once; });
+  EXPECT_EQ(3u, timers.GetPending());
+  EXPECT_TRUE(timers.Cancel(cancelled));
+
+  auto start = std::chrono::steady_clock::now();
+  while ((once == 0 || periodic < 3) &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(1, once);
+  EXPECT_GE(periodic, 3);
+  EXPECT_TRUE(timers.Cancel(id));
+  EXPECT_EQ(0u, timers.GetPending());
+}
+
+TEST(TimerServiceTest, Executor) {
+  std::atomic<int> dispatched{0};
+  std::atomic<int> ran{0};
+  TimerService timers([&](TimerService::Callback cb) {
+    ++dispatched;
+    cb();
+  });
+  timers.Schedule(0, [&] { ++ran; });
+  auto start = std::chrono::steady_clock::now();
+  while (ran == 0 &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(1, dispatched);
+  EXPECT_EQ(1, ran);
+
+  timers.Stop();
+  EXPECT_EQ(TimerService::kInvalidTimer, timers.Schedule(0, [] {}));
+}
+
+}  // namespace wpi
@@ -0,0 +1,107 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/timestamp.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "support/timestamp_tsc.h"
+
+namespace wpi {
+
+namespace {
+// allowed difference between the TSC and the default clock, in microseconds
+constexpr int64_t kTolerance = 1000;
+
+int64_t TscError() {
+  int64_t before = NowDefault();
+  int64_t tsc = NowTsc();
+  int64_t after = NowDefault();
+  if (tsc < before) return tsc - before;
+  if (tsc > after) return tsc - after;
+  return 0;
+}
+}  // namespace
+
+TEST(TimestampTest, NowNsMonotonic) {
+  uint64_t prev = NowNs();
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t now = NowNs();
+    ASSERT_GE(now, prev);
+    prev = now;
+  }
+}
+
+TEST(TimestampTest, NowNsEpoch) {
+  uint64_t before = NowDefault();
+  uint64_t ns = NowNs();
+  uint64_t after = NowDefault();
+  EXPECT_GE(ns / 1000, before - kTolerance);
+  EXPECT_LE(ns / 1000, after + kTolerance);
+}
+
+TEST(TimestampTest, NowTscTracksDefault) {
+  if (!HaveTsc()) return;
+  EXPECT_LE(std::abs(TscError()), kTolerance);
+  // long enough to trigger a resynchronization
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  EXPECT_LE(std::abs(TscError()), kTolerance);
+  uint64_t prev = NowTsc();
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t now = NowTsc();
+    ASSERT_GE(now, prev);
+    prev = now;
+  }
+  EXPECT_LE(std::abs(TscError()), kTolerance);
+}
+
+TEST(TimestampTest, TscResyncAfterIdleGap) {
+  using detail::TscParams;
+  // a 1 GHz counter (so ticks equal clock nanoseconds), calibrated 10 ppm
+  // fast
+  TscParams params;
+  params.tsc = 0;
+  params.ns = 0;
+  params.mult = (uint64_t(1) << 32) + (uint64_t(1) << 32) / 100000;
+  params.resync = (detail::kTscResyncNs << 32) / params.mult;
+
+  // no reads for 200 s, then one per resync period
+  uint64_t tsc = 200000000000u;
+  for (int i = 0; i < 10; ++i) {
+    uint64_t before = params.ns + detail::TscScale(tsc - params.tsc,
+                                                   params.mult);
+    params = detail::TscResync(params, tsc, tsc);
+    ASSERT_GE(params.ns, before);
+    ASSERT_GT(params.mult, 0u);
+    tsc += params.resync + 1;
+  }
+  // within the calibration error over one period (10 us), where holding the
+  // rate would have left it more than 2 ms ahead
+  int64_t error = params.ns + detail::TscScale(tsc - params.tsc, params.mult) -
+                  tsc;
+  EXPECT_LE(std::abs(error), 100000);
+}
+
+TEST(TimestampTest, SetNowImpl) {
+  SetNowImpl(NowTsc);
+  uint64_t before = NowDefault();
+  uint64_t now = Now();
+  uint64_t after = NowDefault();
+  EXPECT_GE(now, before - kTolerance);
+  EXPECT_LE(now, after + kTolerance);
+  SetNowImpl(nullptr);
+  before = NowDefault();
+  now = Now();
+  after = NowDefault();
+  EXPECT_GE(now, before);
+  EXPECT_LE(now, after);
+}
+
+}  // namespace wpi
@@ -0,0 +1,122 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#define WPI_ENABLE_TRACING
+#include "support/Trace.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "support/json.h"
+
+namespace wpi {
+
+namespace {
+
+void Inner() { WPI_TRACE_SCOPE("inner"); }
+
+void Outer() {
+  WPI_TRACE_SCOPE("outer");
+  Inner();
+  Inner();
+}
+
+}  // namespace
+
+TEST(TraceTest, NotRecording) {
+  EXPECT_FALSE(IsTraceRecording());
+  Outer();  // must not create output anywhere
+
+  std::string out;
+  {
+    llvm::raw_string_ostream os(out);
+    TraceRecorder recorder(os);
+    ASSERT_TRUE(recorder.Start());
+    recorder.Stop();
+  }
+  json trace = json::parse(out);
+  EXPECT_TRUE(trace["traceEvents"].empty());
+}
+
+TEST(TraceTest, ChromeJson) {
+  std::string out;
+  {
+    llvm::raw_string_ostream os(out);
+    TraceRecorder recorder(os);
+    ASSERT_TRUE(recorder.Start());
+    Outer();
+    std::thread thr(Outer);
+    thr.join();
+    recorder.Stop();
+    EXPECT_FALSE(IsTraceRecording());
+    EXPECT_EQ(0u, recorder.GetDropped());
+  }
+
+  json trace = json::parse(out);
+  auto& events = trace["traceEvents"];
+  ASSERT_EQ(6u, events.size());
+  std::map<std::string, int> names;
+  std::map<int, uint64_t> outerEnd;
+  for (auto& event : events) {
+    EXPECT_EQ("X", event["ph"].get<std::string>());
+    names[event["name"].get<std::string>()]++;
+    if (event["name"] == "outer") {
+      outerEnd[event["tid"].get<int>()] =
+          event["ts"].get<uint64_t>() + event["dur"].get<uint64_t>();
+    }
+  }
+  EXPECT_EQ(2, names["outer"]);
+  EXPECT_EQ(4, names["inner"]);
+  EXPECT_EQ(2u, outerEnd.size());  // one per thread
+  for (auto& event : events) {
+    if (event["name"] != "inner") continue;
+    // nested within the outer span of the same thread
+    EXPECT_LE(event["ts"].get<uint64_t>() + event["dur"].get<uint64_t>(),
+              outerEnd[event["tid"].get<int>()]);
+  }
+}
+
+TEST(TraceTest, OneRecorder) {
+  std::string out1, out2;
+  llvm::raw_string_ostream os1(out1), os2(out2);
+  TraceRecorder recorder1(os1);
+  TraceRecorder recorder2(os2);
+  EXPECT_TRUE(recorder1.Start());
+  EXPECT_FALSE(recorder1.Start());
+  EXPECT_FALSE(recorder2.Start());
+  recorder1.Stop();
+  EXPECT_TRUE(recorder2.Start());
+  recorder2.Stop();
+}
+
+TEST(TraceTest, RingFull) {
+  std::string out;
+  uint64_t dropped;
+  {
+    llvm::raw_string_ostream os(out);
+    TraceRecorder::Options options;
+    options.ringCapacity = 16;
+    options.exportInterval = std::chrono::hours(1);
+    TraceRecorder recorder(os, options);
+    ASSERT_TRUE(recorder.Start());
+    // a new thread gets a ring with the configured capacity
+    std::thread thr([] {
+      for (int i = 0; i < 100; ++i) WPI_TRACE_SCOPE("span");
+    });
+    thr.join();
+    recorder.Stop();
+    dropped = recorder.GetDropped();
+  }
+  json trace = json::parse(out);
+  EXPECT_GT(dropped, 0u);
+  EXPECT_EQ(100u, trace["traceEvents"].size() + dropped);
+}
+
+}  // namespace wpi
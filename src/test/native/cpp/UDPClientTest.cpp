@@ -0,0 +1,84 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "udpsockets/UDPClient.h"  // NOLINT(build/include_order)
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "support/Logger.h"
+
+namespace wpi {
+
+TEST(UDPClientTest, SendReceive) {
+  Logger logger;
+  UDPClient server("127.0.0.1", logger);
+  ASSERT_EQ(server.start(39460), 0);
+  UDPClient client("127.0.0.1", logger);
+  ASSERT_EQ(client.start(), 0);
+
+  auto dest = client.resolve("127.0.0.1", 39460);
+  ASSERT_TRUE(dest);
+  EXPECT_EQ(dest.getPort(), 39460);
+  ASSERT_EQ(client.send(llvm::StringRef("hello"), dest), 5);
+
+  char buf[16];
+  UDPClient::Destination source;
+  ASSERT_EQ(server.receive(buf, &source), 5);
+  EXPECT_EQ(llvm::StringRef(buf, 5), "hello");
+  EXPECT_EQ(source.getHost(), "127.0.0.1");
+
+  // reply to the sender
+  ASSERT_EQ(server.send(llvm::StringRef("ack"), source), 3);
+  ASSERT_EQ(client.receive(buf), 3);
+  EXPECT_EQ(llvm::StringRef(buf, 3), "ack");
+}
+
+TEST(UDPClientTest, Batch) {
+  Logger logger;
+  UDPClient server("127.0.0.1", logger);
+  ASSERT_EQ(server.start(39461), 0);
+  UDPClient client("127.0.0.1", logger);
+  ASSERT_EQ(client.start(), 0);
+
+  std::vector<std::string> sent;
+  for (int i = 0; i < 40; ++i) sent.push_back("datagram " + std::to_string(i));
+  std::vector<llvm::StringRef> datagrams(sent.begin(), sent.end());
+  ASSERT_EQ(client.sendBatch(datagrams, client.resolve("127.0.0.1", 39461)),
+            40);
+
+  char storage[16][32];
+  std::vector<llvm::MutableArrayRef<char>> bufs;
+  for (auto& buf : storage) bufs.emplace_back(buf);
+  size_t lens[16];
+  UDPClient::Destination sources[16];
+  std::vector<std::string> received;
+  while (received.size() < sent.size()) {
+    int count = server.receiveBatch(bufs, lens, sources);
+    ASSERT_GT(count, 0);
+    for (int i = 0; i < count; ++i) {
+      received.emplace_back(storage[i], lens[i]);
+      EXPECT_EQ(sources[i].getHost(), "127.0.0.1");
+    }
+  }
+  EXPECT_EQ(received, sent);
+}
+
+TEST(UDPClientTest, InvalidDestination) {
+  Logger logger;
+  UDPClient client(logger);
+  ASSERT_EQ(client.start(), 0);
+  EXPECT_FALSE(client.resolve("localhost", 39462));
+  EXPECT_FALSE(client.resolve("", 39462));
+  UDPClient::Destination dest;
+  EXPECT_EQ(client.send(llvm::StringRef("x"), dest), -1);
+  llvm::StringRef datagrams[] = {"a", "b"};
+  EXPECT_EQ(client.sendBatch(datagrams, dest), -1);
+}
+
+}  // namespace wpi
@@ -0,0 +1,71 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/UidVector.h"  // NOLINT(build/include_order)
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(UidVectorTest, ReuseFifo) {
+  UidVector<std::string, 2> vec;
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(size_t(i), vec.emplace_back("x"));
+  vec.erase(3);
+  vec.erase(1);
+  EXPECT_EQ(3u, vec.active_count());
+  EXPECT_FALSE(vec.contains(1));
+
+  // freelist reaches the threshold; slots come back oldest first
+  vec.erase(4);
+  EXPECT_EQ(3u, vec.emplace_back("a"));
+  EXPECT_EQ(1u, vec.emplace_back("b"));
+  EXPECT_EQ(5u, vec.emplace_back("c"));
+  EXPECT_EQ("a", vec[3]);
+  EXPECT_EQ(6u, vec.size());
+}
+
+TEST(UidVectorTest, NonBooleanElements) {
+  // erase() no longer relies on T being convertible to bool
+  UidVector<int, 0> vec;
+  auto a = vec.emplace_back(0);
+  vec.erase(a);
+  vec.erase(a);  // double erase is ignored
+  EXPECT_TRUE(vec.empty());
+  EXPECT_EQ(a, vec.emplace_back(7));
+  EXPECT_EQ(7, vec[a]);
+}
+
+TEST(UidVectorTest, IterateLive) {
+  UidVector<std::shared_ptr<int>, 10> vec;
+  for (int i = 0; i < 6; ++i) vec.emplace_back(std::make_shared<int>(i));
+  vec.erase(0);
+  vec.erase(2);
+  vec.erase(5);
+
+  std::vector<int> values;
+  std::vector<size_t> uids;
+  for (auto it = vec.begin(); it != vec.end(); ++it) {
+    values.push_back(**it);
+    uids.push_back(it.uid());
+  }
+  EXPECT_EQ((std::vector<int>{1, 3, 4}), values);
+  EXPECT_EQ((std::vector<size_t>{1, 3, 4}), uids);
+
+  const auto& cvec = vec;
+  int sum = 0;
+  for (const auto& v : cvec) sum += *v;
+  EXPECT_EQ(8, sum);
+
+  vec.clear();
+  EXPECT_TRUE(vec.begin() == vec.end());
+}
+
+}  // namespace wpi
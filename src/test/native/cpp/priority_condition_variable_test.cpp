@@ -8,6 +8,12 @@
 #include <support/priority_condition_variable.h>
 #include <support/priority_mutex.h>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -288,13 +294,34 @@ TEST_F(ConditionVariableTest, NativeHandle) {
 
   StartThreads(wait);
 
-  pthread_cond_t* native_handle = m_cond.native_handle();
-  pthread_cond_broadcast(native_handle);
+  // the native handle is the futex word waiters sleep on
+  auto native_handle = m_cond.native_handle();
+  ++*native_handle;
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(native_handle),
+          FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
   ShortSleep();
   EXPECT_TRUE(m_done1) << "watcher1 failed to be notified.";
   EXPECT_TRUE(m_done2) << "watcher2 failed to be notified.";
 }
 
+TEST(PriorityConditionVariableTest, SteadyClockTimeout) {
+  priority_condition_variable cond;
+  priority_mutex mutex;
+  std::unique_lock<priority_mutex> lock(mutex);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(std::cv_status::timeout,
+            cond.wait_until(lock, start + std::chrono::milliseconds(20)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+  EXPECT_TRUE(lock.owns_lock());
+
+  // deadlines already in the past time out immediately
+  EXPECT_EQ(std::cv_status::timeout,
+            cond.wait_until(lock, start - std::chrono::seconds(1)));
+  EXPECT_EQ(std::cv_status::timeout,
+            cond.wait_for(lock, std::chrono::milliseconds(-5)));
+}
+
 #endif  // WPI_HAVE_PRIORITY_CONDITION_VARIABLE
 
 }  // namespace wpi
@@ -7,9 +7,16 @@
 
 #include <support/priority_mutex.h>  // NOLINT(build/include_order)
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include <atomic>
 #include <condition_variable>
 #include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -266,6 +273,78 @@ TEST(MutexTest, ReentrantTryLock) {
   EXPECT_TRUE(m.try_lock());
 }
 
+// Smoke test to make sure that nested locks are counted.
+TEST(MutexTest, ReentrantCount) {
+  priority_recursive_mutex m;
+  m.lock();
+  m.lock();
+  m.unlock();
+  bool acquired = true;
+  std::thread other([&] { acquired = m.try_lock(); });
+  other.join();
+  EXPECT_FALSE(acquired) << "Mutex should still be held once.";
+  m.unlock();
+  other = std::thread([&] {
+    acquired = m.try_lock();
+    if (acquired) m.unlock();
+  });
+  other.join();
+  EXPECT_TRUE(acquired);
+}
+
+// Hammers a mutex from several threads so lock and unlock go through the
+// kernel (FUTEX_LOCK_PI/FUTEX_UNLOCK_PI) as well as the userspace fast path.
+TEST(MutexTest, Contended) {
+  static constexpr int kThreads = 4;
+  static constexpr int kIterations = 20000;
+  priority_mutex m;
+  int count = 0;
+
+  ResetPriorityMutexStats();
+  SetPriorityMutexStatsEnabled(true);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kIterations; ++j) {
+        std::lock_guard<priority_mutex> lock(m);
+        ++count;
+        if (j % 100 == 0) std::this_thread::yield();  // force some contention
+      }
+    });
+  }
+  for (auto& thr : threads) thr.join();
+  SetPriorityMutexStatsEnabled(false);
+
+  EXPECT_EQ(kThreads * kIterations, count);
+  auto stats = GetPriorityMutexStats();
+  EXPECT_GT(stats.contended, 0u);
+  EXPECT_EQ(stats.contended, stats.spin_acquired + stats.sleeps);
+  EXPECT_TRUE(m.try_lock());
+  m.unlock();
+}
+
+TEST(MutexTest, ForkChild) {
+  priority_mutex m;
+  m.lock();  // cache this thread's tid
+  m.unlock();
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // the child must lock with its own tid and be able to unlock
+    m.lock();
+    uint32_t owner = m.native_handle()->load() & detail::kFutexTidMask;
+    bool ok = owner == static_cast<uint32_t>(syscall(SYS_gettid));
+    m.unlock();
+    ok = ok && m.native_handle()->load() == 0;
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
 #endif  // WPI_HAVE_PRIORITY_MUTEX
 
 }  // namespace wpi
@@ -0,0 +1,119 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/raw_socket_istream.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "llvm/SmallString.h"
+#include "tcpsockets/NetworkStream.h"
+
+namespace wpi {
+
+namespace {
+
+// Serves data from a string, at most maxReceive bytes per receive().
+class StringStream : public NetworkStream {
+ public:
+  StringStream(llvm::StringRef data, size_t maxReceive)
+      : m_data(data), m_maxReceive(maxReceive) {}
+
+  size_t send(const char*, size_t, Error* err) override {
+    *err = kConnectionClosed;
+    return 0;
+  }
+  size_t receive(char* buffer, size_t len, Error* err, int) override {
+    ++receives;
+    lastLen = len;
+    size_t count = std::min({len, m_maxReceive, m_data.size() - m_pos});
+    if (count == 0) {
+      *err = kConnectionClosed;
+      return 0;
+    }
+    std::memcpy(buffer, m_data.data() + m_pos, count);
+    m_pos += count;
+    return count;
+  }
+  void close() override {}
+  llvm::StringRef getPeerIP() const override { return ""; }
+  int getPeerPort() const override { return 0; }
+  void setNoDelay() override {}
+  bool setBlocking(bool) override { return true; }
+  int getNativeHandle() const override { return -1; }
+
+  int receives = 0;
+  size_t lastLen = 0;
+
+ private:
+  std::string m_data;
+  size_t m_maxReceive;
+  size_t m_pos = 0;
+};
+
+}  // namespace
+
+TEST(RawSocketIstreamTest, GetlineUsesBuffer) {
+  StringStream stream("GET / HTTP/1.1\r\nHost: x\r\n\r\n", 1000);
+  raw_socket_istream is(stream);
+  llvm::SmallString<64> buf;
+  EXPECT_EQ(is.getline(buf, 1024), "GET / HTTP/1.1\n");
+  EXPECT_EQ(is.in_avail(), 11u);
+  EXPECT_EQ(is.getline(buf, 1024), "Host: x\n");
+  EXPECT_EQ(is.getline(buf, 1024), "\n");
+  EXPECT_FALSE(is.has_error());
+  EXPECT_EQ(stream.receives, 1);
+  EXPECT_EQ(is.in_avail(), 0u);
+}
+
+TEST(RawSocketIstreamTest, ReadAcrossReceives) {
+  StringStream stream("abcdefghij", 3);
+  raw_socket_istream is(stream, 0, 4);
+  char buf[7];
+  is.read(buf, 7);
+  EXPECT_FALSE(is.has_error());
+  EXPECT_EQ(llvm::StringRef(buf, 7), "abcdefg");
+  EXPECT_EQ(is.readsome(buf, 7), 2u);  // buffered "hi"
+  EXPECT_EQ(llvm::StringRef(buf, 2), "hi");
+  is.read(buf, 2);
+  EXPECT_TRUE(is.has_error());
+}
+
+TEST(RawSocketIstreamTest, LargeReadBypassesBuffer) {
+  std::string data(100, 'x');
+  StringStream stream(data, 1000);
+  raw_socket_istream is(stream, 0, 16);
+  char buf[64];
+  is.read(buf, 64);
+  EXPECT_FALSE(is.has_error());
+  EXPECT_EQ(stream.lastLen, 64u);
+  EXPECT_EQ(is.in_avail(), 0u);
+}
+
+TEST(RawSocketIstreamTest, PeekConsume) {
+  StringStream stream("hello world", 5);
+  raw_socket_istream is(stream);
+  EXPECT_EQ(is.peek(), "hello");
+  EXPECT_EQ(is.peek(), "hello");
+  EXPECT_EQ(stream.receives, 1);
+  is.consume(3);
+  EXPECT_EQ(is.peek(), "lo");
+  is.consume(2);
+  EXPECT_EQ(is.peek(), " worl");
+  char c;
+  is.read(c);
+  EXPECT_EQ(c, ' ');
+  is.consume(4);
+  EXPECT_EQ(is.peek(), "d");
+  is.consume(1);
+  EXPECT_EQ(is.peek(), "");
+  EXPECT_TRUE(is.has_error());
+}
+
+}  // namespace wpi
@@ -0,0 +1,96 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "support/shared_mutex.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(SharedMutexTest, TryLock) {
+  shared_mutex m;
+  {
+    shared_lock<shared_mutex> reader(m);
+    EXPECT_TRUE(reader.owns_lock());
+    EXPECT_FALSE(m.try_lock());
+
+    // other readers are admitted
+    bool acquired = false;
+    std::thread other([&] {
+      acquired = m.try_lock_shared();
+      if (acquired) m.unlock_shared();
+    });
+    other.join();
+    EXPECT_TRUE(acquired);
+  }
+
+  ASSERT_TRUE(m.try_lock());
+  bool acquired = true;
+  std::thread other([&] {
+    shared_lock<shared_mutex> reader(m, std::try_to_lock);
+    acquired = reader.owns_lock();
+  });
+  other.join();
+  EXPECT_FALSE(acquired);
+  m.unlock();
+}
+
+TEST(SharedMutexTest, WriterWaitsForReaders) {
+  shared_mutex m;
+  std::atomic<bool> readerDone{false};
+  std::atomic<bool> writerDone{false};
+
+  m.lock_shared();
+  std::thread writer([&] {
+    std::lock_guard<shared_mutex> lock(m);
+    EXPECT_TRUE(readerDone);
+    writerDone = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(writerDone);
+  readerDone = true;
+  m.unlock_shared();
+  writer.join();
+  EXPECT_TRUE(writerDone);
+}
+
+TEST(SharedMutexTest, Consistency) {
+  static constexpr int kReaders = 4;
+  static constexpr int kWrites = 200;
+  shared_mutex m;
+  // the writer keeps a == b; readers must never see them differ
+  int a = 0;
+  int b = 0;
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < kReaders; ++i) {
+    readers.emplace_back([&] {
+      while (!done) {
+        shared_lock<shared_mutex> lock(m);
+        if (a != b) ++torn;
+      }
+    });
+  }
+  for (int i = 0; i < kWrites; ++i) {
+    std::lock_guard<shared_mutex> lock(m);
+    ++a;
+    std::this_thread::yield();
+    ++b;
+  }
+  done = true;
+  for (auto& thr : readers) thr.join();
+  EXPECT_EQ(0, torn);
+  EXPECT_EQ(kWrites, b);
+}
+
+}  // namespace wpi